@@ -0,0 +1,234 @@
+/*
+* MIT License
+*
+* Copyright (c) 2021 ApiGear
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#include "olink/core/compressedcodec.h"
+#include "olink/core/messagecodec.h"
+#include "olink/core/protocol.h"
+#include "olink/core/typedarray.h"
+#include "olink/core/types.h"
+#include "olink/core/wirecapture.h"
+#ifdef OLINK_SIMDJSON
+#include "olink/core/simdjsoncodec.h"
+#endif
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+* olink_codec_bench compares the message codecs: encode and decode time per message and encoded size,
+* for messages typical for the protocol. Build with BUILD_BENCHMARKS=ON.
+* Usage: olink_codec_bench [iterations] [capture file]
+* With a capture file written by WireCapture the JSON frames recorded in it are decoded as well,
+* with each codec for the JSON format, e.g. to compare the simdjson codec (OLINK_SIMDJSON=ON) on real payloads.
+*/
+
+using namespace ApiGear::ObjectLink;
+
+namespace {
+
+struct Sample
+{
+    std::string name;
+    nlohmann::json message;
+    /** Holds typed arrays, which JSON can not reproduce. */
+    bool binaryOnly = false;
+};
+
+struct NamedCodec
+{
+    std::string name;
+    std::shared_ptr<IMessageCodec> codec;
+};
+
+std::vector<Sample> samples()
+{
+    nlohmann::json record = {
+        { "id", 1234 }, { "name", "temperature sensor" }, { "value", 21.5 }, { "valid", true },
+        { "tags", { "kitchen", "ground floor" } }
+    };
+    nlohmann::json props = nlohmann::json::object();
+    for (int i = 0; i < 50; ++i) {
+        props["property" + std::to_string(i)] = record;
+    }
+    std::vector<std::uint8_t> blob(64 * 1024);
+    for (std::size_t i = 0; i < blob.size(); ++i) {
+        blob[i] = static_cast<std::uint8_t>(i * 7);
+    }
+    nlohmann::json values = nlohmann::json::array();
+    std::vector<double> doubles;
+    for (int i = 0; i < 1000; ++i) {
+        values.push_back(i * 0.5);
+        doubles.push_back(i * 0.5);
+    }
+    return {
+        { "property change int", Protocol::propertyChangeMessage("org.demo.Counter/count", 42) },
+        { "signal struct", Protocol::signalMessage("org.demo.Sensor/measured", nlohmann::json::array({ record })) },
+        { "invoke args", Protocol::invokeMessage(17, "org.demo.Calc/add", nlohmann::json::array({ 1, 2.5, "three" })) },
+        { "init 50 structs", Protocol::initMessage("org.demo.Sensors", props) },
+        { "property 1000 doubles", Protocol::propertyChangeMessage("org.demo.Chart/values", values) },
+        { "typed 1000 doubles", Protocol::propertyChangeMessage("org.demo.Chart/values", makeTypedArray(doubles)), true },
+        { "64 KiB byte array", Protocol::propertyChangeMessage("org.demo.Camera/thumbnail", blob) },
+        { "64 KiB blob", Protocol::propertyChangeMessage("org.demo.Camera/thumbnail", nlohmann::json::binary(blob)), true },
+    };
+}
+
+double nsPerOperation(std::chrono::steady_clock::duration duration, int iterations)
+{
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()) / iterations;
+}
+
+/**
+* Decodes all JSON frames of a capture file with every JSON codec, repeated until about the given number of messages is decoded.
+* @return false if the file can not be read or a codec decodes a frame differently from the first codec.
+*/
+bool decodeCapture(const std::string& path, const std::vector<NamedCodec>& codecs, int iterations)
+{
+    WireCaptureReader reader;
+    if (!reader.open(path)) {
+        std::cerr << "can not read capture file " << path << "\n";
+        return false;
+    }
+    std::vector<std::string> frames;
+    std::size_t bytes = 0;
+    CapturedFrame frame;
+    while (reader.next(frame)) {
+        if (frame.format == MessageFormat::JSON) {
+            frames.emplace_back(frame.data, frame.size);
+            bytes += frame.size;
+        }
+    }
+    std::cout << "\ncapture " << path << ": " << frames.size() << " JSON frames, " << bytes << " bytes\n";
+    if (frames.empty()) {
+        return true;
+    }
+    const int rounds = std::max<int>(1, iterations / static_cast<int>(std::min<std::size_t>(frames.size(), iterations)));
+    std::cout << std::left << std::setw(11) << "codec" << std::right << std::setw(13) << "decode ns" << std::setw(13) << "decode MB/s" << "\n";
+    std::vector<nlohmann::json> reference;
+    for (const auto& named : codecs) {
+        if (named.codec->format() != MessageFormat::JSON) {
+            continue;
+        }
+        nlohmann::json decoded;
+        auto start = std::chrono::steady_clock::now();
+        for (int round = 0; round < rounds; ++round) {
+            for (const auto& data : frames) {
+                named.codec->decode(data.data(), data.size(), decoded, false);
+            }
+        }
+        const auto decodeNs = nsPerOperation(std::chrono::steady_clock::now() - start, rounds * static_cast<int>(frames.size()));
+        for (std::size_t i = 0; i < frames.size(); ++i) {
+            named.codec->decode(frames[i].data(), frames[i].size(), decoded, false);
+            if (reference.size() < frames.size()) {
+                reference.push_back(std::move(decoded));
+            } else if (decoded != reference[i]) {
+                std::cerr << named.name << " decodes frame " << i << " differently\n";
+                return false;
+            }
+        }
+        const auto averageBytes = static_cast<double>(bytes) / frames.size();
+        std::cout << std::left << std::setw(11) << named.name << std::right
+            << std::fixed << std::setprecision(0) << std::setw(13) << decodeNs
+            << std::setprecision(1) << std::setw(13) << (decodeNs > 0.0 ? averageBytes * 1000.0 / decodeNs : 0.0) << "\n";
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    int iterations = 20000;
+    if (argc > 1) {
+        iterations = std::max(1, std::atoi(argv[1]));
+    }
+    // BSON can not encode the top level array every message is made of.
+    std::vector<NamedCodec> codecs = {
+        { "json", IMessageCodec::create(MessageFormat::JSON) },
+        { "msgpack", IMessageCodec::create(MessageFormat::MSGPACK) },
+        { "cbor", IMessageCodec::create(MessageFormat::CBOR) },
+#ifdef OLINK_SIMDJSON
+        { "simdjson", std::make_shared<SimdJsonCodec>() },
+#endif
+    };
+    // compression of the JSON frames, for the algorithms olink_core was built with
+    for (auto algorithm : { Compression::LZ4, Compression::Zstd }) {
+        CompressionOptions options;
+        options.algorithm = algorithm;
+        auto compressed = CompressedCodec::create(IMessageCodec::create(MessageFormat::JSON), options);
+        if (compressed) {
+            codecs.push_back({ algorithm == Compression::LZ4 ? "json+lz4" : "json+zstd", compressed });
+        }
+    }
+#ifdef OLINK_SIMDJSON
+    std::cout << "simdjson implementation: " << SimdJsonCodec::implementation() << "\n";
+#endif
+    std::cout << "iterations: " << iterations << " (small messages), " << std::max(1, iterations / 100) << " (large messages)\n";
+    std::cout << std::left << std::setw(24) << "message" << std::setw(11) << "codec"
+        << std::right << std::setw(9) << "bytes" << std::setw(13) << "encode ns" << std::setw(13) << "decode ns"
+        << std::setw(13) << "decode MB/s" << "\n";
+    for (const auto& sample : samples()) {
+        const auto dumped = sample.message.dump();
+        const int runs = dumped.size() > 4096 ? std::max(1, iterations / 100) : iterations;
+        for (const auto& named : codecs) {
+            if (sample.binaryOnly && named.codec->format() == MessageFormat::JSON) {
+                continue;
+            }
+            std::string data;
+            named.codec->encode(sample.message, data);
+
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < runs; ++i) {
+                named.codec->encode(sample.message, data);
+            }
+            const auto encodeNs = nsPerOperation(std::chrono::steady_clock::now() - start, runs);
+
+            nlohmann::json decoded;
+            start = std::chrono::steady_clock::now();
+            for (int i = 0; i < runs; ++i) {
+                named.codec->decode(data.data(), data.size(), decoded, false);
+            }
+            const auto decodeNs = nsPerOperation(std::chrono::steady_clock::now() - start, runs);
+            if (decoded != sample.message) {
+                std::cerr << named.name << " does not reproduce " << sample.name << "\n";
+                return 1;
+            }
+            std::cout << std::left << std::setw(24) << sample.name << std::setw(11) << named.name
+                << std::right << std::setw(9) << data.size()
+                << std::fixed << std::setprecision(0) << std::setw(13) << encodeNs << std::setw(13) << decodeNs
+                << std::setprecision(1) << std::setw(13) << (decodeNs > 0.0 ? static_cast<double>(data.size()) * 1000.0 / decodeNs : 0.0)
+                << "\n";
+        }
+    }
+    if (argc > 2 && !decodeCapture(argv[2], codecs, iterations)) {
+        return 1;
+    }
+    return 0;
+}
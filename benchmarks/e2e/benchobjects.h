@@ -0,0 +1,167 @@
+/*
+* MIT License
+*
+* Copyright (c) 2021 ApiGear
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#pragma once
+
+#include "olink/clientnode.h"
+#include "olink/iobjectsink.h"
+#include "olink/iobjectsource.h"
+#include "olink/iremotenode.h"
+#include "olink/remoteregistry.h"
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Bench {
+
+/** @return current time of a steady clock in nanoseconds, used as timestamp carried in messages. */
+inline std::int64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+* Collects latency samples from many threads without locking.
+* Samples above the capacity are counted but not stored.
+*/
+class LatencyRecorder
+{
+public:
+    void reset(std::size_t capacity)
+    {
+        m_samples.assign(capacity, 0);
+        m_count = 0;
+    }
+    void record(std::int64_t latency)
+    {
+        const auto index = m_count.fetch_add(1, std::memory_order_relaxed);
+        if (index < m_samples.size()) {
+            m_samples[index] = latency;
+        }
+    }
+    std::size_t count() const
+    {
+        return m_count.load(std::memory_order_acquire);
+    }
+    std::vector<std::int64_t> samples() const
+    {
+        const auto stored = std::min(count(), m_samples.size());
+        return std::vector<std::int64_t>(m_samples.begin(), m_samples.begin() + stored);
+    }
+private:
+    std::vector<std::int64_t> m_samples;
+    std::atomic<std::size_t> m_count{ 0 };
+};
+
+/**
+* Sink which records the latency of every property change, the value carries the send timestamp in "t" field.
+*/
+class BenchSink : public ApiGear::ObjectLink::IObjectSink
+{
+public:
+    BenchSink(const std::string& objectId, LatencyRecorder& recorder)
+        : m_objectId(objectId)
+        , m_recorder(recorder)
+    {}
+    std::string olinkObjectName() override
+    {
+        return m_objectId;
+    }
+    void olinkOnSignal(const std::string&, const nlohmann::json&) override
+    {
+    }
+    void olinkOnPropertyChanged(const std::string&, const nlohmann::json& value) override
+    {
+        m_recorder.record(now() - value["t"].get<std::int64_t>());
+    }
+    void olinkOnInit(const std::string&, const nlohmann::json&, ApiGear::ObjectLink::IClientNode*) override
+    {
+        m_ready = true;
+    }
+    void olinkOnRelease() override
+    {
+        m_ready = false;
+    }
+    bool isReady() const
+    {
+        return m_ready;
+    }
+private:
+    std::string m_objectId;
+    LatencyRecorder& m_recorder;
+    std::atomic<bool> m_ready{ false };
+};
+
+/**
+* Source which echoes invoke arguments and broadcasts every requested property value to all linked nodes.
+*/
+class BenchSource : public ApiGear::ObjectLink::IObjectSource
+{
+public:
+    BenchSource(const std::string& objectId, ApiGear::ObjectLink::RemoteRegistry& registry)
+        : m_objectId(objectId)
+        , m_registry(registry)
+    {}
+    std::string olinkObjectName() override
+    {
+        return m_objectId;
+    }
+    nlohmann::json olinkInvoke(const std::string&, const nlohmann::json& args) override
+    {
+        return args;
+    }
+    void olinkSetProperty(const std::string& propertyId, const nlohmann::json& value) override
+    {
+        notifyPropertyChange(propertyId, value);
+    }
+    void olinkLinked(const std::string&, ApiGear::ObjectLink::IRemoteNode*) override
+    {
+    }
+    void olinkUnlinked(const std::string&) override
+    {
+    }
+    nlohmann::json olinkCollectProperties() override
+    {
+        return { { "value", 0 } };
+    }
+    /** Sends the property change to every linked node, the way generated sources do. */
+    void notifyPropertyChange(const std::string& propertyId, const nlohmann::json& value)
+    {
+        for (auto& node : m_registry.getNodes(m_objectId)) {
+            auto lockedNode = node.lock();
+            if (lockedNode) {
+                lockedNode->notifyPropertyChange(propertyId, value);
+            }
+        }
+    }
+private:
+    std::string m_objectId;
+    ApiGear::ObjectLink::RemoteRegistry& m_registry;
+};
+
+} // namespace Bench
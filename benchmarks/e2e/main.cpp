@@ -0,0 +1,497 @@
+/*
+* MIT License
+*
+* Copyright (c) 2021 ApiGear
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "allocationcounter.h"
+#include "benchobjects.h"
+#include "transport.h"
+
+#include "olink/clientnode.h"
+#include "olink/clientregistry.h"
+#include "olink/remotenode.h"
+#include "olink/remoteregistry.h"
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef OLINK_BENCH_HAS_SOCKETPAIR
+#include <csignal>
+#endif
+
+using namespace ApiGear::ObjectLink;
+
+namespace {
+
+const std::string fanoutWorkload = "fanout";
+const std::string invokeWorkload = "invoke";
+const std::string setWorkload = "set";
+const std::string inProcessTransport = "inproc";
+const std::string socketPairTransport = "socketpair";
+
+struct Options
+{
+    int clients = 4;
+    int objects = 4;
+    int messages = 20000;
+    int payloadSize = 16;
+    double timeoutSeconds = 60.0;
+    std::vector<MessageFormat> formats = { MessageFormat::JSON, MessageFormat::MSGPACK, MessageFormat::CBOR };
+    std::vector<std::string> transports = { inProcessTransport, socketPairTransport };
+    std::vector<std::string> workloads = { fanoutWorkload, invokeWorkload, setWorkload };
+};
+
+struct Result
+{
+    std::size_t delivered = 0;
+    double seconds = 0.0;
+    bool completed = false;
+    /** Heap allocations of all threads during the run, including the benchmark's own. */
+    std::uint64_t allocations = 0;
+    std::vector<std::int64_t> latencies;
+};
+
+std::string formatName(MessageFormat format)
+{
+    switch (format) {
+    case MessageFormat::JSON: return "json";
+    case MessageFormat::BSON: return "bson";
+    case MessageFormat::MSGPACK: return "msgpack";
+    case MessageFormat::CBOR: return "cbor";
+    }
+    return "unknown";
+}
+
+std::vector<std::string> split(const std::string& list)
+{
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+void printUsage()
+{
+    std::cout << "usage: olink_e2e_bench [options]\n"
+        << "  --clients N        number of client connections (default 4)\n"
+        << "  --objects M        number of objects each client links (default 4)\n"
+        << "  --messages K       messages sent per workload (default 20000)\n"
+        << "  --payload BYTES    size of the string payload carried by each message (default 16)\n"
+        << "  --formats LIST     comma separated: json,msgpack,cbor (default all)\n"
+        << "  --transports LIST  comma separated: inproc,socketpair (default all available)\n"
+        << "  --workloads LIST   comma separated: fanout,invoke,set (default all)\n"
+        << "  --timeout SECONDS  time to wait for all deliveries of one run (default 60)\n";
+}
+
+bool parseOptions(int argc, char* argv[], Options& options)
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage();
+            return false;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "missing value for " << arg << "\n";
+            return false;
+        }
+        const std::string value = argv[++i];
+        if (arg == "--clients") {
+            options.clients = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--objects") {
+            options.objects = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--messages") {
+            options.messages = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--payload") {
+            options.payloadSize = std::max(0, std::atoi(value.c_str()));
+        } else if (arg == "--timeout") {
+            options.timeoutSeconds = std::atof(value.c_str());
+        } else if (arg == "--formats") {
+            options.formats.clear();
+            for (const auto& name : split(value)) {
+                if (name == "json") {
+                    options.formats.push_back(MessageFormat::JSON);
+                } else if (name == "msgpack") {
+                    options.formats.push_back(MessageFormat::MSGPACK);
+                } else if (name == "cbor") {
+                    options.formats.push_back(MessageFormat::CBOR);
+                } else {
+                    // BSON can not encode the top level array every message is made of.
+                    std::cerr << "unsupported format " << name << "\n";
+                    return false;
+                }
+            }
+        } else if (arg == "--transports") {
+            options.transports = split(value);
+        } else if (arg == "--workloads") {
+            options.workloads = split(value);
+        } else {
+            std::cerr << "unknown option " << arg << "\n";
+            printUsage();
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Waits until condition is met or the timeout passes. @return true if condition was met. */
+bool waitFor(const std::function<bool()>& condition, double timeoutSeconds)
+{
+    const auto deadline = std::chrono::steady_clock::now()
+        + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(timeoutSeconds));
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+/** One client connection: its own registry with a sink for every object, a client node and the server side remote node. */
+struct Client
+{
+    std::unique_ptr<ClientRegistry> registry;
+    std::vector<std::shared_ptr<Bench::BenchSink>> sinks;
+    std::shared_ptr<ClientNode> node;
+    std::shared_ptr<RemoteNode> remote;
+    std::unique_ptr<Bench::Link> link;
+};
+
+/**
+* Sets up M sources and N connected clients, each client links all the objects.
+* Tears everything down in the order required by the nodes on destruction.
+*/
+class Setup
+{
+public:
+    Setup(const Options& options, MessageFormat format, const std::string& transport, Bench::LatencyRecorder& recorder)
+    {
+        for (int objectIndex = 0; objectIndex < options.objects; ++objectIndex) {
+            auto objectId = "bench.Object" + std::to_string(objectIndex);
+            m_objectIds.push_back(objectId);
+            m_sources.push_back(std::make_shared<Bench::BenchSource>(objectId, m_registry));
+            m_registry.addSource(m_sources.back());
+        }
+        for (int clientIndex = 0; clientIndex < options.clients; ++clientIndex) {
+            m_clients.emplace_back();
+            auto& client = m_clients.back();
+            client.registry.reset(new ClientRegistry());
+            for (const auto& objectId : m_objectIds) {
+                client.sinks.push_back(std::make_shared<Bench::BenchSink>(objectId, recorder));
+                client.registry->addSink(client.sinks.back());
+            }
+            client.node = ClientNode::create(*client.registry);
+            client.remote = RemoteNode::createRemoteNode(m_registry);
+            client.node->setMessageFormat(format);
+            client.remote->setMessageFormat(format);
+#ifdef OLINK_BENCH_HAS_SOCKETPAIR
+            if (transport == socketPairTransport) {
+                std::unique_ptr<Bench::SocketPairLink> link(new Bench::SocketPairLink(*client.node, *client.remote));
+                if (link->isOpen()) {
+                    client.link = std::move(link);
+                }
+            } else
+#endif
+            {
+                (void)transport;
+                client.link.reset(new Bench::InProcessLink(*client.node, *client.remote));
+            }
+        }
+    }
+    ~Setup()
+    {
+        for (auto& client : m_clients) {
+            if (client.link) {
+                client.link->close();
+            }
+        }
+        for (auto& client : m_clients) {
+            client.node.reset();
+            client.remote.reset();
+        }
+        for (const auto& objectId : m_objectIds) {
+            m_registry.removeSource(objectId);
+        }
+    }
+    /** Links all objects for all clients. @return true when all sinks got initialized in time. */
+    bool linkAll(double timeoutSeconds)
+    {
+        for (auto& client : m_clients) {
+            if (!client.link) {
+                return false;
+            }
+            for (const auto& objectId : m_objectIds) {
+                client.node->linkRemote(objectId);
+            }
+        }
+        return waitFor([this]() {
+            for (const auto& client : m_clients) {
+                for (const auto& sink : client.sinks) {
+                    if (!sink->isReady()) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }, timeoutSeconds);
+    }
+    const std::vector<std::string>& objectIds() const { return m_objectIds; }
+    std::vector<std::shared_ptr<Bench::BenchSource>>& sources() { return m_sources; }
+    std::vector<Client>& clients() { return m_clients; }
+private:
+    RemoteRegistry m_registry;
+    std::vector<std::string> m_objectIds;
+    std::vector<std::shared_ptr<Bench::BenchSource>> m_sources;
+    std::vector<Client> m_clients;
+};
+
+nlohmann::json makeValue(const std::string& payload)
+{
+    return { { "t", Bench::now() }, { "p", payload } };
+}
+
+/**
+* Sources notify property changes, each change is delivered to every client.
+* Latency is measured from the notification until the sink receives it.
+*/
+std::size_t runFanout(Setup& setup, const Options& options, const std::string& payload)
+{
+    auto& sources = setup.sources();
+    const auto& objectIds = setup.objectIds();
+    for (int i = 0; i < options.messages; ++i) {
+        const auto index = static_cast<std::size_t>(i) % sources.size();
+        sources[index]->notifyPropertyChange(objectIds[index] + "/value", makeValue(payload));
+    }
+    return static_cast<std::size_t>(options.messages) * setup.clients().size();
+}
+
+/**
+* Each client invokes a method and waits for the reply before sending the next one.
+* Latency is the round trip time. With in process transport the clients take turns in one thread,
+* because a node is not meant to handle messages from many threads at once.
+*/
+std::size_t runInvoke(Setup& setup, const Options& options, const std::string& transport, Bench::LatencyRecorder& recorder)
+{
+    auto& clients = setup.clients();
+    const auto& objectIds = setup.objectIds();
+    const int perClient = std::max(1, options.messages / static_cast<int>(clients.size()));
+    auto invokeSequence = [&objectIds, &recorder, &options](ClientNode& node, int count, int offset) {
+        for (int i = 0; i < count; ++i) {
+            std::atomic<bool> replied{ false };
+            const auto& objectId = objectIds[static_cast<std::size_t>(offset + i) % objectIds.size()];
+            node.invokeRemote(objectId + "/echo", { { "t", Bench::now() } }, [&recorder, &replied](InvokeReplyArg arg) {
+                recorder.record(Bench::now() - arg.value["t"].get<std::int64_t>());
+                replied = true;
+            });
+            if (!waitFor([&replied]() { return replied.load(); }, options.timeoutSeconds)) {
+                // the callback keeps a reference to replied, it must not outlive this frame
+                std::cerr << "invoke reply timed out\n";
+                std::abort();
+            }
+        }
+    };
+    if (transport == inProcessTransport) {
+        for (int i = 0; i < perClient; ++i) {
+            for (std::size_t clientIndex = 0; clientIndex < clients.size(); ++clientIndex) {
+                invokeSequence(*clients[clientIndex].node, 1, i + static_cast<int>(clientIndex));
+            }
+        }
+    } else {
+        std::vector<std::thread> threads;
+        for (std::size_t clientIndex = 0; clientIndex < clients.size(); ++clientIndex) {
+            auto node = clients[clientIndex].node;
+            threads.emplace_back([node, perClient, clientIndex, &invokeSequence]() {
+                invokeSequence(*node, perClient, static_cast<int>(clientIndex));
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+    return static_cast<std::size_t>(perClient) * clients.size();
+}
+
+/**
+* Clients set properties as fast as they can, the source broadcasts each new value to all clients.
+* Latency is measured from the set request until each client observes the change.
+*/
+std::size_t runSetStorm(Setup& setup, const Options& options, const std::string& transport, const std::string& payload)
+{
+    auto& clients = setup.clients();
+    const auto& objectIds = setup.objectIds();
+    const int perClient = std::max(1, options.messages / static_cast<int>(clients.size()));
+    auto setSequence = [&objectIds, &payload](ClientNode& node, int count, int offset) {
+        for (int i = 0; i < count; ++i) {
+            const auto& objectId = objectIds[static_cast<std::size_t>(offset + i) % objectIds.size()];
+            node.setRemoteProperty(objectId + "/value", makeValue(payload));
+        }
+    };
+    if (transport == inProcessTransport) {
+        for (int i = 0; i < perClient; ++i) {
+            for (std::size_t clientIndex = 0; clientIndex < clients.size(); ++clientIndex) {
+                setSequence(*clients[clientIndex].node, 1, i + static_cast<int>(clientIndex));
+            }
+        }
+    } else {
+        std::vector<std::thread> threads;
+        for (std::size_t clientIndex = 0; clientIndex < clients.size(); ++clientIndex) {
+            auto node = clients[clientIndex].node;
+            threads.emplace_back([node, perClient, clientIndex, &setSequence]() {
+                setSequence(*node, perClient, static_cast<int>(clientIndex));
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+    return static_cast<std::size_t>(perClient) * clients.size() * clients.size();
+}
+
+bool runWorkload(const Options& options, MessageFormat format, const std::string& transport, const std::string& workload, Result& result)
+{
+    Bench::LatencyRecorder recorder;
+    Setup setup(options, format, transport, recorder);
+    if (!setup.linkAll(options.timeoutSeconds)) {
+        return false;
+    }
+    const std::string payload(static_cast<std::size_t>(options.payloadSize), 'x');
+    const auto clientCount = static_cast<std::size_t>(options.clients);
+    const auto messages = static_cast<std::size_t>(options.messages);
+    recorder.reset(workload == invokeWorkload ? messages : messages * clientCount);
+
+    const auto allocationsAtStart = AllocationCounter::processAllocations();
+    const auto start = std::chrono::steady_clock::now();
+    std::size_t expected = 0;
+    if (workload == fanoutWorkload) {
+        expected = runFanout(setup, options, payload);
+    } else if (workload == invokeWorkload) {
+        expected = runInvoke(setup, options, transport, recorder);
+    } else {
+        expected = runSetStorm(setup, options, transport, payload);
+    }
+    result.completed = waitFor([&recorder, expected]() { return recorder.count() >= expected; }, options.timeoutSeconds);
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.allocations = AllocationCounter::processAllocations() - allocationsAtStart;
+    result.delivered = recorder.count();
+    result.latencies = recorder.samples();
+    return true;
+}
+
+double percentile(const std::vector<std::int64_t>& sorted, double fraction)
+{
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    const auto index = std::min(sorted.size() - 1, static_cast<std::size_t>(fraction * static_cast<double>(sorted.size())));
+    return static_cast<double>(sorted[index]) / 1000.0;
+}
+
+void printHeader()
+{
+    std::cout << std::left << std::setw(9) << "format"
+        << std::setw(12) << "transport"
+        << std::setw(10) << "workload"
+        << std::right << std::setw(11) << "messages"
+        << std::setw(13) << "msg/s"
+        << std::setw(11) << "p50 us"
+        << std::setw(11) << "p99 us"
+        << std::setw(11) << "p999 us"
+        << std::setw(12) << "allocs/msg" << "\n";
+}
+
+void printResult(MessageFormat format, const std::string& transport, const std::string& workload, Result& result)
+{
+    std::sort(result.latencies.begin(), result.latencies.end());
+    const double throughput = result.seconds > 0.0 ? static_cast<double>(result.delivered) / result.seconds : 0.0;
+    std::cout << std::left << std::setw(9) << formatName(format)
+        << std::setw(12) << transport
+        << std::setw(10) << workload
+        << std::right << std::setw(11) << result.delivered
+        << std::setw(13) << std::fixed << std::setprecision(0) << throughput
+        << std::setw(11) << std::setprecision(1) << percentile(result.latencies, 0.50)
+        << std::setw(11) << percentile(result.latencies, 0.99)
+        << std::setw(11) << percentile(result.latencies, 0.999)
+        << std::setw(12) << (result.delivered ? static_cast<double>(result.allocations) / static_cast<double>(result.delivered) : 0.0)
+        << (result.completed ? "" : "  (timed out)") << "\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        return 1;
+    }
+#ifdef OLINK_BENCH_HAS_SOCKETPAIR
+    // writes to a closed socket during tear down must not terminate the benchmark
+    std::signal(SIGPIPE, SIG_IGN);
+#endif
+    std::cout << "clients: " << options.clients << ", objects: " << options.objects
+        << ", messages: " << options.messages << ", payload: " << options.payloadSize << " bytes\n";
+    printHeader();
+    for (const auto& transport : options.transports) {
+#ifndef OLINK_BENCH_HAS_SOCKETPAIR
+        if (transport == socketPairTransport) {
+            std::cerr << "socketpair transport is not available on this platform\n";
+            continue;
+        }
+#endif
+        if (transport != inProcessTransport && transport != socketPairTransport) {
+            std::cerr << "unknown transport " << transport << "\n";
+            continue;
+        }
+        for (const auto& workload : options.workloads) {
+            if (workload != fanoutWorkload && workload != invokeWorkload && workload != setWorkload) {
+                std::cerr << "unknown workload " << workload << "\n";
+                continue;
+            }
+            for (auto format : options.formats) {
+                Result result;
+                if (!runWorkload(options, format, transport, workload, result)) {
+                    std::cerr << formatName(format) << " " << transport << " " << workload << ": failed to link objects\n";
+                    continue;
+                }
+                printResult(format, transport, workload, result);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,172 @@
+/*
+* MIT License
+*
+* Copyright (c) 2021 ApiGear
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#pragma once
+
+#include "olink/clientnode.h"
+#include "olink/remotenode.h"
+
+#include <memory>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define OLINK_BENCH_HAS_SOCKETPAIR 1
+#include "olink/core/framedecoder.h"
+#include <cerrno>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace Bench {
+
+/**
+* Connects a client node with a remote node.
+* The link must be closed before any of the nodes is destroyed.
+*/
+class Link
+{
+public:
+    virtual ~Link() = default;
+    /** Stops delivering messages and detaches the write functions of both nodes. */
+    virtual void close() = 0;
+};
+
+/**
+* Delivers messages by calling the other node directly from the write function.
+* Every message is handled synchronously in the thread that sends it.
+*/
+class InProcessLink : public Link
+{
+public:
+    InProcessLink(ApiGear::ObjectLink::ClientNode& client, ApiGear::ObjectLink::RemoteNode& remote)
+        : m_client(client)
+        , m_remote(remote)
+    {
+        m_client.onWrite([&remote](const std::string& msg) { remote.handleMessage(msg); });
+        m_remote.onWrite([&client](const std::string& msg) { client.handleMessage(msg); });
+    }
+    void close() override
+    {
+        m_client.onWrite(nullptr);
+        m_remote.onWrite(nullptr);
+    }
+private:
+    ApiGear::ObjectLink::ClientNode& m_client;
+    ApiGear::ObjectLink::RemoteNode& m_remote;
+};
+
+#ifdef OLINK_BENCH_HAS_SOCKETPAIR
+
+/**
+* Delivers length prefixed frames over a unix stream socket pair.
+* Each side has its own reader thread which decodes frames and passes them to its node.
+*/
+class SocketPairLink : public Link
+{
+public:
+    SocketPairLink(ApiGear::ObjectLink::ClientNode& client, ApiGear::ObjectLink::RemoteNode& remote)
+        : m_client(client)
+        , m_remote(remote)
+    {
+        if (::socketpair(AF_UNIX, SOCK_STREAM, 0, m_fds) != 0) {
+            m_fds[0] = m_fds[1] = -1;
+            return;
+        }
+        const int clientFd = m_fds[0];
+        const int remoteFd = m_fds[1];
+        m_client.onWrite([this, clientFd](const std::string& msg) { writeFrame(clientFd, m_clientWriteMutex, msg); });
+        m_remote.onWrite([this, remoteFd](const std::string& msg) { writeFrame(remoteFd, m_remoteWriteMutex, msg); });
+        m_clientReader = std::thread([clientFd, &client]() { readFrames(clientFd, client); });
+        m_remoteReader = std::thread([remoteFd, &remote]() { readFrames(remoteFd, remote); });
+    }
+    ~SocketPairLink() override
+    {
+        close();
+    }
+    bool isOpen() const
+    {
+        return m_fds[0] >= 0;
+    }
+    void close() override
+    {
+        if (!isOpen()) {
+            return;
+        }
+        ::shutdown(m_fds[0], SHUT_RDWR);
+        ::shutdown(m_fds[1], SHUT_RDWR);
+        m_clientReader.join();
+        m_remoteReader.join();
+        m_client.onWrite(nullptr);
+        m_remote.onWrite(nullptr);
+        ::close(m_fds[0]);
+        ::close(m_fds[1]);
+        m_fds[0] = m_fds[1] = -1;
+    }
+private:
+    /** Writes the whole frame, the mutex keeps frames from different threads from interleaving. */
+    static void writeFrame(int fd, std::mutex& mutex, const std::string& msg)
+    {
+        const auto frame = ApiGear::ObjectLink::FrameDecoder::encodeFrame(msg);
+        std::unique_lock<std::mutex> lock(mutex);
+        std::size_t written = 0;
+        while (written < frame.size()) {
+            const auto result = ::write(fd, frame.data() + written, frame.size() - written);
+            if (result < 0 && errno == EINTR) {
+                continue;
+            }
+            if (result <= 0) {
+                return;
+            }
+            written += static_cast<std::size_t>(result);
+        }
+    }
+    static void readFrames(int fd, ApiGear::ObjectLink::IMessageHandler& node)
+    {
+        ApiGear::ObjectLink::FrameDecoder decoder(node);
+        std::vector<char> buffer(64 * 1024);
+        while (true) {
+            const auto result = ::read(fd, buffer.data(), buffer.size());
+            if (result < 0 && errno == EINTR) {
+                continue;
+            }
+            if (result <= 0 || !decoder.feed(buffer.data(), static_cast<std::size_t>(result))) {
+                return;
+            }
+        }
+    }
+
+    ApiGear::ObjectLink::ClientNode& m_client;
+    ApiGear::ObjectLink::RemoteNode& m_remote;
+    int m_fds[2];
+    std::mutex m_clientWriteMutex;
+    std::mutex m_remoteWriteMutex;
+    std::thread m_clientReader;
+    std::thread m_remoteReader;
+};
+
+#endif // OLINK_BENCH_HAS_SOCKETPAIR
+
+} // namespace Bench
@@ -36,11 +36,17 @@ OLinkClient::OLinkClient(QWebSocket *socket, ApiGear::ObjectLink::ClientRegistry
     connect(m_socket, &QWebSocket::connected, this, &OLinkClient::onConnected);
     connect(m_socket, &QWebSocket::disconnected, this, &OLinkClient::onDisconnected);
     connect(m_socket, &QWebSocket::textMessageReceived, this, &OLinkClient::handleTextMessage);
-    WriteMessageFunc func = [this](std::string msg) {
-        m_queue << msg;
+    connect(m_socket, &QWebSocket::binaryMessageReceived, this, &OLinkClient::handleBinaryMessage);
+    // queued messages are kept without copying them
+    WriteMessageBufferFunc func = [this](MessageBuffer msg) {
+        m_queue << std::move(msg);
         processMessages();
     };
-    m_node.onWrite(func);
+    m_node.onWriteBuffer(func);
+    // chunks of large messages are written from the event loop, other messages go out in between
+    m_node.onChunksPending([this]() {
+        QMetaObject::invokeMethod(this, &OLinkClient::writePendingChunks, Qt::QueuedConnection);
+    });
 }
 
 OLinkClient::~OLinkClient()
@@ -80,7 +86,14 @@ void OLinkClient::onDisconnected()
 
 void OLinkClient::handleTextMessage(const QString &message)
 {
-    m_node.handleMessage(message.toStdString());
+    const QByteArray utf8 = message.toUtf8();
+    m_node.handleMessage(utf8.constData(), static_cast<std::size_t>(utf8.size()));
+}
+
+void OLinkClient::handleBinaryMessage(const QByteArray &message)
+{
+    // binary formats are parsed directly from the socket buffer
+    m_node.handleMessage(message.constData(), static_cast<std::size_t>(message.size()));
 }
 
 
@@ -92,10 +105,17 @@ void OLinkClient::processMessages()
             // if we are using JSON we need to use txt message
             // otherwise binary messages
             //    m_socket->sendBinaryMessage(QByteArray::fromStdString(message));
-            const QString& msg = QString::fromStdString(m_queue.dequeue());
+            const QString& msg = QString::fromStdString(*m_queue.dequeue());
             qDebug() << "write message to socket: " << msg;
             m_socket->sendTextMessage(msg);
         }
     }
 
 }
+
+void OLinkClient::writePendingChunks()
+{
+    if (m_node.writePendingChunks(1) > 0) {
+        QMetaObject::invokeMethod(this, &OLinkClient::writePendingChunks, Qt::QueuedConnection);
+    }
+}
@@ -45,11 +45,14 @@ public:
     void onConnected();
     void onDisconnected();
     void handleTextMessage(const QString& message);
+    void handleBinaryMessage(const QByteArray& message);
     void processMessages();
+    /** Writes one chunk of the pending chunked messages per turn of the event loop. */
+    void writePendingChunks();
 
 private:
     QWebSocket *m_socket;
     ApiGear::ObjectLink::ClientRegistry* m_registry;
     ClientNode m_node;
-    QQueue<std::string> m_queue;
+    QQueue<MessageBuffer> m_queue;
 };
@@ -9,10 +9,22 @@ OLinkRemote::OLinkRemote(QWebSocket *socket, ApiGear::ObjectLink::RemoteRegistry
 {
     m_node.onLog(ConsoleLogger::logFunc());
     connect(m_socket, &QWebSocket::textMessageReceived, this, &OLinkRemote::handleMessage);
+    connect(m_socket, &QWebSocket::binaryMessageReceived, this, &OLinkRemote::handleBinaryMessage);
     WriteMessageFunc writeFunc = [this](std::string msg) {
         writeMessage(msg);
     };
     m_node.onWrite(writeFunc);
+    // chunks of large messages are written from the event loop, other messages go out in between
+    m_node.onChunksPending([this]() {
+        QMetaObject::invokeMethod(this, &OLinkRemote::writePendingChunks, Qt::QueuedConnection);
+    });
+}
+
+void OLinkRemote::writePendingChunks()
+{
+    if(m_node.writePendingChunks(1) > 0) {
+        QMetaObject::invokeMethod(this, &OLinkRemote::writePendingChunks, Qt::QueuedConnection);
+    }
 }
 
 void OLinkRemote::writeMessage(const std::string msg)
@@ -26,5 +38,12 @@ void OLinkRemote::writeMessage(const std::string msg)
 void OLinkRemote::handleMessage(const QString &msg)
 {
     qDebug() << Q_FUNC_INFO << msg;
-    m_node.handleMessage(msg.toStdString());
+    const QByteArray utf8 = msg.toUtf8();
+    m_node.handleMessage(utf8.constData(), static_cast<std::size_t>(utf8.size()));
+}
+
+void OLinkRemote::handleBinaryMessage(const QByteArray &msg)
+{
+    // binary formats are parsed directly from the socket buffer
+    m_node.handleMessage(msg.constData(), static_cast<std::size_t>(msg.size()));
 }
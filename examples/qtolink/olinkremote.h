@@ -15,6 +15,9 @@ public:
     explicit OLinkRemote(QWebSocket* socket, ApiGear::ObjectLink::RemoteRegistry& registry);
     void writeMessage(const std::string msg);
     void handleMessage(const QString& msg);
+    void handleBinaryMessage(const QByteArray& msg);
+    /** Writes one chunk of the pending chunked messages per turn of the event loop. */
+    void writePendingChunks();
 private:
     QWebSocket* m_socket;
     ApiGear::ObjectLink::RemoteRegistry* m_registry;
@@ -0,0 +1,214 @@
+/*
+* MIT License
+*
+* Copyright (c) 2021 ApiGear
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#include "asynclogger.h"
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+
+namespace ApiGear { namespace ObjectLink {
+
+namespace {
+
+/** Time the background thread sleeps when there is nothing to write and nobody asks for it. */
+const auto idleInterval = std::chrono::milliseconds(10);
+
+std::size_t roundUpToPowerOfTwo(std::size_t value)
+{
+    std::size_t result = 2;
+    while (result < value) {
+        result *= 2;
+    }
+    return result;
+}
+
+const char* levelName(LogLevel level)
+{
+    switch(level) {
+    case LogLevel::Info:
+        return "[info   ] ";
+    case LogLevel::Debug:
+        return "[debug  ] ";
+    case LogLevel::Warning:
+        return "[warning] ";
+    case LogLevel::Error:
+        return "[error  ] ";
+    }
+    return "[       ] ";
+}
+
+void appendTime(std::string& out, std::int64_t timeUs)
+{
+    const std::time_t seconds = static_cast<std::time_t>(timeUs / 1000000);
+    std::tm utc{};
+#if defined(_WIN32)
+    gmtime_s(&utc, &seconds);
+#else
+    gmtime_r(&seconds, &utc);
+#endif
+    char buffer[40];
+    const auto length = std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &utc);
+    out.append(buffer, length);
+    std::snprintf(buffer, sizeof(buffer), ".%06dZ ", static_cast<int>(timeUs % 1000000));
+    out += buffer;
+}
+
+void writeToStdout(const std::string& lines)
+{
+    std::fwrite(lines.data(), 1, lines.size(), stdout);
+    std::fflush(stdout);
+}
+
+} // namespace
+
+AsyncLogger::AsyncLogger(std::size_t capacity, OverflowPolicy policy)
+    : AsyncLogger(writeToStdout, capacity, policy)
+{
+}
+
+AsyncLogger::AsyncLogger(WriteBatchFunc write, std::size_t capacity, OverflowPolicy policy)
+    : m_records(new Record[roundUpToPowerOfTwo(capacity)])
+    , m_mask(roundUpToPowerOfTwo(capacity) - 1)
+    , m_policy(policy)
+    , m_write(std::move(write))
+{
+    for (std::size_t i = 0; i <= m_mask; ++i) {
+        m_records[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    m_thread = std::thread(&AsyncLogger::run, this);
+}
+
+AsyncLogger::~AsyncLogger()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+}
+
+void AsyncLogger::writeLog(LogLevel level, const std::string& msg)
+{
+    while (!tryPush(level, msg)) {
+        if (m_policy == OverflowPolicy::Drop) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        m_wakeRequested.store(true, std::memory_order_relaxed);
+        m_wake.notify_one();
+        std::this_thread::yield();
+    }
+}
+
+bool AsyncLogger::tryPush(LogLevel level, const std::string& msg)
+{
+    // bounded queue with a sequence number per record, the position is claimed with a compare and swap
+    auto position = m_pushPosition.load(std::memory_order_relaxed);
+    Record* record = nullptr;
+    for (;;) {
+        record = &m_records[position & m_mask];
+        const auto sequence = record->sequence.load(std::memory_order_acquire);
+        const auto difference = static_cast<std::ptrdiff_t>(sequence - position);
+        if (difference == 0) {
+            if (m_pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            return false;
+        } else {
+            position = m_pushPosition.load(std::memory_order_relaxed);
+        }
+    }
+    record->level = level;
+    record->timeUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    // reuses the capacity left by earlier records, in steady state logging does not allocate
+    record->msg.assign(msg);
+    record->sequence.store(position + 1, std::memory_order_release);
+    // wake the writer early when the ring fills up, otherwise it polls
+    if (position - m_written.load(std::memory_order_relaxed) >= (m_mask + 1) / 2 && !m_wakeRequested.exchange(true, std::memory_order_relaxed)) {
+        m_wake.notify_one();
+    }
+    return true;
+}
+
+WriteLogFunc AsyncLogger::logFunc()
+{
+    return [this](LogLevel level, const std::string& msg) {
+        writeLog(level, msg);
+    };
+}
+
+void AsyncLogger::flush()
+{
+    const auto target = m_pushPosition.load(std::memory_order_acquire);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_wakeRequested.store(true, std::memory_order_relaxed);
+    m_wake.notify_one();
+    m_flushed.wait(lock, [this, target]() { return m_written.load(std::memory_order_acquire) >= target; });
+}
+
+std::uint64_t AsyncLogger::dropped() const
+{
+    return m_dropped.load(std::memory_order_relaxed);
+}
+
+std::size_t AsyncLogger::drain()
+{
+    std::size_t count = 0;
+    for (;;) {
+        auto& record = m_records[m_popPosition & m_mask];
+        if (record.sequence.load(std::memory_order_acquire) != m_popPosition + 1) {
+            break;
+        }
+        appendTime(m_batch, record.timeUs);
+        m_batch += levelName(record.level);
+        m_batch += record.msg;
+        m_batch += '\n';
+        record.sequence.store(m_popPosition + m_mask + 1, std::memory_order_release);
+        ++m_popPosition;
+        ++count;
+    }
+    return count;
+}
+
+void AsyncLogger::run()
+{
+    for (;;) {
+        m_batch.clear();
+        drain();
+        if (!m_batch.empty() && m_write) {
+            m_write(m_batch);
+        }
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_written.store(m_popPosition, std::memory_order_release);
+        m_flushed.notify_all();
+        if (m_stop && m_records[m_popPosition & m_mask].sequence.load(std::memory_order_acquire) != m_popPosition + 1) {
+            return;
+        }
+        m_wake.wait_for(lock, idleInterval, [this]() { return m_stop || m_wakeRequested.load(std::memory_order_relaxed); });
+        m_wakeRequested.store(false, std::memory_order_relaxed);
+    }
+}
+
+} } // ApiGear::ObjectLink
@@ -0,0 +1,113 @@
+/*
+* MIT License
+*
+* Copyright (c) 2021 ApiGear
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#pragma once
+
+#include "core/types.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace ApiGear { namespace ObjectLink {
+
+/**
+* A logger which does not write on the logging thread, use logFunc() as WriteLogFunc of nodes and registries.
+* Records are put into a bounded lock-free ring and written by a background thread in batches,
+* with one write and one flush per batch. Logging threads never wait for the output.
+* When the ring is full, records are dropped and counted, or with OverflowPolicy::Block the logging thread waits.
+* Each line has the UTC time the record was logged, e.g. "2021-06-01T12:00:00.123456Z [info   ] message".
+*/
+class OLINK_EXPORT AsyncLogger {
+public:
+    /** A function which writes a batch of formatted lines, each ending with a new line. */
+    using WriteBatchFunc = std::function<void(const std::string& lines)>;
+
+    enum class OverflowPolicy {
+        /** Records logged while the ring is full are dropped and counted, see dropped(). */
+        Drop,
+        /** The logging thread yields until there is space in the ring. */
+        Block,
+    };
+
+    /**
+    * Starts the background thread writing to stdout.
+    * @param capacity Number of records the ring can hold, rounded up to a power of two.
+    */
+    explicit AsyncLogger(std::size_t capacity = 8192, OverflowPolicy policy = OverflowPolicy::Drop);
+    /** Starts the background thread writing with given function, which is called only from that thread. */
+    AsyncLogger(WriteBatchFunc write, std::size_t capacity = 8192, OverflowPolicy policy = OverflowPolicy::Drop);
+    /** dtor, writes all logged records and stops the background thread. */
+    ~AsyncLogger();
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    /** Puts a record into the ring. Thread safe and lock free unless the ring is full and the policy is Block. */
+    void writeLog(LogLevel level, const std::string& msg);
+    /** @return a function which logs with this logger, it must not be used after the logger is destroyed. */
+    WriteLogFunc logFunc();
+    /** Waits until all the records logged before the call are written. */
+    void flush();
+    /** @return number of records dropped because the ring was full. */
+    std::uint64_t dropped() const;
+private:
+    struct Record
+    {
+        std::atomic<std::size_t> sequence{ 0 };
+        LogLevel level = LogLevel::Info;
+        std::int64_t timeUs = 0;
+        std::string msg;
+    };
+
+    bool tryPush(LogLevel level, const std::string& msg);
+    void run();
+    /** Formats all available records into m_batch. @return number of formatted records. */
+    std::size_t drain();
+
+    std::unique_ptr<Record[]> m_records;
+    std::size_t m_mask;
+    OverflowPolicy m_policy;
+    WriteBatchFunc m_write;
+    /** Next position to fill, shared by all logging threads. */
+    std::atomic<std::size_t> m_pushPosition{ 0 };
+    /** Next position to write, used by the background thread only. */
+    std::size_t m_popPosition = 0;
+    /** Number of positions written, for flush. */
+    std::atomic<std::size_t> m_written{ 0 };
+    std::atomic<std::uint64_t> m_dropped{ 0 };
+    std::atomic<bool> m_wakeRequested{ false };
+    bool m_stop = false;
+    std::string m_batch;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_flushed;
+    std::thread m_thread;
+};
+
+} } // ApiGear::ObjectLink
@@ -27,7 +27,7 @@ std::shared_ptr<ClientNode> ClientNode::create(ClientRegistry& registry)
 void ClientNode::linkRemote(const std::string& objectId)
 {
     emitLog(LogLevel::Info, "ClientNode.linkRemote: " + objectId);
-    emitWrite(Protocol::linkMessage(objectId));
+    emitWrite(compactIfNegotiated(Protocol::linkMessage(objectId)));
     m_registry.unsetNode(objectId);
     m_registry.setNode(m_nodeId, objectId);
 }
@@ -39,26 +39,86 @@ void ClientNode::unlinkRemote(const std::string& objectId)
     if (sink){
         sink->olinkOnRelease();
     }
-    emitWrite(Protocol::unlinkMessage(objectId));
+    emitWrite(compactIfNegotiated(Protocol::unlinkMessage(objectId)));
     m_registry.unsetNode(objectId);
 }
 
 void ClientNode::invokeRemote(const std::string& methodId, const nlohmann::json& args, InvokeReplyFunc func)
 {
-    emitLog(LogLevel::Info, "ClientNode.invokeRemote: " + methodId);
+    invokeRemote(methodId, nlohmann::json(args), func);
+}
+
+void ClientNode::invokeRemote(const std::string& methodId, nlohmann::json&& args, InvokeReplyFunc func)
+{
+    if(isLogEnabled()) {
+        emitLog(LogLevel::Info, "ClientNode.invokeRemote: " + methodId);
+    }
     int requestId = nextRequestId();
     std::unique_lock<std::mutex> lock(m_pendingInvokesMutex);
-    m_invokesPending[requestId] = func;
+    m_invokesPending[requestId] = PendingInvoke{ std::move(func), methodId, std::chrono::steady_clock::now() };
+    const auto pendingCount = m_invokesPending.size();
     lock.unlock();
-    nlohmann::json msg = Protocol::invokeMessage(requestId, methodId, args);
-    emitWrite(msg);
+    if (metrics()) {
+        metrics()->setPendingInvokes(static_cast<std::int64_t>(pendingCount));
+    }
+    emitWrite(compactIfNegotiated(Protocol::invokeMessage(requestId, methodId, std::move(args))));
+}
+
+void ClientNode::invokeRemoteOneWay(const std::string& methodId, nlohmann::json&& args)
+{
+    if(isLogEnabled()) {
+        emitLog(LogLevel::Info, "ClientNode.invokeRemoteOneWay: " + methodId);
+    }
+    emitWrite(compactIfNegotiated(Protocol::invokeMessage(Protocol::oneWayRequestId, methodId, std::move(args))));
+}
+
+void ClientNode::invokeRemoteBatch(std::vector<InvokeRequest> calls)
+{
+    if(!hasFeature(Handshake::batching)) {
+        IClientNode::invokeRemoteBatch(std::move(calls));
+        return;
+    }
+    if(calls.empty()) {
+        return;
+    }
+    if(isLogEnabled()) {
+        emitLog(LogLevel::Info, "ClientNode.invokeRemoteBatch: " + std::to_string(calls.size()) + " calls");
+    }
+    auto entries = nlohmann::json::array();
+    std::vector<int> requestIds;
+    requestIds.reserve(calls.size());
+    const auto sentAt = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(m_pendingInvokesMutex);
+    for(auto& call : calls) {
+        const int requestId = nextRequestId();
+        m_invokesPending[requestId] = PendingInvoke{ std::move(call.func), call.methodId, sentAt };
+        requestIds.push_back(requestId);
+    }
+    const auto pendingCount = m_invokesPending.size();
+    lock.unlock();
+    if (metrics()) {
+        metrics()->setPendingInvokes(static_cast<std::int64_t>(pendingCount));
+    }
+    for(std::size_t i = 0; i < calls.size(); ++i) {
+        entries.push_back(nlohmann::json::array({ requestIds[i], std::move(calls[i].methodId), std::move(calls[i].args) }));
+    }
+    emitWrite(compactIfNegotiated(Protocol::invokeBatchMessage(std::move(entries))));
 }
 
 void ClientNode::setRemoteProperty(const std::string& propertyId, const nlohmann::json& value)
 {
-    emitLog(LogLevel::Info, "ClientNode.setRemoteProperty: " + propertyId);
-    nlohmann::json msg = Protocol::setPropertyMessage(propertyId, value);
-    emitWrite(msg);
+    if(isLogEnabled()) {
+        emitLog(LogLevel::Info, "ClientNode.setRemoteProperty: " + propertyId);
+    }
+    emitWrite(compactIfNegotiated(Protocol::setPropertyMessage(propertyId, value)));
+}
+
+void ClientNode::setRemoteProperty(const std::string& propertyId, nlohmann::json&& value)
+{
+    if(isLogEnabled()) {
+        emitLog(LogLevel::Info, "ClientNode.setRemoteProperty: " + propertyId);
+    }
+    emitWrite(compactIfNegotiated(Protocol::setPropertyMessage(propertyId, std::move(value))));
 }
 
 ClientRegistry& ClientNode::registry()
@@ -83,10 +143,17 @@ unsigned long ClientNode::getNodeId() const
 
 void ClientNode::handleInit(const std::string& objectId, const nlohmann::json& props)
 {
-    emitLog(LogLevel::Info, "ClientNode.handleInit: " + objectId + props.dump());
+    handleInit(objectId, nlohmann::json(props));
+}
+
+void ClientNode::handleInit(const std::string& objectId, nlohmann::json&& props)
+{
+    emitLog(LogLevel::Info, "ClientNode.handleInit: " + objectId + payloadToString(props));
     auto sink = m_registry.getSink(objectId).lock();
     if(sink) {
-        sink->olinkOnInit(objectId, props, this);
+        const auto started = handlerStarted();
+        sink->olinkOnInit(objectId, std::move(props), this);
+        handlerFinished("olinkOnInit", objectId, started);
     }
     else {
         emitLog(LogLevel::Warning, "No sink found for id" + objectId);
@@ -95,10 +162,24 @@ void ClientNode::handleInit(const std::string& objectId, const nlohmann::json& p
 
 void ClientNode::handlePropertyChange(const std::string& propertyId, const nlohmann::json& value)
 {
-    emitLog(LogLevel::Info, "ClientNode.handlePropertyChange: " + propertyId + value.dump());
+    handlePropertyChange(propertyId, nlohmann::json(value));
+}
+
+void ClientNode::handlePropertyChange(const std::string& propertyId, nlohmann::json&& value)
+{
+    if(isLogEnabled()) {
+        emitLog(LogLevel::Info, "ClientNode.handlePropertyChange: " + propertyId + payloadToString(value));
+    }
     auto sink = m_registry.getSink(Name::getObjectId(propertyId)).lock();
-    if(sink){
-        sink->olinkOnPropertyChanged(propertyId, value);
+    if(sink && value.is_binary() && !value.get_binary().has_subtype()){
+        const auto started = handlerStarted();
+        sink->olinkOnBinaryPropertyChanged(propertyId, std::move(value.get_binary()));
+        handlerFinished("olinkOnBinaryPropertyChanged", propertyId, started);
+    }
+    else if(sink){
+        const auto started = handlerStarted();
+        sink->olinkOnPropertyChanged(propertyId, std::move(value));
+        handlerFinished("olinkOnPropertyChanged", propertyId, started);
     }
     else {
         emitLog(LogLevel::Warning, "No sink found for id" + Name::getObjectId(propertyId));
@@ -107,30 +188,77 @@ void ClientNode::handlePropertyChange(const std::string& propertyId, const nlohm
 
 void ClientNode::handleInvokeReply(int requestId, const std::string& methodId, const nlohmann::json& value)
 {
-    emitLog(LogLevel::Info, "ClientNode.handleInvokeReply: " + methodId + value.dump());
+    handleInvokeReply(requestId, methodId, nlohmann::json(value));
+}
+
+void ClientNode::handleInvokeReply(int requestId, const std::string& methodId, nlohmann::json&& value)
+{
+    handleReply(requestId, &methodId, std::move(value));
+}
+
+void ClientNode::handleCompactInvokeReply(int requestId, const nlohmann::json& value)
+{
+    handleReply(requestId, nullptr, nlohmann::json(value));
+}
+
+void ClientNode::handleCompactInvokeReply(int requestId, nlohmann::json&& value)
+{
+    handleReply(requestId, nullptr, std::move(value));
+}
+
+void ClientNode::handleReply(int requestId, const std::string* replyMethodId, nlohmann::json&& value)
+{
+    if(requestId == Protocol::oneWayRequestId) {
+        // sent by services of older versions, nobody waits for it
+        return;
+    }
+    if(isLogEnabled()) {
+        emitLog(LogLevel::Info, "ClientNode.handleInvokeReply: " + (replyMethodId ? *replyMethodId : std::to_string(requestId)) + payloadToString(value));
+    }
     std::unique_lock<std::mutex> lock(m_pendingInvokesMutex);
     auto responseHandler = m_invokesPending.find(requestId);
-    InvokeReplyFunc callback = nullptr;
-    if (responseHandler != m_invokesPending.end())
+    if (responseHandler == m_invokesPending.end())
     {
-        callback =  responseHandler->second;
-        m_invokesPending.erase(responseHandler);
+        lock.unlock();
+        emitLog(LogLevel::Warning, "no pending invoke " + (replyMethodId ? *replyMethodId : std::string()) + std::to_string(requestId));
+        return;
     }
+    InvokeReplyFunc callback = std::move(responseHandler->second.func);
+    const auto methodId = replyMethodId ? *replyMethodId : std::move(responseHandler->second.methodId);
+    const auto sentAt = responseHandler->second.sentAt;
+    m_invokesPending.erase(responseHandler);
+    const auto pendingCount = m_invokesPending.size();
     lock.unlock();
+    if (metrics()) {
+        metrics()->recordInvokeRoundTrip(std::chrono::steady_clock::now() - sentAt);
+        metrics()->setPendingInvokes(static_cast<std::int64_t>(pendingCount));
+    }
+    if (objectMetrics()) {
+        objectMetrics()->recordInvokeRoundTrip(Name::getObjectId(methodId), std::chrono::steady_clock::now() - sentAt);
+    }
     if(callback) {
-        const InvokeReplyArg arg{ methodId, value};
-        callback(arg);
-    } else {
-        emitLog(LogLevel::Warning, "no pending invoke " + methodId + std::to_string(requestId));
+        InvokeReplyArg arg{ methodId, std::move(value)};
+        const auto started = handlerStarted();
+        callback(std::move(arg));
+        handlerFinished("invokeReply", methodId, started);
     }
 }
 
 void ClientNode::handleSignal(const std::string& signalId, const nlohmann::json& args)
 {
-    emitLog(LogLevel::Info, "ClientNode.handleSignal: " + signalId);
+    handleSignal(signalId, nlohmann::json(args));
+}
+
+void ClientNode::handleSignal(const std::string& signalId, nlohmann::json&& args)
+{
+    if(isLogEnabled()) {
+        emitLog(LogLevel::Info, "ClientNode.handleSignal: " + signalId);
+    }
     auto sink = m_registry.getSink(Name::getObjectId(signalId)).lock();
     if(sink) {
-        sink->olinkOnSignal(signalId, args);
+        const auto started = handlerStarted();
+        sink->olinkOnSignal(signalId, std::move(args));
+        handlerFinished("olinkOnSignal", signalId, started);
     } else {
         emitLog(LogLevel::Warning, "No sink found for id" + Name::getObjectId(signalId));
     }
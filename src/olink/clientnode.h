@@ -7,6 +7,7 @@
 #include <map>
 #include <mutex>
 #include <atomic>
+#include <chrono>
 
 
 namespace ApiGear { namespace ObjectLink {
@@ -56,8 +57,16 @@ public:
     void unlinkRemote(const std::string& objectId) override;
     /** IClientNode::invokeRemote implementation. */
     void invokeRemote(const std::string& methodId, const nlohmann::json& args=nlohmann::json{}, InvokeReplyFunc func=nullptr) override;
+    /** IClientNode::invokeRemote implementation, moves the args into the message. */
+    void invokeRemote(const std::string& methodId, nlohmann::json&& args, InvokeReplyFunc func=nullptr) override;
+    /** IClientNode::invokeRemoteOneWay implementation, sends the invoke with Protocol::oneWayRequestId. */
+    void invokeRemoteOneWay(const std::string& methodId, nlohmann::json&& args = nlohmann::json{}) override;
+    /** IClientNode::invokeRemoteBatch implementation, registers all calls as pending at once. */
+    void invokeRemoteBatch(std::vector<InvokeRequest> calls) override;
     /** IClientNode::setRemoteProperty implementation. */
     void setRemoteProperty(const std::string& propertyId, const nlohmann::json& value) override;
+    /** IClientNode::setRemoteProperty implementation, moves the value into the message. */
+    void setRemoteProperty(const std::string& propertyId, nlohmann::json&& value) override;
 
      /* The registry in which client is registered*/
     ClientRegistry& registry();
@@ -71,12 +80,24 @@ public:
 protected:
     /** IProtocolListener::handleInit implementation */
     void handleInit(const std::string& objectId, const nlohmann::json& props) override;
+    /** IProtocolListener::handleInit implementation, hands the props over to the sink. */
+    void handleInit(const std::string& objectId, nlohmann::json&& props) override;
     /** IProtocolListener::handlePropertyChange implementation */
     void handlePropertyChange(const std::string& propertyId, const nlohmann::json& value) override;
+    /** IProtocolListener::handlePropertyChange implementation, hands the value over to the sink. */
+    void handlePropertyChange(const std::string& propertyId, nlohmann::json&& value) override;
     /** IProtocolListener::handleInvokeReply implementation */
     void handleInvokeReply(int requestId, const std::string& methodId, const nlohmann::json& value) override;
+    /** IProtocolListener::handleInvokeReply implementation, hands the value over to the reply handler. */
+    void handleInvokeReply(int requestId, const std::string& methodId, nlohmann::json&& value) override;
+    /** IProtocolListener::handleCompactInvokeReply implementation, the method id is taken from the pending invoke. */
+    void handleCompactInvokeReply(int requestId, const nlohmann::json& value) override;
+    /** IProtocolListener::handleCompactInvokeReply implementation, hands the value over to the reply handler. */
+    void handleCompactInvokeReply(int requestId, nlohmann::json&& value) override;
     /** IProtocolListener::handleSignal implementation */
     void handleSignal(const std::string& signalId, const nlohmann::json& args) override;
+    /** IProtocolListener::handleSignal implementation, hands the args over to the sink. */
+    void handleSignal(const std::string& signalId, nlohmann::json&& args) override;
     /** IProtocolListener::handleError implementation */
     void handleError(int msgType, int requestId, const std::string& error) override;
 
@@ -86,6 +107,12 @@ protected:
      */
     int nextRequestId();
 private:
+    /**
+    * Removes a pending invoke and passes the value to its reply handler.
+    * @param methodId The method id of the reply, nullptr for compact replies which identify the call only by requestId.
+    */
+    void handleReply(int requestId, const std::string* methodId, nlohmann::json&& value);
+
     /* The registry in which client is registered and which provides sinks connected with this node*/
     ClientRegistry& m_registry;
     /* Id of this node in registry.*/
@@ -93,8 +120,17 @@ private:
 
     /* Value of last request id.*/
     std::atomic<int> m_nextRequestId;
-    /** Collection of callbacks for method replies that client is waiting for associated with the id for invocation request message.*/
-    std::map<int,InvokeReplyFunc> m_invokesPending;
+    /** An invoke request waiting for reply. */
+    struct PendingInvoke {
+        /** Callback for the method reply. */
+        InvokeReplyFunc func;
+        /** Id of the invoked method, for replies of protocol v2 which do not repeat it. */
+        std::string methodId;
+        /** Time of sending the request, used to measure the round trip. */
+        std::chrono::steady_clock::time_point sentAt;
+    };
+    /** Collection of invoke requests that client is waiting for associated with the id for invocation request message.*/
+    std::map<int,PendingInvoke> m_invokesPending;
     std::mutex m_pendingInvokesMutex;
 };
 
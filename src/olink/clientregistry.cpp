@@ -22,6 +22,7 @@ void ClientRegistry::setNode(unsigned long id, const std::string& objectId)
         auto newEntry = SinkToClientEntry();
         m_entries[objectId] = newEntry;
         newEntry.nodeId = id;
+        m_objectCount = m_entries.size();
     } else if (entryForObject->second.nodeId == m_clientNodesById.getInvalidId()){
         entryForObject->second.nodeId = id;
     } else if (entryForObject->second.nodeId != id){
@@ -58,6 +59,7 @@ void ClientRegistry::addSink(std::weak_ptr<IObjectSink> sink)
     auto entryForObject = m_entries.find(objectId);
     if (entryForObject == m_entries.end()){
         m_entries[objectId] = newEntry;
+        m_objectCount = m_entries.size();
     } else if (entryForObject->second.sink.expired()){
         m_entries[objectId].sink = lockedSink;
     } else if (entryForObject->second.sink.lock() != lockedSink){
@@ -75,13 +77,16 @@ void ClientRegistry::removeSink(const std::string& objectId)
     {
         auto nodeId = entry->second.nodeId;
         m_entries.erase(entry);
+        m_objectCount = m_entries.size();
         lock.unlock();
     }
 }
 
 std::weak_ptr<IObjectSink> ClientRegistry::getSink(const std::string& objectId)
 {
-    emitLog(LogLevel::Info, "ClientRegistry.getSink: " + objectId);
+    if(isLogEnabled()) {
+        emitLog(LogLevel::Info, "ClientRegistry.getSink: " + objectId);
+    }
     std::unique_lock<std::mutex> lock(m_entriesMutex);
     auto entryForObject = m_entries.find(objectId);
     return entryForObject != m_entries.end() ? entryForObject->second.sink  : std::weak_ptr<IObjectSink>();
@@ -102,7 +107,9 @@ std::vector<std::string> ClientRegistry::getObjectIds(unsigned long nodeId)
 
 std::weak_ptr<IClientNode> ClientRegistry::getNode(const std::string& objectId)
 {
-    emitLog(LogLevel::Info, "ClientRegistry.getNode: " + objectId);
+    if(isLogEnabled()) {
+        emitLog(LogLevel::Info, "ClientRegistry.getNode: " + objectId);
+    }
     std::unique_lock<std::mutex> lock(m_entriesMutex);
     auto entry = m_entries.find(objectId);
     return entry != m_entries.end() ? m_clientNodesById.get(entry->second.nodeId) : std::weak_ptr<IClientNode>();
@@ -114,7 +121,9 @@ unsigned long ClientRegistry::registerNode(std::weak_ptr<IClientNode> node)
     if (!lockedNode){
         emitLog(LogLevel::Warning, "Trying to add node, but it is already gone. Node NOT added.");
     }
-    return m_clientNodesById.add(lockedNode);
+    auto id = m_clientNodesById.add(lockedNode);
+    m_nodeCount = m_clientNodesById.size();
+    return id;
 }
 
 void ClientRegistry::unregisterNode(unsigned long id)
@@ -129,7 +138,18 @@ void ClientRegistry::unregisterNode(unsigned long id)
         }
         lock.unlock();
         m_clientNodesById.remove(id);
+        m_nodeCount = m_clientNodesById.size();
     }
 }
 
+std::size_t ClientRegistry::objectCount() const
+{
+    return m_objectCount;
+}
+
+std::size_t ClientRegistry::nodeCount() const
+{
+    return m_nodeCount;
+}
+
 }} //namespace ApiGear::ObjectLink
@@ -4,6 +4,7 @@
 #include "core/uniqueidobjectstorage.h"
 
 #include "core/basenode.h"
+#include <atomic>
 #include <map>
 #include <vector>
 #include <mutex>
@@ -93,6 +94,14 @@ public:
     * Remove the node from registry, it will be no longer valid to use with any sink object.
     */
     void unregisterNode(unsigned long id);
+
+    /**
+    * Registry sizes, meant for monitoring. Values are kept in atomics, reading them does not lock the registry.
+    * @return number of object ids with an entry in the registry.
+    */
+    std::size_t objectCount() const;
+    /** @return number of registered client nodes. */
+    std::size_t nodeCount() const;
 private:
     /**
      * Internal structure to manage sink/node associations
@@ -112,6 +121,9 @@ private:
     std::mutex m_entriesMutex;
     /* Storage for client nodes, keeps them by Id*/
     UniqueIdObjectStorage<ApiGear::ObjectLink::IClientNode> m_clientNodesById;
+    /* Registry sizes, updated with the entries and read without locking.*/
+    std::atomic<std::size_t> m_objectCount{ 0 };
+    std::atomic<std::size_t> m_nodeCount{ 0 };
 };
 
 } } // ApiGear::ObjectLink
@@ -1,30 +1,726 @@
 #include "basenode.h"
+#include "tracepoints.h"
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 
 namespace ApiGear { namespace ObjectLink {
 
+namespace {
+
+/** @return the member or object id of a message for trace probes and the flight recorder, empty string if there is none. */
+const char* messageIdOf(const nlohmann::json& msg)
+{
+    if(!msg.is_array() || msg.size() < 2 || msg[0] == int(MsgType::CompactInvokeReply)) {
+        return "";
+    }
+    const auto& id = msg[1].is_string() ? msg[1] : msg.size() > 2 ? msg[2] : msg[1];
+    return id.is_string() ? id.get_ref<const std::string&>().c_str() : "";
+}
+
+#if OLINK_TRACE_ENABLED
+int traceRequestId(const nlohmann::json& msg)
+{
+    return msg.size() > 1 && msg[1].is_number_integer() ? msg[1].get<int>() : -1;
+}
+#endif
+
+} // namespace
+
 void BaseNode::onWrite(WriteMessageFunc func)
 {
     m_writeFunc = func;
 }
 
+void BaseNode::onWriteBuffer(WriteMessageBufferFunc func)
+{
+    m_writeBufferFunc = func;
+}
+
+const std::size_t BaseNode::minChunkSize = 64;
+
 void BaseNode::emitWrite(const nlohmann::json& msg)
 {
-    emitLog(LogLevel::Debug, "writeMessage " + msg.dump());
-    if(m_writeFunc) {
-        m_writeFunc(m_converter.toString(msg));
+    if(isLogEnabled()) {
+        emitLog(LogLevel::Debug, "writeMessage " + payloadToString(msg));
+    }
+    if(!m_writeBufferFunc && !m_writeFunc) {
+        emitLog(LogLevel::Warning, "no writer set, can not write");
+        return;
+    }
+    if(m_handshakePending && holdMessage(msg)) {
+        return;
+    }
+    writeMessage(msg);
+}
+
+void BaseNode::writeMessage(const nlohmann::json& msg)
+{
+    auto data = encode(msg);
+    const std::size_t chunkSize = m_chunkSize;
+    const bool chunked = chunkSize > 0 && m_peerAcceptsChunks && data.size() > chunkSize && framesFitChunks();
+    if(chunked) {
+        queueChunks(std::make_shared<const std::string>(std::move(data)));
     } else {
+        recordSent(messageType(msg), messageIdOf(msg), data);
+        writeFrame(std::move(data));
+    }
+    if(chunkSize > 0) {
+        continueChunks(chunked);
+    }
+}
+
+void BaseNode::emitWriteBuffer(MessageBuffer msg)
+{
+    if(!msg) {
+        return;
+    }
+    if(!m_writeBufferFunc && !m_writeFunc) {
         emitLog(LogLevel::Warning, "no writer set, can not write");
+        return;
+    }
+    // the buffer is in the current format, it is held back as message to be translated to the chosen one
+    if(m_handshakePending && holdMessage(m_converter.fromString(*msg, false))) {
+        return;
+    }
+    if(dynamic_cast<const CompressedCodec*>(m_converter.codec().get())
+        && (msg->empty() || static_cast<unsigned char>((*msg)[0]) > static_cast<unsigned char>(Compression::Zstd))) {
+        // a buffer of the plain format, e.g. encoded before compression was negotiated, is sent as uncompressed frame
+        auto framed = std::make_shared<std::string>();
+        framed->reserve(msg->size() + 1);
+        framed->push_back(static_cast<char>(Compression::None));
+        framed->append(*msg);
+        msg = std::move(framed);
+    }
+    const std::size_t chunkSize = m_chunkSize;
+    const bool chunked = chunkSize > 0 && m_peerAcceptsChunks && msg->size() > chunkSize && framesFitChunks();
+    if(chunked) {
+        queueChunks(std::move(msg));
+    } else {
+        // The type of an already encoded message is not known, it is counted with unknown types.
+        recordSent(-1, nullptr, *msg);
+        writeFrame(std::move(msg));
+    }
+    if(chunkSize > 0) {
+        continueChunks(chunked);
+    }
+}
+
+void BaseNode::recordSent(int msgType, const char* memberId, const std::string& data)
+{
+    if(m_metrics) {
+        m_metrics->recordMessageOut(msgType, data.size());
+    }
+    if(m_wireCapture) {
+        m_wireCapture->record(m_captureStream, CaptureDirection::Sent, m_converter.messageFormat(), data.data(), data.size());
+    }
+    if(m_flightRecorder) {
+        m_flightRecorder->record(CaptureDirection::Sent, m_converter.messageFormat(), msgType, memberId, data.data(), data.size());
+    }
+}
+
+void BaseNode::writeFrame(std::string data)
+{
+    if(m_writeBufferFunc) {
+        m_writeBufferFunc(std::make_shared<const std::string>(std::move(data)));
+    } else if(m_writeFunc) {
+        m_writeFunc(data);
+    }
+}
+
+void BaseNode::writeFrame(MessageBuffer data)
+{
+    if(m_writeBufferFunc) {
+        m_writeBufferFunc(std::move(data));
+    } else if(m_writeFunc) {
+        m_writeFunc(*data);
+    }
+}
+
+void BaseNode::setChunkSize(std::size_t chunkSize)
+{
+    m_chunkSize = chunkSize > 0 ? (std::max)(chunkSize, minChunkSize) : 0;
+    if(chunkSize == 0) {
+        // messages are no longer written with chunks in turns
+        writePendingChunks();
+    }
+}
+
+std::size_t BaseNode::chunkSize() const
+{
+    return m_chunkSize;
+}
+
+std::size_t BaseNode::writePendingChunks(std::size_t maxChunks)
+{
+    std::size_t written = 0;
+    while(written < maxChunks && writeNextChunk()) {
+        ++written;
+    }
+    return pendingChunkedMessages();
+}
+
+std::size_t BaseNode::pendingChunkedMessages() const
+{
+    std::lock_guard<std::mutex> lock(m_outgoingChunksMutex);
+    return m_outgoingChunks.size();
+}
+
+void BaseNode::onChunksPending(ChunksPendingFunc func)
+{
+    m_chunksPendingFunc = func;
+}
+
+void BaseNode::setMaxChunkedMessageSize(std::size_t size)
+{
+    m_maxChunkedMessageSize = size;
+}
+
+void BaseNode::setMaxChunkedTransfers(std::size_t count)
+{
+    m_maxChunkedTransfers = count;
+}
+
+void BaseNode::setMaxChunkedBytes(std::size_t size)
+{
+    m_maxChunkedBytes = size;
+}
+
+void BaseNode::queueChunks(MessageBuffer data)
+{
+    OutgoingChunks chunks;
+    chunks.data = std::move(data);
+    std::lock_guard<std::mutex> lock(m_outgoingChunksMutex);
+    chunks.transferId = m_nextTransferId;
+    m_nextTransferId = m_nextTransferId == (std::numeric_limits<int>::max)() ? 0 : m_nextTransferId + 1;
+    m_outgoingChunks.push_back(std::move(chunks));
+}
+
+bool BaseNode::writeNextChunk()
+{
+    OutgoingChunks chunks;
+    {
+        std::lock_guard<std::mutex> lock(m_outgoingChunksMutex);
+        if(m_outgoingChunks.empty()) {
+            return false;
+        }
+        chunks = std::move(m_outgoingChunks.front());
+        m_outgoingChunks.pop_front();
+    }
+    const auto& data = *chunks.data;
+    const auto begin = chunks.offset;
+    auto end = (std::min)(begin + (std::max)(m_chunkSize.load(), minChunkSize), data.size());
+    nlohmann::json part;
+    if(m_converter.messageFormat() == MessageFormat::JSON) {
+        // a string must hold whole UTF-8 characters, continuation bytes are 10xxxxxx
+        while(end < data.size() && end > begin + 1 && (static_cast<unsigned char>(data[end]) & 0xC0) == 0x80) {
+            --end;
+        }
+        part = std::string(data, begin, end - begin);
+    } else {
+        const auto bytes = reinterpret_cast<const std::uint8_t*>(data.data());
+        part = nlohmann::json::binary(std::vector<std::uint8_t>(bytes + begin, bytes + end));
+    }
+    auto frame = encode(Protocol::chunkMessage(chunks.transferId, begin, data.size(), std::move(part)));
+    recordSent(int(MsgType::Chunk), "", frame);
+    writeFrame(std::move(frame));
+    chunks.offset = end;
+    if(chunks.offset < data.size()) {
+        std::lock_guard<std::mutex> lock(m_outgoingChunksMutex);
+        m_outgoingChunks.push_back(std::move(chunks));
+    }
+    return true;
+}
+
+bool BaseNode::framesFitChunks() const
+{
+    // compressed JSON frames are no valid UTF-8, JSON chunk messages can not carry them as strings
+    return m_converter.messageFormat() != MessageFormat::JSON || !dynamic_cast<const CompressedCodec*>(m_converter.codec().get());
+}
+
+void BaseNode::continueChunks(bool queued)
+{
+    if(!m_chunksPendingFunc) {
+        // nobody writes the chunks later
+        writePendingChunks();
+        return;
+    }
+    writeNextChunk();
+    if(queued) {
+        m_chunksPendingFunc();
     }
 }
+
+void BaseNode::handleChunk(int transferId, std::size_t offset, std::size_t size, const nlohmann::json& data)
+{
+    const char* bytes = nullptr;
+    std::size_t length = 0;
+    if(data.is_binary()) {
+        bytes = reinterpret_cast<const char*>(data.get_binary().data());
+        length = data.get_binary().size();
+    } else {
+        const auto& text = data.get_ref<const std::string&>();
+        bytes = text.data();
+        length = text.size();
+    }
+    auto transfer = m_incomingChunks.find(transferId);
+    if(offset == 0) {
+        if(transfer != m_incomingChunks.end()) {
+            // the peer restarts the transfer
+            dropIncomingChunks(transfer);
+        }
+        if(size > m_maxChunkedMessageSize) {
+            emitLog(LogLevel::Warning, "chunked message of " + std::to_string(size) + " bytes exceeds the limit of "
+                    + std::to_string(m_maxChunkedMessageSize) + " bytes, dropped");
+            return;
+        }
+        if(m_incomingChunks.size() >= m_maxChunkedTransfers) {
+            emitLog(LogLevel::Warning, "chunked message of transfer " + std::to_string(transferId) + " exceeds the limit of "
+                    + std::to_string(m_maxChunkedTransfers) + " open transfers, dropped");
+            return;
+        }
+        // the buffer grows with the received data, the announced size is not trusted for allocating memory
+        transfer = m_incomingChunks.emplace(transferId, IncomingChunks()).first;
+        transfer->second.size = size;
+    } else if(transfer == m_incomingChunks.end()) {
+        // the start of the message was dropped
+        return;
+    }
+    auto& buffer = transfer->second.data;
+    if(offset != buffer.size() || size != transfer->second.size || length > size - buffer.size()) {
+        emitLog(LogLevel::Warning, "chunk at " + std::to_string(offset) + " of transfer " + std::to_string(transferId)
+                + " does not continue the message, dropped");
+        dropIncomingChunks(transfer);
+        return;
+    }
+    if(m_incomingChunkBytes >= m_maxChunkedBytes || length > m_maxChunkedBytes - m_incomingChunkBytes) {
+        emitLog(LogLevel::Warning, "chunk at " + std::to_string(offset) + " of transfer " + std::to_string(transferId)
+                + " exceeds the limit of " + std::to_string(m_maxChunkedBytes) + " bytes for reassembling messages, dropped");
+        dropIncomingChunks(transfer);
+        return;
+    }
+    buffer.append(bytes, length);
+    m_incomingChunkBytes += length;
+    if(buffer.size() < size) {
+        return;
+    }
+    const auto message = std::move(buffer);
+    m_incomingChunkBytes -= message.size();
+    m_incomingChunks.erase(transfer);
+    handleFrame(message.data(), message.size(), true);
+}
+
+void BaseNode::dropIncomingChunks(std::map<int, IncomingChunks>::iterator transfer)
+{
+    m_incomingChunkBytes -= transfer->second.data.size();
+    m_incomingChunks.erase(transfer);
+}
+
+void BaseNode::setCapabilities(NodeCapabilities capabilities)
+{
+    m_capabilities = std::move(capabilities);
+}
+
+const NodeCapabilities& BaseNode::capabilities() const
+{
+    return m_capabilities;
+}
+
+void BaseNode::startHandshake()
+{
+    if(m_handshakePending) {
+        emitLog(LogLevel::Warning, "handshake already started");
+        return;
+    }
+    // chunks of earlier messages are in the current format, they have to arrive before the peer switches
+    writePendingChunks();
+    emitWrite(Protocol::handshakeMessage(Handshake::offer(m_capabilities)));
+    m_handshakePending = true;
+}
+
+void BaseNode::cancelHandshake()
+{
+    std::lock_guard<std::recursive_mutex> lock(m_heldMessagesMutex);
+    if(!m_handshakePending) {
+        return;
+    }
+    writeHeldMessages();
+    m_handshakePending = false;
+}
+
+bool BaseNode::isHandshakePending() const
+{
+    return m_handshakePending;
+}
+
+const std::vector<std::string>& BaseNode::negotiatedFeatures() const
+{
+    return m_negotiatedFeatures;
+}
+
+bool BaseNode::hasFeature(const std::string& feature) const
+{
+    return std::find(m_negotiatedFeatures.begin(), m_negotiatedFeatures.end(), feature) != m_negotiatedFeatures.end();
+}
+
+void BaseNode::handleHandshake(const nlohmann::json& offer)
+{
+    if(m_handshakePending) {
+        emitLog(LogLevel::Error, "handshake offered by peer while own handshake is pending, only one side may start it");
+        return;
+    }
+    const auto choice = Handshake::choose(m_capabilities, offer, m_converter.messageFormat());
+    // chunks of earlier messages are in the current format, the peer switches when it receives the reply
+    writePendingChunks();
+    // the reply is the last message in the current format, also if it is sent in chunks
+    emitWrite(Protocol::handshakeReplyMessage(choice));
+    writePendingChunks();
+    applyHandshake(choice);
+}
+
+void BaseNode::handleHandshakeReply(const nlohmann::json& choice)
+{
+    // writers wait until the held messages are written in the chosen format
+    std::lock_guard<std::recursive_mutex> lock(m_heldMessagesMutex);
+    if(!m_handshakePending) {
+        emitLog(LogLevel::Warning, "handshake reply received without a pending handshake, ignored");
+        return;
+    }
+    const auto accepted = Handshake::accept(m_capabilities, choice, m_converter.messageFormat());
+    if(accepted["format"] != choice.value("format", nlohmann::json()) || accepted["features"] != choice.value("features", nlohmann::json())) {
+        emitLog(LogLevel::Warning, "handshake reply chose a format or features which were not offered, only offered ones are applied");
+    }
+    applyHandshake(accepted);
+    writeHeldMessages();
+    m_handshakePending = false;
+}
+
+void BaseNode::applyHandshake(const nlohmann::json& choice)
+{
+    auto format = m_converter.messageFormat();
+    const auto formatName = choice.find("format");
+    if(formatName != choice.end() && formatName->is_string() && !parseMessageFormat(formatName->get<std::string>(), format)) {
+        emitLog(LogLevel::Warning, "handshake chose unknown format " + formatName->get<std::string>() + ", format not changed");
+    }
+    m_negotiatedFeatures.clear();
+    std::string compressionFeature;
+    const auto features = choice.find("features");
+    if(features != choice.end() && features->is_array()) {
+        for(const auto& feature : *features) {
+            if(!feature.is_string()) {
+                continue;
+            }
+            m_negotiatedFeatures.push_back(feature.get<std::string>());
+            if(compressionFeature.empty() && Handshake::compressionOf(m_negotiatedFeatures.back()) != Compression::None) {
+                compressionFeature = m_negotiatedFeatures.back();
+            }
+        }
+    }
+    // a codec set for the chosen format is kept, e.g. a faster parser
+    auto codec = m_converter.codec();
+    const auto compressed = std::dynamic_pointer_cast<CompressedCodec>(codec);
+    if(compressed) {
+        codec = compressed->codec();
+    }
+    if(!codec || codec->format() != format) {
+        codec = IMessageCodec::create(format);
+    }
+    if(!compressionFeature.empty()) {
+        auto options = m_capabilities.compression;
+        options.algorithm = Handshake::compressionOf(compressionFeature);
+        if(compressionFeature == Handshake::zstd) {
+            options.dictionary.clear();
+        } else if(options.algorithm == Compression::Zstd) {
+            // "zstd:<dictionary id>", with the own dictionary or the one sent by the answering node
+            auto shared = Handshake::sharedDictionary(choice);
+            if(!shared.empty()) {
+                options.dictionary = std::move(shared);
+            }
+        }
+        auto compressedCodec = CompressedCodec::create(codec, options);
+        if(compressedCodec) {
+            codec = std::move(compressedCodec);
+        } else {
+            emitLog(LogLevel::Error, "compression " + compressionFeature + " chosen in handshake is not available");
+        }
+    }
+    m_converter.setCodec(std::move(codec));
+    m_compactMessages = hasFeature(Handshake::compact);
+    m_peerAcceptsChunks = hasFeature(Handshake::chunks);
+}
+
+nlohmann::json BaseNode::compactIfNegotiated(nlohmann::json&& msg) const
+{
+    return m_compactMessages ? Protocol::compactMessage(std::move(msg)) : std::move(msg);
+}
+
+bool BaseNode::holdMessage(nlohmann::json msg)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_heldMessagesMutex);
+    if(!m_handshakePending) {
+        // the handshake ended since the caller looked
+        return false;
+    }
+    m_heldMessages.push_back(std::move(msg));
+    return true;
+}
+
+void BaseNode::writeHeldMessages()
+{
+    // messages may be held again while writing, e.g. by handlers called from the writer function
+    while(!m_heldMessages.empty()) {
+        auto held = std::move(m_heldMessages);
+        m_heldMessages.clear();
+        for(const auto& msg : held) {
+            writeMessage(msg);
+        }
+    }
+}
+
 void BaseNode::setMessageFormat(MessageFormat format)
 {
     m_converter.setMessageFormat(format);
 }
 
+void BaseNode::setCodec(std::shared_ptr<IMessageCodec> codec)
+{
+    m_converter.setCodec(std::move(codec));
+}
+
+const std::shared_ptr<IMessageCodec>& BaseNode::codec() const
+{
+    return m_converter.codec();
+}
+
 void BaseNode::handleMessage(const std::string& data)
 {
-    m_protocol.handleMessage(m_converter.fromString(data), *this);
+    handleMessage(data.data(), data.size());
+}
+
+void BaseNode::handleMessage(const char* data, std::size_t size)
+{
+    OLINK_TRACE(message_receive, -1, "", size);
+    if(m_wireCapture) {
+        m_wireCapture->record(m_captureStream, CaptureDirection::Received, m_converter.messageFormat(), data, size);
+    }
+    handleFrame(data, size);
+}
+
+void BaseNode::handleFrame(const char* data, std::size_t size, bool reassembled)
+{
+    auto msg = decode(data, size, reassembled);
+    OLINK_TRACE(message_decoded, messageType(msg), messageIdOf(msg), size);
+    if(m_flightRecorder) {
+        m_flightRecorder->record(CaptureDirection::Received, m_converter.messageFormat(), messageType(msg), messageIdOf(msg), data, size);
+    }
+    if(OLINK_TRACE_ENABLED && messageType(msg) == int(MsgType::InvokeReply)) {
+        OLINK_TRACE(invoke_reply, traceRequestId(msg), messageIdOf(msg), size);
+    }
+    OLINK_TRACE(dispatch_start, messageType(msg), messageIdOf(msg), size);
+    // Payloads are moved from the message to the handlers, the message type and ids stay in place.
+    const bool handled = m_protocol.handleMessage(std::move(msg), *this);
+    OLINK_TRACE(dispatch_done, messageType(msg), messageIdOf(msg), size);
+    if (!handled) {
+        emitLog(LogLevel::Warning, "failed to handle message: " + m_protocol.lastError());
+    }
+    if(m_flightRecorder && m_dumpFlightRecorderOnError && (!handled || messageType(msg) == int(MsgType::Error))) {
+        dumpFlightRecorder(LogLevel::Error);
+    }
+}
+
+const std::shared_ptr<NodeMetrics>& BaseNode::metrics() const
+{
+    return m_metrics;
+}
+
+void BaseNode::setMetrics(std::shared_ptr<NodeMetrics> metrics)
+{
+    m_metrics = std::move(metrics);
+}
+
+void BaseNode::setSlowHandlerThreshold(std::chrono::nanoseconds threshold)
+{
+    m_slowHandlerThreshold = threshold.count() > 0 ? threshold.count() : 0;
+}
+
+std::chrono::nanoseconds BaseNode::slowHandlerThreshold() const
+{
+    return std::chrono::nanoseconds(m_slowHandlerThreshold.load());
+}
+
+std::chrono::steady_clock::time_point BaseNode::handlerStarted() const
+{
+    if(!m_metrics && m_slowHandlerThreshold.load(std::memory_order_relaxed) == 0) {
+        return std::chrono::steady_clock::time_point();
+    }
+    return std::chrono::steady_clock::now();
+}
+
+void BaseNode::handlerFinished(const char* handler, const std::string& memberId, std::chrono::steady_clock::time_point started)
+{
+    if(started == std::chrono::steady_clock::time_point()) {
+        return;
+    }
+    const auto duration = std::chrono::steady_clock::now() - started;
+    if(m_metrics) {
+        m_metrics->recordHandlerTime(duration);
+    }
+    const auto threshold = m_slowHandlerThreshold.load(std::memory_order_relaxed);
+    if(threshold == 0 || duration < std::chrono::nanoseconds(threshold)) {
+        return;
+    }
+    if(m_metrics) {
+        m_metrics->recordSlowHandler();
+    }
+    emitLog(LogLevel::Warning, "slow handler: handler=" + std::string(handler) + " member=" + memberId
+            + " duration_us=" + std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(duration).count())
+            + " threshold_us=" + std::to_string(threshold / 1000));
+}
+
+const std::shared_ptr<ObjectMetrics>& BaseNode::objectMetrics() const
+{
+    return m_objectMetrics;
+}
+
+void BaseNode::setObjectMetrics(std::shared_ptr<ObjectMetrics> metrics)
+{
+    m_objectMetrics = std::move(metrics);
+}
+
+const std::shared_ptr<MemberTraffic>& BaseNode::memberTraffic() const
+{
+    return m_memberTraffic;
+}
+
+void BaseNode::setMemberTraffic(std::shared_ptr<MemberTraffic> traffic)
+{
+    m_memberTraffic = std::move(traffic);
+}
+
+void BaseNode::setWireCapture(std::shared_ptr<WireCapture> capture)
+{
+    if(capture) {
+        m_captureStream = capture->addStream();
+    }
+    m_wireCapture = std::move(capture);
+}
+
+const std::shared_ptr<WireCapture>& BaseNode::wireCapture() const
+{
+    return m_wireCapture;
+}
+
+void BaseNode::setFlightRecorder(std::shared_ptr<FlightRecorder> recorder, bool dumpOnError)
+{
+    m_flightRecorder = std::move(recorder);
+    m_dumpFlightRecorderOnError = dumpOnError;
+}
+
+const std::shared_ptr<FlightRecorder>& BaseNode::flightRecorder() const
+{
+    return m_flightRecorder;
+}
+
+void BaseNode::dumpFlightRecorder(LogLevel level)
+{
+    if(m_flightRecorder) {
+        emitLog(level, "flight recorder, last " + std::to_string(m_flightRecorder->capacity()) + " messages:\n" + m_flightRecorder->dump());
+    }
+}
+
+nlohmann::json BaseNode::decode(const char* data, std::size_t size, bool reassembled)
+{
+    if(!m_metrics) {
+        auto msg = m_converter.fromString(data, size, false);
+        if(m_objectMetrics) {
+            m_objectMetrics->recordMessageIn(messageObjectId(msg), size);
+        }
+        return msg;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    auto msg = m_converter.fromString(data, size, false);
+    m_metrics->recordDecodeTime(std::chrono::steady_clock::now() - start);
+    if(msg.is_discarded()) {
+        m_metrics->recordDecodeError();
+    }
+    if(!reassembled) {
+        m_metrics->recordMessageIn(messageType(msg), size);
+    }
+    if(m_objectMetrics) {
+        m_objectMetrics->recordMessageIn(messageObjectId(msg), size);
+    }
+    return msg;
+}
+
+std::string BaseNode::encode(const nlohmann::json& msg)
+{
+    std::string data;
+    if(!m_metrics) {
+        data = m_converter.toString(msg);
+    } else {
+        const auto start = std::chrono::steady_clock::now();
+        data = m_converter.toString(msg);
+        m_metrics->recordEncodeTime(std::chrono::steady_clock::now() - start);
+    }
+    if(m_objectMetrics) {
+        m_objectMetrics->recordMessageOut(messageObjectId(msg), data.size());
+    }
+    if(m_memberTraffic) {
+        const auto memberId = messageMemberId(msg);
+        if(memberId) {
+            m_memberTraffic->record(*memberId, data.size());
+        }
+    }
+    OLINK_TRACE(message_write, messageType(msg), messageIdOf(msg), data.size());
+    if(OLINK_TRACE_ENABLED && messageType(msg) == int(MsgType::Invoke)) {
+        OLINK_TRACE(invoke_send, traceRequestId(msg), messageIdOf(msg), data.size());
+    }
+    return data;
+}
+
+int BaseNode::messageType(const nlohmann::json& msg)
+{
+    return msg.is_array() && !msg.empty() && msg[0].is_number_integer() ? fullMsgType(msg[0].get<int>()) : -1;
+}
+
+const std::string* BaseNode::messageMemberId(const nlohmann::json& msg)
+{
+    switch(messageType(msg)) {
+    case int(MsgType::SetProperty):
+    case int(MsgType::PropertyChange):
+    case int(MsgType::Signal):
+        return msg.size() > 1 && msg[1].is_string() ? &msg[1].get_ref<const std::string&>() : nullptr;
+    case int(MsgType::Invoke):
+        return msg.size() > 2 && msg[2].is_string() ? &msg[2].get_ref<const std::string&>() : nullptr;
+    default:
+        return nullptr;
+    }
+}
+
+std::string BaseNode::messageObjectId(const nlohmann::json& msg)
+{
+    switch(messageType(msg)) {
+    case int(MsgType::Link):
+    case int(MsgType::Unlink):
+    case int(MsgType::Init):
+        return msg.size() > 1 && msg[1].is_string() ? msg[1].get<std::string>() : std::string();
+    case int(MsgType::SetProperty):
+    case int(MsgType::PropertyChange):
+    case int(MsgType::Signal):
+        return msg.size() > 1 && msg[1].is_string() ? Name::getObjectId(msg[1].get_ref<const std::string&>()) : std::string();
+    case int(MsgType::Invoke):
+    case int(MsgType::InvokeReply):
+        // compact invoke replies carry no method id
+        return msg.size() > 2 && msg[2].is_string() && msg[0] != int(MsgType::CompactInvokeReply)
+            ? Name::getObjectId(msg[2].get_ref<const std::string&>()) : std::string();
+    default:
+        return std::string();
+    }
+}
+
+std::string BaseNode::payloadToString(const nlohmann::json& payload)
+{
+    return payload.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
 }
 
 void BaseNode::handleLink(const std::string& objectId)
@@ -39,32 +735,32 @@ void BaseNode::handleUnlink(const std::string& objectId)
 
 void BaseNode::handleInvoke(int requestId, const std::string& methodId, const nlohmann::json& args)
 {
-    emitLog(LogLevel::Warning, "not implemented " + std::string(__func__) + methodId + " args " + args.dump());
+    emitLog(LogLevel::Warning, "not implemented " + std::string(__func__) + methodId + " args " + payloadToString(args));
 }
 
 void BaseNode::handleSetProperty(const std::string& propertyId, const nlohmann::json& value)
 {
-    emitLog(LogLevel::Warning, "not implemented " + std::string(__func__) + propertyId + " value " + value.dump());
+    emitLog(LogLevel::Warning, "not implemented " + std::string(__func__) + propertyId + " value " + payloadToString(value));
 }
 
 void BaseNode::handleInit(const std::string& objectId, const nlohmann::json& props)
 {
-    emitLog(LogLevel::Warning, "not implemented " + std::string(__func__) + objectId + " props " + props.dump());
+    emitLog(LogLevel::Warning, "not implemented " + std::string(__func__) + objectId + " props " + payloadToString(props));
 }
 
 void BaseNode::handleInvokeReply(int requestId, const std::string& methodId, const nlohmann::json& value)
 {
-    emitLog(LogLevel::Warning, "not implemented " + std::string(__func__) + methodId +" requestId " + std::to_string(requestId) + " value " + value.dump());
+    emitLog(LogLevel::Warning, "not implemented " + std::string(__func__) + methodId +" requestId " + std::to_string(requestId) + " value " + payloadToString(value));
 }
 
 void BaseNode::handleSignal(const std::string& signalId, const nlohmann::json& args)
 {
-    emitLog(LogLevel::Warning, "not implemented " + std::string(__func__) + signalId + " args " + args.dump());
+    emitLog(LogLevel::Warning, "not implemented " + std::string(__func__) + signalId + " args " + payloadToString(args));
 }
 
 void BaseNode::handlePropertyChange(const std::string& propertyId, const nlohmann::json& value)
 {
-    emitLog(LogLevel::Warning, "not implemented " + std::string(__func__) + propertyId + " value " + value.dump());
+    emitLog(LogLevel::Warning, "not implemented " + std::string(__func__) + propertyId + " value " + payloadToString(value));
 }
 
 void BaseNode::handleError(int msgType, int requestId, const std::string& error)
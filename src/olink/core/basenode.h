@@ -1,10 +1,25 @@
 #pragma once
 
+#include "flightrecorder.h"
+#include "handshake.h"
+#include "membertraffic.h"
+#include "messagecodec.h"
+#include "nodemetrics.h"
+#include "objectmetrics.h"
 #include "protocol.h"
 #include "types.h"
+#include "wirecapture.h"
 #include "olink_common.h"
 #include "nlohmann/json.hpp"
+#include <atomic>
+#include <chrono>
 #include <cstring>
+#include <deque>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace ApiGear { namespace ObjectLink {
 
@@ -23,19 +38,180 @@ public:
     */
     void onWrite(WriteMessageFunc func);
     /**
+    * Alternative to onWrite(WriteMessageFunc) for network layer implementations that keep the messages after the write call,
+    * the ownership of the message buffer is passed to them. When set, it is used instead of the WriteMessageFunc.
+    */
+    void onWriteBuffer(WriteMessageBufferFunc func);
+    /**
     * Use this function to format message and send it through the network.
     * It uses the WriteMessageFunc provided by network layer implementation with onWrite(WriteMessageFunc) call.
     * @param j The data to send, translated according to chosen network message format before sending.
     */
     virtual void emitWrite(const nlohmann::json& j);
+    /**
+    * Use this function to send a message that is already translated to network format of this node.
+    * Allows fan-out of a message: translate it once with MessageConverter(node->codec()) and pass the same buffer
+    * to all the nodes using the same codec. If the node compresses frames, see CompressedCodec, buffers of the plain
+    * JSON, MessagePack or CBOR format are sent as uncompressed frames, which costs a copy. BSON buffers for such nodes
+    * have to be translated with the node's codec, their first byte can not be told apart from the compression flag.
+    * @param msg The message in network format.
+    */
+    void emitWriteBuffer(MessageBuffer msg);
 
     /**
-    * Use to change messages network format.
+    * Use to change messages network format, selects the built in codec for the format.
     */
     void setMessageFormat(MessageFormat format);
+    /**
+    * Use to translate messages with another codec than the built in ones, e.g. a faster parser.
+    * Should be set before the node starts to send and receive messages.
+    */
+    void setCodec(std::shared_ptr<IMessageCodec> codec);
+    /** @return the codec translating messages of this node. */
+    const std::shared_ptr<IMessageCodec>& codec() const;
+
+    /**
+    * Metrics of this node: message and byte counts, encode and decode times and for client nodes invoke round trip times.
+    * Messages are counted as written to and received from the network, a message sent in chunks counts as its chunk messages.
+    * The metrics are shared, so they can be read also after the node is gone.
+    * @return the metrics or nullptr if they were disabled with setMetrics.
+    */
+    const std::shared_ptr<NodeMetrics>& metrics() const;
+    /**
+    * Replaces the metrics of this node, e.g. to aggregate metrics of many nodes in one object.
+    * Use nullptr to disable measuring. Should be set before the node starts to send and receive messages.
+    */
+    void setMetrics(std::shared_ptr<NodeMetrics> metrics);
+    /**
+    * Per object traffic and invoke times, not collected by default.
+    * @return the object metrics set with setObjectMetrics or nullptr.
+    */
+    const std::shared_ptr<ObjectMetrics>& objectMetrics() const;
+    /**
+    * Starts collecting per object metrics, usually with one instance shared by all nodes of a registry.
+    * Use nullptr to stop. Should be set before the node starts to send and receive messages.
+    */
+    void setObjectMetrics(std::shared_ptr<ObjectMetrics> metrics);
+    /**
+    * Per member traffic accounting, not collected by default.
+    * @return the accounting set with setMemberTraffic or nullptr.
+    */
+    const std::shared_ptr<MemberTraffic>& memberTraffic() const;
+    /**
+    * Starts accounting of sent property changes, signals, property set requests and invoke requests per member id.
+    * Usually one instance is shared by all nodes. Use nullptr to stop.
+    * Should be set before the node starts to send messages.
+    */
+    void setMemberTraffic(std::shared_ptr<MemberTraffic> traffic);
+    /**
+    * Records all frames received and sent by this node, in network format, for later replay, e.g. with olink_replay.
+    * The node gets its own stream in the capture. Use nullptr to stop recording.
+    * Should be set before the node starts to send and receive messages.
+    */
+    void setWireCapture(std::shared_ptr<WireCapture> capture);
+    const std::shared_ptr<WireCapture>& wireCapture() const;
+    /**
+    * Keeps the last messages received and sent by this node, with type, member id, size and start of the data,
+    * for inspecting a misbehaving connection without logging every message. Not kept by default, use nullptr to stop.
+    * @param dumpOnError If true, the kept messages are logged as error when a received message can not be handled
+    *  or an error message is received.
+    */
+    void setFlightRecorder(std::shared_ptr<FlightRecorder> recorder, bool dumpOnError = true);
+    const std::shared_ptr<FlightRecorder>& flightRecorder() const;
+    /** Logs the messages kept by the flight recorder with given level, does nothing if no recorder is set. */
+    void dumpFlightRecorder(LogLevel level = LogLevel::Info);
+
+    /**
+    * Calls of sink and source handlers which take at least this time are logged as warning,
+    * naming the handler and the member id, and counted in node metrics.
+    * Handlers run in the thread which handles messages of the node, a slow handler delays all following messages.
+    * @param threshold The time from which a handler is reported, zero disables reporting. Default is 50ms.
+    */
+    void setSlowHandlerThreshold(std::chrono::nanoseconds threshold);
+    std::chrono::nanoseconds slowHandlerThreshold() const;
+
+    /** Smallest chunk size accepted by setChunkSize. */
+    static const std::size_t minChunkSize;
+    /**
+    * Sends messages which are larger than chunkSize bytes in network format as a sequence of chunk messages,
+    * each carrying at most chunkSize bytes of the message, so they do not block the connection for other messages.
+    * Without a handler set with onChunksPending all chunks are written together with the message.
+    * With the handler the first chunk is written together with the message, each following one after another message
+    * written by the node or with writePendingChunks. The receiving node reassembles the message and handles it as if it was sent at once.
+    * JSON messages are split at UTF-8 character boundaries and sent as strings, the escaping may make chunks larger.
+    * Compressed JSON frames, see CompressedCodec, are no valid UTF-8 and are always sent at once.
+    * The receiver has to support chunk messages, nodes of older versions do not.
+    * Messages may be written from several threads, the queue of chunks to send is guarded by a mutex
+    * and the chunks of a message are written in order.
+    * @param chunkSize Chunk size in bytes, 0 (default) disables chunking and writes the pending chunks,
+    *  smaller sizes are raised to minChunkSize.
+    */
+    void setChunkSize(std::size_t chunkSize);
+    std::size_t chunkSize() const;
+    /**
+    * Writes chunks of messages which are not completely sent, e.g. from an idle handler of the network layer.
+    * Chunks of several messages are written in turns.
+    * @param maxChunks Maximal number of chunks to write.
+    * @return The number of messages which still have chunks to send.
+    */
+    std::size_t writePendingChunks(std::size_t maxChunks = (std::numeric_limits<std::size_t>::max)());
+    /** @return The number of messages which still have chunks to send. */
+    std::size_t pendingChunkedMessages() const;
+    /**
+    * Lets the network layer write the chunks of large messages in turns with other messages.
+    * The function is called from the writing thread each time a message is queued for sending in chunks,
+    * the network layer then calls writePendingChunks, e.g. one chunk per turn of its event loop, until no chunks are left.
+    * Without it all chunks of a message are written at once.
+    */
+    void onChunksPending(ChunksPendingFunc func);
+    /**
+    * Limits the size of messages reassembled from received chunks. Chunks of larger messages are dropped with a warning.
+    * @param size Maximal size in bytes, default is 256 MiB.
+    */
+    void setMaxChunkedMessageSize(std::size_t size);
+    /**
+    * Limits the number of messages which are reassembled at the same time. Chunks starting more messages are dropped with a warning.
+    * @param count Maximal number of open transfers, default is 16.
+    */
+    void setMaxChunkedTransfers(std::size_t count);
+    /**
+    * Limits the memory used for reassembling messages, summed over all open transfers.
+    * The buffers grow as chunks arrive, the chunk exceeding the limit is dropped with its message and a warning.
+    * @param size Maximal size in bytes, default is 256 MiB.
+    */
+    void setMaxChunkedBytes(std::size_t size);
+
+    /**
+    * Sets the formats and features this node offers in startHandshake and accepts when answering a handshake.
+    * By default only JSON format without features is supported.
+    */
+    void setCapabilities(NodeCapabilities capabilities);
+    const NodeCapabilities& capabilities() const;
+    /**
+    * Offers the capabilities of this node to the peer, which picks the message format and features for the connection.
+    * Call it once, after the connection is open and before other messages are sent, on one side of the connection.
+    * Until the reply arrives, messages written by this node are held back and sent afterwards in the chosen format.
+    * Known features are applied by both nodes: "lz4" and "zstd" wrap the codec in a CompressedCodec,
+    * "compact" sends the compact messages of protocol v2, without "chunks" no chunked messages are sent.
+    * Peers of older versions do not reply, use cancelHandshake to continue with the current format then.
+    * Messages may be written from other threads meanwhile, they are held back as well. The node answering a handshake
+    * switches the format while handling it, it should not be written from other threads before, e.g. it has no linked objects yet.
+    */
+    void startHandshake();
+    /** Stops waiting for the handshake reply, messages held back are sent in the current format. */
+    void cancelHandshake();
+    /** @return true between startHandshake and the reply. */
+    bool isHandshakePending() const;
+    /** @return The features chosen in the handshake, empty if there was none. */
+    const std::vector<std::string>& negotiatedFeatures() const;
+    /** @return true if the feature was chosen in the handshake. */
+    bool hasFeature(const std::string& feature) const;
 
     // Implementation::IMessageHandler
+    // Malformed messages are reported with handleError and logged, no exception is thrown.
     void handleMessage(const std::string& data) override;
+    // Implementation::IMessageHandler, parses the message in place, without copying it.
+    void handleMessage(const char* data, std::size_t size) override;
 
     // Empty, logging only implementation of IProtocolListener::handleLink, should be overwritten on server side.
     void handleLink(const std::string& objectId) override;
@@ -55,13 +231,158 @@ public:
     void handlePropertyChange(const std::string& propertyId, const nlohmann::json& value) override;
     // Empty, logging only implementation of IProtocolListener::handleError, should be overwritten on both client and server side.
     void handleError(int msgType, int requestId, const std::string& error) override;
+    // Implementation of IProtocolListener::handleChunk, collects the chunks and handles the message when it is complete.
+    void handleChunk(int transferId, std::size_t offset, std::size_t size, const nlohmann::json& data) override;
+    // Implementation of IProtocolListener::handleHandshake, replies with the choice for the connection and applies it.
+    void handleHandshake(const nlohmann::json& offer) override;
+    // Implementation of IProtocolListener::handleHandshakeReply, applies the offered part of the choice and sends the held back messages.
+    // Replies without a pending handshake are ignored.
+    void handleHandshakeReply(const nlohmann::json& choice) override;
+protected:
+    /**
+    * Serializes a payload for logging purpose.
+    * Unlike nlohmann::json::dump it does not throw for payloads received from network with invalid UTF-8 strings.
+    */
+    static std::string payloadToString(const nlohmann::json& payload);
+    /**
+    * Call before a sink or source handler, with handlerFinished after it.
+    * @return start time of the handler call, or a default time point if handlers are not measured.
+    */
+    std::chrono::steady_clock::time_point handlerStarted() const;
+    /**
+    * Records the time of a handler call in node metrics and reports it if it exceeds the slow handler threshold.
+    * @param handler Name of the called handler.
+    * @param memberId Id of the member or object the handler was called for.
+    * @param started The value returned by handlerStarted.
+    */
+    void handlerFinished(const char* handler, const std::string& memberId, std::chrono::steady_clock::time_point started);
+    /**
+    * Use for messages created with Protocol before passing them to emitWrite.
+    * @return The compact variant of the message if the "compact" feature was chosen in the handshake, see Protocol::compactMessage,
+    *  otherwise the message unchanged.
+    */
+    nlohmann::json compactIfNegotiated(nlohmann::json&& msg) const;
 private:
+    /** A message which is sent in chunks. */
+    struct OutgoingChunks
+    {
+        int transferId = 0;
+        MessageBuffer data;
+        /** Size of the already sent part of data. */
+        std::size_t offset = 0;
+    };
+    /** A message which is received in chunks. */
+    struct IncomingChunks
+    {
+        /** Size of the whole message. */
+        std::size_t size = 0;
+        std::string data;
+    };
+
+    /**
+    * Decodes and dispatches a received message, without recording it in the wire capture.
+    * @param reassembled Whether the message was reassembled from chunks, which were already counted in the node metrics.
+    */
+    void handleFrame(const char* data, std::size_t size, bool reassembled = false);
+    /** Records a message in network format in the node metrics, wire capture and flight recorder, before it is written. */
+    void recordSent(int msgType, const char* memberId, const std::string& data);
+    /** Passes a message in network format to the writer function. */
+    void writeFrame(std::string data);
+    void writeFrame(MessageBuffer data);
+    /** Queues a message for sending in chunks. */
+    void queueChunks(MessageBuffer data);
+    /**
+    * Writes a chunk of the first queued message, which is queued again if it has more chunks.
+    * The message is taken from the queue while its chunk is written, so no other thread writes its next chunk before.
+    * @return false if no chunks were queued.
+    */
+    bool writeNextChunk();
+    /** @return false if the frames of the codec can not be carried by chunk messages, they are written at once then. */
+    bool framesFitChunks() const;
+    /** Writes chunks after a message was written, all of them unless a ChunksPendingFunc is set. */
+    void continueChunks(bool queued);
+    /** Removes a message which is received in chunks, its data is no longer counted in m_incomingChunkBytes. */
+    void dropIncomingChunks(std::map<int, IncomingChunks>::iterator transfer);
+    /** Switches to the format and features chosen in a handshake. */
+    void applyHandshake(const nlohmann::json& choice);
+    /** Encodes and writes a message, in chunks if it is large. */
+    void writeMessage(const nlohmann::json& msg);
+    /** @return true if the message is held back because a handshake is pending, checked under m_heldMessagesMutex. */
+    bool holdMessage(nlohmann::json msg);
+    /** Sends the messages held back during the handshake, call it with m_heldMessagesMutex locked. */
+    void writeHeldMessages();
+    /** Translates received data to a message, measured with node metrics, counted unless it was reassembled from chunks. */
+    nlohmann::json decode(const char* data, std::size_t size, bool reassembled);
+    /** Translates a message to network format, measured with node metrics. The written frames are counted by recordSent. */
+    std::string encode(const nlohmann::json& msg);
+    /** @return MsgType of a message, the v1 type for compact messages, or -1 if message is not well formed. */
+    static int messageType(const nlohmann::json& msg);
+    /** @return id of the object a message is about or empty string if message is not well formed. */
+    static std::string messageObjectId(const nlohmann::json& msg);
+    /** @return member id for property change, signal, property set and invoke messages, otherwise nullptr. */
+    static const std::string* messageMemberId(const nlohmann::json& msg);
+
     /** Function with which messages are sent through network after translation to chosen network format */
     WriteMessageFunc m_writeFunc = nullptr;
+    /** Function which takes over the messages in network format, used instead of m_writeFunc if set. */
+    WriteMessageBufferFunc m_writeBufferFunc = nullptr;
+    /** Function which schedules writePendingChunks, if not set chunks are written at once. */
+    ChunksPendingFunc m_chunksPendingFunc = nullptr;
     /** A message converter, translates messages to and from chosen network format*/
     MessageConverter m_converter = MessageFormat::JSON;
     /** ObjectLink protocol*/
     Protocol m_protocol;
+    /** Metrics of this node, may be nullptr if measuring is disabled. */
+    std::shared_ptr<NodeMetrics> m_metrics = std::make_shared<NodeMetrics>();
+    /** Per object metrics, nullptr unless set. */
+    std::shared_ptr<ObjectMetrics> m_objectMetrics;
+    /** Per member traffic accounting, nullptr unless set. */
+    std::shared_ptr<MemberTraffic> m_memberTraffic;
+    /** Capture of sent and received frames, nullptr unless set. */
+    std::shared_ptr<WireCapture> m_wireCapture;
+    /** Stream of this node in m_wireCapture. */
+    std::uint32_t m_captureStream = 0;
+    /** Recent messages, nullptr unless set. */
+    std::shared_ptr<FlightRecorder> m_flightRecorder;
+    /** Whether m_flightRecorder is dumped when message handling fails. */
+    bool m_dumpFlightRecorderOnError = true;
+    /** Threshold for reporting slow handlers in nanoseconds, 0 if disabled. */
+    std::atomic<std::int64_t> m_slowHandlerThreshold{ std::chrono::nanoseconds(std::chrono::milliseconds(50)).count() };
+    /** Chunk size for sending large messages, 0 if they are sent at once. */
+    std::atomic<std::size_t> m_chunkSize{ 0 };
+    /** Limit for messages reassembled from chunks. */
+    std::size_t m_maxChunkedMessageSize = 256 * 1024 * 1024;
+    /** Limit for the number of messages reassembled at the same time. */
+    std::size_t m_maxChunkedTransfers = 16;
+    /** Limit for the sum of m_incomingChunkBytes. */
+    std::size_t m_maxChunkedBytes = 256 * 1024 * 1024;
+    /** Size of the received parts of all messages in m_incomingChunks. */
+    std::size_t m_incomingChunkBytes = 0;
+    /** Guards m_nextTransferId and m_outgoingChunks, messages are written from many threads. */
+    mutable std::mutex m_outgoingChunksMutex;
+    /** Transfer id of the next message sent in chunks. */
+    int m_nextTransferId = 0;
+    /** Messages with chunks to send, in the order their next chunk is sent. */
+    std::deque<OutgoingChunks> m_outgoingChunks;
+    /** Received parts of chunked messages, by transfer id. */
+    std::map<int, IncomingChunks> m_incomingChunks;
+    /** Whether the peer reassembles chunked messages, cleared if the handshake did not choose "chunks". */
+    bool m_peerAcceptsChunks = true;
+    /** Formats and features offered and accepted in handshakes. */
+    NodeCapabilities m_capabilities;
+    /**
+    * Whether a handshake reply is awaited, read by all writing threads. It is cleared under m_heldMessagesMutex
+    * after the held messages are written, so no message overtakes them.
+    */
+    std::atomic<bool> m_handshakePending{ false };
+    /** Guards m_heldMessages, recursive as handlers called while writing the held messages may write. */
+    std::recursive_mutex m_heldMessagesMutex;
+    /** Messages written while the handshake reply is awaited. */
+    std::vector<nlohmann::json> m_heldMessages;
+    /** Features chosen in the handshake. */
+    std::vector<std::string> m_negotiatedFeatures;
+    /** Whether messages are sent in the compact variant of protocol v2. */
+    bool m_compactMessages = false;
 };
 
 } } // ApiGear::ObjectLink
@@ -0,0 +1,337 @@
+/*
+* MIT License
+*
+* Copyright (c) 2021 ApiGear
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "compressedcodec.h"
+#include <limits>
+#include <stdexcept>
+
+#ifdef OLINK_HAVE_LZ4
+#include <lz4.h>
+#endif
+#ifdef OLINK_HAVE_ZSTD
+#include <zdict.h>
+#include <zstd.h>
+#endif
+
+namespace ApiGear { namespace ObjectLink {
+
+namespace {
+
+/** Flag byte and uncompressed size. */
+const std::size_t compressedHeaderSize = 5;
+
+void writeSize(char* out, std::uint32_t size)
+{
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<char>((size >> (8 * i)) & 0xff);
+    }
+}
+
+std::uint32_t readSize(const char* in)
+{
+    std::uint32_t size = 0;
+    for (int i = 0; i < 4; ++i) {
+        size |= static_cast<std::uint32_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+    }
+    return size;
+}
+
+/**
+* Largest ratio of decompressed to compressed size a valid frame can have.
+* LZ4 needs a byte per 255 bytes of a match, zstd at least 4 bytes per RLE block of at most 128 KiB.
+*/
+std::size_t maxExpansion(Compression algorithm)
+{
+    return algorithm == Compression::LZ4 ? 255 : 128 * 1024 / 4;
+}
+
+/** Capacity kept by the per thread scratch buffers, larger buffers are released after use. */
+const std::size_t retainedScratchCapacity = 64 * 1024;
+
+/** Releases a scratch buffer which grew for an unusually large frame, so the memory is not kept by the thread. */
+void trimScratch(std::string& buffer)
+{
+    if (buffer.capacity() > retainedScratchCapacity) {
+        std::string().swap(buffer);
+    }
+}
+
+#ifdef OLINK_HAVE_ZSTD
+/** zstd contexts of the calling thread, reused for all frames. */
+struct ZstdContexts
+{
+    ZstdContexts()
+        : compression(ZSTD_createCCtx())
+        , decompression(ZSTD_createDCtx())
+    {}
+    ~ZstdContexts()
+    {
+        ZSTD_freeCCtx(compression);
+        ZSTD_freeDCtx(decompression);
+    }
+    ZSTD_CCtx* compression;
+    ZSTD_DCtx* decompression;
+};
+
+ZstdContexts& zstdContexts()
+{
+    thread_local ZstdContexts contexts;
+    return contexts;
+}
+#endif
+
+} // namespace
+
+std::shared_ptr<CompressedCodec> CompressedCodec::create(std::shared_ptr<IMessageCodec> codec, CompressionOptions options)
+{
+    if (!codec || !isAvailable(options.algorithm)) {
+        return nullptr;
+    }
+    auto result = std::shared_ptr<CompressedCodec>(new CompressedCodec(std::move(codec), std::move(options)));
+    if (!result->m_options.dictionary.empty()) {
+#ifdef OLINK_HAVE_ZSTD
+        const auto& dictionary = result->m_options.dictionary;
+        const int level = result->m_options.level != 0 ? result->m_options.level : ZSTD_CLEVEL_DEFAULT;
+        if (dictionaryId(dictionary) == 0) {
+            return nullptr;
+        }
+        result->m_compressionDictionary = ZSTD_createCDict(dictionary.data(), dictionary.size(), level);
+        result->m_decompressionDictionary = ZSTD_createDDict(dictionary.data(), dictionary.size());
+        if (!result->m_compressionDictionary || !result->m_decompressionDictionary) {
+            return nullptr;
+        }
+#else
+        return nullptr;
+#endif
+    }
+    return result;
+}
+
+bool CompressedCodec::isAvailable(Compression algorithm)
+{
+    switch (algorithm) {
+    case Compression::None:
+        return true;
+    case Compression::LZ4:
+#ifdef OLINK_HAVE_LZ4
+        return true;
+#else
+        return false;
+#endif
+    case Compression::Zstd:
+#ifdef OLINK_HAVE_ZSTD
+        return true;
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+std::string CompressedCodec::trainDictionary(const std::vector<std::string>& samples, std::size_t capacity)
+{
+#ifdef OLINK_HAVE_ZSTD
+    std::string content;
+    std::vector<std::size_t> sizes;
+    sizes.reserve(samples.size());
+    for (const auto& sample : samples) {
+        content += sample;
+        sizes.push_back(sample.size());
+    }
+    std::string dictionary(capacity, '\0');
+    const auto size = ZDICT_trainFromBuffer(&dictionary[0], dictionary.size(), content.data(), sizes.data(), static_cast<unsigned>(sizes.size()));
+    if (ZDICT_isError(size)) {
+        return std::string();
+    }
+    dictionary.resize(size);
+    return dictionary;
+#else
+    (void)samples;
+    (void)capacity;
+    return std::string();
+#endif
+}
+
+std::uint32_t CompressedCodec::dictionaryId(const std::string& dictionary)
+{
+#ifdef OLINK_HAVE_ZSTD
+    return ZSTD_getDictID_fromDict(dictionary.data(), dictionary.size());
+#else
+    (void)dictionary;
+    return 0;
+#endif
+}
+
+CompressedCodec::CompressedCodec(std::shared_ptr<IMessageCodec> codec, CompressionOptions options)
+    : m_codec(std::move(codec))
+    , m_options(std::move(options))
+{
+}
+
+CompressedCodec::~CompressedCodec()
+{
+#ifdef OLINK_HAVE_ZSTD
+    ZSTD_freeCDict(static_cast<ZSTD_CDict*>(m_compressionDictionary));
+    ZSTD_freeDDict(static_cast<ZSTD_DDict*>(m_decompressionDictionary));
+#endif
+}
+
+MessageFormat CompressedCodec::format() const
+{
+    return m_codec->format();
+}
+
+const std::shared_ptr<IMessageCodec>& CompressedCodec::codec() const
+{
+    return m_codec;
+}
+
+const CompressionOptions& CompressedCodec::options() const
+{
+    return m_options;
+}
+
+void CompressedCodec::encode(const nlohmann::json& msg, std::string& data)
+{
+    thread_local std::string plain;
+    m_codec->encode(msg, plain);
+    const auto algorithm = plain.size() > m_options.threshold && plain.size() <= (std::numeric_limits<std::uint32_t>::max)()
+        ? m_options.algorithm : Compression::None;
+    std::size_t compressedSize = 0;
+    switch (algorithm) {
+    case Compression::None:
+        break;
+    case Compression::LZ4: {
+#ifdef OLINK_HAVE_LZ4
+        const int bound = LZ4_compressBound(static_cast<int>(plain.size()));
+        if (bound <= 0) {
+            break;
+        }
+        data.resize(compressedHeaderSize + static_cast<std::size_t>(bound));
+        const int written = LZ4_compress_default(plain.data(), &data[compressedHeaderSize], static_cast<int>(plain.size()), bound);
+        compressedSize = written > 0 ? static_cast<std::size_t>(written) : 0;
+#endif
+        break;
+    }
+    case Compression::Zstd: {
+#ifdef OLINK_HAVE_ZSTD
+        data.resize(compressedHeaderSize + ZSTD_compressBound(plain.size()));
+        auto context = zstdContexts().compression;
+        const auto written = m_compressionDictionary
+            ? ZSTD_compress_usingCDict(context, &data[compressedHeaderSize], data.size() - compressedHeaderSize,
+                                       plain.data(), plain.size(), static_cast<const ZSTD_CDict*>(m_compressionDictionary))
+            : ZSTD_compressCCtx(context, &data[compressedHeaderSize], data.size() - compressedHeaderSize,
+                                plain.data(), plain.size(), m_options.level != 0 ? m_options.level : ZSTD_CLEVEL_DEFAULT);
+        compressedSize = ZSTD_isError(written) ? 0 : written;
+#endif
+        break;
+    }
+    }
+    if (compressedSize == 0 || compressedSize + compressedHeaderSize >= plain.size() + 1) {
+        data.assign(1, static_cast<char>(Compression::None));
+        data.append(plain);
+        trimScratch(plain);
+        return;
+    }
+    data[0] = static_cast<char>(algorithm);
+    writeSize(&data[1], static_cast<std::uint32_t>(plain.size()));
+    data.resize(compressedHeaderSize + compressedSize);
+    trimScratch(plain);
+}
+
+void CompressedCodec::decode(const char* data, std::size_t size, nlohmann::json& msg, bool allowExceptions)
+{
+    if (size == 0) {
+        reject(msg, allowExceptions, "frame without compression flag");
+        return;
+    }
+    const auto algorithm = static_cast<Compression>(static_cast<unsigned char>(data[0]));
+    if (algorithm == Compression::None) {
+        m_codec->decode(data + 1, size - 1, msg, allowExceptions);
+        return;
+    }
+    if (!isAvailable(algorithm) || size < compressedHeaderSize) {
+        reject(msg, allowExceptions, "unsupported compression " + std::to_string(static_cast<int>(algorithm)));
+        return;
+    }
+    const std::size_t plainSize = readSize(data + 1);
+    if (plainSize > m_options.maxFrameSize) {
+        reject(msg, allowExceptions, "decompressed frame size " + std::to_string(plainSize) + " exceeds the limit");
+        return;
+    }
+    // the buffer is allocated for the announced size, sizes the data can not decompress to are rejected before
+    const std::size_t compressedSize = size - compressedHeaderSize;
+    if (plainSize / maxExpansion(algorithm) > compressedSize) {
+        reject(msg, allowExceptions, "decompressed frame size " + std::to_string(plainSize) + " does not match the compressed size");
+        return;
+    }
+#ifdef OLINK_HAVE_ZSTD
+    if (algorithm == Compression::Zstd && ZSTD_getFrameContentSize(data + compressedHeaderSize, compressedSize) != plainSize) {
+        reject(msg, allowExceptions, "decompressed frame size " + std::to_string(plainSize) + " does not match the zstd frame");
+        return;
+    }
+#endif
+    thread_local std::string plain;
+    plain.resize(plainSize);
+    bool decompressed = false;
+    if (algorithm == Compression::LZ4) {
+#ifdef OLINK_HAVE_LZ4
+        const char* compressed = data + compressedHeaderSize;
+        decompressed = compressedSize <= static_cast<std::size_t>((std::numeric_limits<int>::max)())
+            && LZ4_decompress_safe(compressed, &plain[0], static_cast<int>(compressedSize), static_cast<int>(plainSize))
+               == static_cast<int>(plainSize);
+#endif
+    } else {
+#ifdef OLINK_HAVE_ZSTD
+        const char* compressed = data + compressedHeaderSize;
+        auto context = zstdContexts().decompression;
+        const auto written = m_decompressionDictionary
+            ? ZSTD_decompress_usingDDict(context, &plain[0], plainSize, compressed, compressedSize,
+                                         static_cast<const ZSTD_DDict*>(m_decompressionDictionary))
+            : ZSTD_decompressDCtx(context, &plain[0], plainSize, compressed, compressedSize);
+        decompressed = !ZSTD_isError(written) && written == plainSize;
+#endif
+    }
+    if (!decompressed) {
+        trimScratch(plain);
+        reject(msg, allowExceptions, "frame could not be decompressed");
+        return;
+    }
+    m_codec->decode(plain.data(), plain.size(), msg, allowExceptions);
+    trimScratch(plain);
+}
+
+void CompressedCodec::reject(nlohmann::json& msg, bool allowExceptions, const std::string& reason)
+{
+    msg = nlohmann::json(nlohmann::json::value_t::discarded);
+    if (allowExceptions) {
+#if NLOHMANN_JSON_VERSION_MAJOR > 3 || (NLOHMANN_JSON_VERSION_MAJOR == 3 && NLOHMANN_JSON_VERSION_MINOR >= 11)
+        throw nlohmann::json::parse_error::create(110, 0, reason, nullptr);
+#else
+        throw nlohmann::json::parse_error::create(110, 0, reason);
+#endif
+    }
+}
+
+} } // ApiGear::ObjectLink
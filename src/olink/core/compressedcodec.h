@@ -0,0 +1,119 @@
+/*
+* MIT License
+*
+* Copyright (c) 2021 ApiGear
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#pragma once
+
+#include "olink_common.h"
+#include "messagecodec.h"
+#include "nlohmann/json.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ApiGear { namespace ObjectLink {
+
+/** Compression algorithms of CompressedCodec, the values are the flag bytes of compressed frames. */
+enum class Compression : std::uint8_t
+{
+    None = 0,
+    /** LZ4, fast, available with -DOLINK_LZ4=ON. */
+    LZ4 = 1,
+    /** zstd, better ratio, supports trained dictionaries, available with -DOLINK_ZSTD=ON. */
+    Zstd = 2,
+};
+
+/**
+* Settings of a CompressedCodec.
+*/
+struct OLINK_EXPORT CompressionOptions
+{
+    Compression algorithm = Compression::LZ4;
+    /** Frames of at most this size in bytes are sent uncompressed, compressing them rarely pays off. */
+    std::size_t threshold = 256;
+    /** zstd compression level, 0 for the zstd default. Not used by LZ4. */
+    int level = 0;
+    /**
+    * A zstd dictionary trained on typical messages, see CompressedCodec::trainDictionary, empty for none.
+    * Both sides of a connection have to use the same dictionary, e.g. shipped with the application or sent at connection setup.
+    */
+    std::string dictionary;
+    /** Received frames which decompress to more than this size in bytes are rejected. */
+    std::size_t maxFrameSize = 256 * 1024 * 1024;
+};
+
+/**
+* Codec compressing the frames of another codec, for links where bytes are the bottleneck.
+* Each frame starts with a flag byte: Compression::None for frames sent as they are, frames larger than the threshold
+* are compressed and the flag is followed by the uncompressed size as 32 bit little endian number.
+* Frames which do not get smaller are sent uncompressed. Received frames are decoded whatever their flag is,
+* as long as the algorithm is available, so peers may use different algorithms and thresholds.
+* Both sides of a connection must use a CompressedCodec, it is not compatible with the plain codecs.
+* The codec is thread safe, compression contexts are kept per thread. The per thread buffers for uncompressed frames
+* keep up to 64 KiB between calls, buffers grown for larger frames are released after use.
+*/
+class OLINK_EXPORT CompressedCodec : public IMessageCodec
+{
+public:
+    /**
+    * @param codec The codec translating the messages, e.g. IMessageCodec::create(MessageFormat::JSON).
+    * @return a codec compressing the frames of given codec or nullptr if the algorithm is not available
+    *  or the dictionary is not a valid zstd dictionary.
+    */
+    static std::shared_ptr<CompressedCodec> create(std::shared_ptr<IMessageCodec> codec, CompressionOptions options);
+    /** @return true if the library was built with the algorithm, None is always available. */
+    static bool isAvailable(Compression algorithm);
+    /**
+    * Trains a zstd dictionary on sample frames, e.g. frames of captured traffic read with WireCaptureReader.
+    * Use at least a few hundred samples, the dictionary helps most for small messages sharing keys and ids.
+    * @param capacity Maximal size of the dictionary in bytes.
+    * @return the dictionary or an empty string if training failed or zstd is not available.
+    */
+    static std::string trainDictionary(const std::vector<std::string>& samples, std::size_t capacity = 16 * 1024);
+    /** @return the id of a zstd dictionary, 0 if the data is no zstd dictionary. Peers can compare ids before using one. */
+    static std::uint32_t dictionaryId(const std::string& dictionary);
+
+    CompressedCodec(const CompressedCodec&) = delete;
+    CompressedCodec& operator=(const CompressedCodec&) = delete;
+    ~CompressedCodec() override;
+    /** @return the format of the wrapped codec. */
+    MessageFormat format() const override;
+    void decode(const char* data, std::size_t size, nlohmann::json& msg, bool allowExceptions) override;
+    void encode(const nlohmann::json& msg, std::string& data) override;
+
+    const std::shared_ptr<IMessageCodec>& codec() const;
+    const CompressionOptions& options() const;
+private:
+    CompressedCodec(std::shared_ptr<IMessageCodec> codec, CompressionOptions options);
+    /** Marks the message as malformed, with an exception if allowed. */
+    static void reject(nlohmann::json& msg, bool allowExceptions, const std::string& reason);
+
+    std::shared_ptr<IMessageCodec> m_codec;
+    CompressionOptions m_options;
+    /** Digested dictionaries, ZSTD_CDict and ZSTD_DDict, nullptr without dictionary. */
+    void* m_compressionDictionary = nullptr;
+    void* m_decompressionDictionary = nullptr;
+};
+
+} } // ApiGear::ObjectLink
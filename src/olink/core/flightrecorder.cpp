@@ -0,0 +1,156 @@
+/*
+* MIT License
+*
+* Copyright (c) 2021 ApiGear
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "flightrecorder.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace ApiGear { namespace ObjectLink {
+
+const std::size_t FlightRecorder::memberIdCapacity;
+const std::size_t FlightRecorder::prefixCapacity;
+
+namespace {
+
+/** Appends a prefix of a message: text formats as text with control characters replaced, binary formats in hex. */
+void appendPrefix(std::string& out, MessageFormat format, const std::string& prefix)
+{
+    if (format == MessageFormat::JSON) {
+        for (auto c : prefix) {
+            out += (static_cast<unsigned char>(c) < 0x20 || c == 0x7f) ? '.' : c;
+        }
+        return;
+    }
+    static const char digits[] = "0123456789abcdef";
+    for (auto c : prefix) {
+        const auto byte = static_cast<unsigned char>(c);
+        out += digits[byte >> 4];
+        out += digits[byte & 0x0f];
+    }
+}
+
+} // namespace
+
+FlightRecorder::FlightRecorder(std::size_t capacity)
+    : m_slots(new Slot[std::max<std::size_t>(capacity, 1)])
+    , m_capacity(std::max<std::size_t>(capacity, 1))
+    , m_start(std::chrono::steady_clock::now())
+{
+}
+
+void FlightRecorder::record(CaptureDirection direction, MessageFormat format, int msgType, const char* memberId, const char* data, std::size_t size)
+{
+    const auto sequence = m_next.fetch_add(1, std::memory_order_relaxed);
+    auto& slot = m_slots[sequence % m_capacity];
+    slot.version.store(2 * sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count();
+    slot.msgType = msgType;
+    slot.size = static_cast<std::uint32_t>(size);
+    slot.direction = static_cast<std::uint8_t>(direction);
+    slot.format = static_cast<std::uint8_t>(format);
+    const auto memberIdLength = memberId ? std::min(std::strlen(memberId), memberIdCapacity) : 0;
+    if (memberIdLength > 0) {
+        std::memcpy(slot.memberId, memberId, memberIdLength);
+    }
+    slot.memberIdLength = static_cast<std::uint8_t>(memberIdLength);
+    const auto prefixLength = std::min(size, prefixCapacity);
+    std::memcpy(slot.prefix, data, prefixLength);
+    slot.prefixLength = static_cast<std::uint8_t>(prefixLength);
+
+    slot.version.store(2 * sequence + 2, std::memory_order_release);
+}
+
+std::vector<FlightRecord> FlightRecorder::snapshot() const
+{
+    const auto next = m_next.load(std::memory_order_acquire);
+    const auto first = next > m_capacity ? next - m_capacity : 0;
+    std::vector<FlightRecord> records;
+    records.reserve(static_cast<std::size_t>(next - first));
+    for (auto sequence = first; sequence < next; ++sequence) {
+        const auto& slot = m_slots[sequence % m_capacity];
+        const auto version = slot.version.load(std::memory_order_acquire);
+        if (version != 2 * sequence + 2) {
+            // still written or already overwritten by a newer message
+            continue;
+        }
+        FlightRecord record;
+        record.sequence = sequence;
+        record.time = std::chrono::nanoseconds(slot.time);
+        record.direction = static_cast<CaptureDirection>(slot.direction);
+        record.format = static_cast<MessageFormat>(slot.format);
+        record.msgType = slot.msgType;
+        record.size = slot.size;
+        record.memberId.assign(slot.memberId, std::min<std::size_t>(slot.memberIdLength, memberIdCapacity));
+        record.prefix.assign(slot.prefix, std::min<std::size_t>(slot.prefixLength, prefixCapacity));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.version.load(std::memory_order_relaxed) != version) {
+            continue;
+        }
+        records.push_back(std::move(record));
+    }
+    return records;
+}
+
+std::string FlightRecorder::dump() const
+{
+    std::string out;
+    for (const auto& record : snapshot()) {
+        char time[32];
+        std::snprintf(time, sizeof(time), "+%.1fus", static_cast<double>(record.time.count()) / 1000.0);
+        out += "#" + std::to_string(record.sequence) + " " + time
+            + (record.direction == CaptureDirection::Received ? " in " : " out ")
+            + (record.msgType < 0 ? std::string("?") : toString(static_cast<MsgType>(record.msgType)))
+            + " " + (record.memberId.empty() ? std::string("-") : record.memberId)
+            + " " + std::to_string(record.size) + "B ";
+        appendPrefix(out, record.format, record.prefix);
+        if (record.prefix.size() < record.size) {
+            out += "...";
+        }
+        out += "\n";
+    }
+    return out;
+}
+
+void FlightRecorder::clear()
+{
+    for (std::size_t i = 0; i < m_capacity; ++i) {
+        m_slots[i].version.store(0, std::memory_order_relaxed);
+    }
+    m_next.store(0, std::memory_order_release);
+}
+
+std::size_t FlightRecorder::capacity() const
+{
+    return m_capacity;
+}
+
+std::uint64_t FlightRecorder::recorded() const
+{
+    return m_next.load(std::memory_order_relaxed);
+}
+
+} } // ApiGear::ObjectLink
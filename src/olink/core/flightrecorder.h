@@ -0,0 +1,119 @@
+/*
+* MIT License
+*
+* Copyright (c) 2021 ApiGear
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#pragma once
+
+#include "olink_common.h"
+#include "types.h"
+#include "wirecapture.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ApiGear { namespace ObjectLink {
+
+/**
+* A message as kept by the FlightRecorder.
+*/
+struct OLINK_EXPORT FlightRecord
+{
+    /** Position of the message in the sequence of all recorded messages. */
+    std::uint64_t sequence = 0;
+    /** Time since the recorder was created. */
+    std::chrono::nanoseconds time{ 0 };
+    CaptureDirection direction = CaptureDirection::Received;
+    MessageFormat format = MessageFormat::JSON;
+    /** MsgType of the message, -1 if not known. */
+    int msgType = -1;
+    /** Member id, object id for link, unlink and init messages, cut to FlightRecorder::memberIdCapacity. */
+    std::string memberId;
+    /** Size of the whole message in network format. */
+    std::size_t size = 0;
+    /** Start of the message in network format, at most FlightRecorder::prefixCapacity bytes. */
+    std::string prefix;
+};
+
+/**
+* Keeps the last messages received and sent by a node in a fixed size ring, see BaseNode::setFlightRecorder.
+* Recording copies a few fixed size fields into the next slot, it does not allocate and does not lock.
+* Each slot is guarded by a sequence number, readers skip slots which were overwritten while they were read,
+* so the recorder can be read with snapshot or dump at any time, from any thread.
+*/
+class OLINK_EXPORT FlightRecorder
+{
+public:
+    static const std::size_t memberIdCapacity = 63;
+    static const std::size_t prefixCapacity = 64;
+
+    /** @param capacity Number of the most recent messages kept. */
+    explicit FlightRecorder(std::size_t capacity = 256);
+    FlightRecorder(const FlightRecorder&) = delete;
+    FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+    /**
+    * Records a message, overwriting the oldest one if the ring is full.
+    * @param memberId Id the message is about, may be nullptr.
+    * @param data The message in network format, only the prefix is kept.
+    */
+    void record(CaptureDirection direction, MessageFormat format, int msgType, const char* memberId, const char* data, std::size_t size);
+    /** @return the kept messages, oldest first. */
+    std::vector<FlightRecord> snapshot() const;
+    /**
+    * @return the kept messages, oldest first, one line each, e.g.
+    * "#12 +1503.2us in signal_property_change demo.Calc/total 24B [4,"demo.Calc/total",5]".
+    * Prefixes of binary formats are written in hex.
+    */
+    std::string dump() const;
+    /** Forgets all kept messages. Should not be called while messages are recorded. */
+    void clear();
+
+    std::size_t capacity() const;
+    /** @return number of messages recorded since creation or clear, including the overwritten ones. */
+    std::uint64_t recorded() const;
+private:
+    struct Slot
+    {
+        /** 0 for an empty slot, odd while the slot is written, 2 * (sequence + 1) when it holds a message. */
+        std::atomic<std::uint64_t> version{ 0 };
+        std::int64_t time = 0;
+        std::int32_t msgType = -1;
+        std::uint32_t size = 0;
+        std::uint8_t direction = 0;
+        std::uint8_t format = 0;
+        std::uint8_t memberIdLength = 0;
+        std::uint8_t prefixLength = 0;
+        char memberId[memberIdCapacity];
+        char prefix[prefixCapacity];
+    };
+
+    std::unique_ptr<Slot[]> m_slots;
+    std::size_t m_capacity;
+    std::atomic<std::uint64_t> m_next{ 0 };
+    std::chrono::steady_clock::time_point m_start;
+};
+
+} } // ApiGear::ObjectLink
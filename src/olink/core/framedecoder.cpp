@@ -0,0 +1,245 @@
+/*
+* MIT License
+*
+* Copyright (c) 2021 ApiGear
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#include "framedecoder.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace ApiGear { namespace ObjectLink {
+
+namespace {
+
+/** Maximal size of LEB128 encoded 64 bit value. */
+const std::size_t maxSizePrefixLength = 10;
+
+enum class SizePrefixState
+{
+    Complete,
+    Incomplete,
+    Invalid,
+};
+
+/**
+* Decodes the unsigned LEB128 varint size prefix of a frame.
+* @param data Bytes starting with the size prefix.
+* @param size Number of available bytes.
+* @param frameSize Set to decoded frame size, not including the prefix, if the prefix is complete.
+* @param prefixSize Set to number of bytes used by the prefix, if the prefix is complete.
+*/
+SizePrefixState decodeSizePrefix(const char* data, std::size_t size, std::size_t& frameSize, std::size_t& prefixSize)
+{
+    std::uint64_t value = 0;
+    const auto available = std::min(size, maxSizePrefixLength);
+    for (std::size_t i = 0; i < available; ++i) {
+        const auto byte = static_cast<unsigned char>(data[i]);
+        if (i == maxSizePrefixLength - 1 && byte > 1) {
+            return SizePrefixState::Invalid;
+        }
+        value |= std::uint64_t(byte & 0x7f) << (7 * i);
+        if ((byte & 0x80) == 0) {
+            if (value > std::numeric_limits<std::size_t>::max()) {
+                return SizePrefixState::Invalid;
+            }
+            frameSize = static_cast<std::size_t>(value);
+            prefixSize = i + 1;
+            return SizePrefixState::Complete;
+        }
+    }
+    return size >= maxSizePrefixLength ? SizePrefixState::Invalid : SizePrefixState::Incomplete;
+}
+
+} // namespace
+
+FrameDecoder::FrameDecoder(IMessageHandler& handler, FramingMode mode, std::size_t maxFrameSize)
+    : m_handler(handler)
+    , m_mode(mode)
+    , m_maxFrameSize(maxFrameSize)
+    , m_pendingHeaderSize(0)
+    , m_pendingFrameSize(0)
+    , m_failed(false)
+{
+}
+
+bool FrameDecoder::feed(const char* data, std::size_t size)
+{
+    if (m_failed) {
+        return false;
+    }
+    if (!m_pending.empty() && !feedPending(data, size)) {
+        return false;
+    }
+    // Either the pending frame got completed or all the data was consumed by it.
+    return feedComplete(data, size);
+}
+
+void FrameDecoder::reset()
+{
+    m_pending.clear();
+    m_pendingHeaderSize = 0;
+    m_pendingFrameSize = 0;
+    m_failed = false;
+}
+
+std::size_t FrameDecoder::pendingSize() const
+{
+    return m_pending.size();
+}
+
+std::string FrameDecoder::encodeFrame(const std::string& message, FramingMode mode)
+{
+    std::string frame;
+    if (mode == FramingMode::NewlineDelimited) {
+        frame.reserve(message.size() + 1);
+        frame.append(message);
+        frame.push_back('\n');
+        return frame;
+    }
+    frame.reserve(message.size() + maxSizePrefixLength);
+    std::uint64_t value = message.size();
+    do {
+        auto byte = static_cast<unsigned char>(value & 0x7f);
+        value >>= 7;
+        if (value != 0) {
+            byte |= 0x80;
+        }
+        frame.push_back(static_cast<char>(byte));
+    } while (value != 0);
+    frame.append(message);
+    return frame;
+}
+
+bool FrameDecoder::feedPending(const char*& data, std::size_t& size)
+{
+    if (m_mode == FramingMode::NewlineDelimited) {
+        const auto end = static_cast<const char*>(std::memchr(data, '\n', size));
+        const auto taken = end ? static_cast<std::size_t>(end - data) : size;
+        if (m_pending.size() + taken > m_maxFrameSize) {
+            return fail("frame exceeds the max frame size");
+        }
+        m_pending.append(data, taken);
+        data += taken;
+        size -= taken;
+        if (!end) {
+            return true;
+        }
+        // skip the delimiter
+        data += 1;
+        size -= 1;
+    } else {
+        while (m_pendingHeaderSize == 0 && size > 0) {
+            m_pending.push_back(*data);
+            data += 1;
+            size -= 1;
+            auto state = decodeSizePrefix(m_pending.data(), m_pending.size(), m_pendingFrameSize, m_pendingHeaderSize);
+            if (state == SizePrefixState::Invalid) {
+                return fail("invalid frame size prefix");
+            }
+            if (state == SizePrefixState::Complete && m_pendingFrameSize > m_maxFrameSize) {
+                return fail("frame exceeds the max frame size");
+            }
+        }
+        if (m_pendingHeaderSize == 0) {
+            return true;
+        }
+        const auto missing = m_pendingHeaderSize + m_pendingFrameSize - m_pending.size();
+        const auto taken = std::min(missing, size);
+        m_pending.append(data, taken);
+        data += taken;
+        size -= taken;
+        if (taken != missing) {
+            return true;
+        }
+    }
+    // Frame is complete, reset the state before handing it over, in case the handler feeds the decoder again.
+    std::string frame;
+    frame.swap(m_pending);
+    const auto headerSize = m_pendingHeaderSize;
+    m_pendingHeaderSize = 0;
+    m_pendingFrameSize = 0;
+    if (frame.size() > headerSize) {
+        m_handler.handleMessage(frame.data() + headerSize, frame.size() - headerSize);
+    }
+    return true;
+}
+
+bool FrameDecoder::feedComplete(const char*& data, std::size_t& size)
+{
+    while (size > 0) {
+        std::size_t frameSize = 0;
+        std::size_t headerSize = 0;
+        bool isComplete = false;
+        if (m_mode == FramingMode::NewlineDelimited) {
+            const auto end = static_cast<const char*>(std::memchr(data, '\n', size));
+            isComplete = end != nullptr;
+            frameSize = isComplete ? static_cast<std::size_t>(end - data) : size;
+            if (frameSize > m_maxFrameSize) {
+                return fail("frame exceeds the max frame size");
+            }
+        } else {
+            auto state = decodeSizePrefix(data, size, frameSize, headerSize);
+            if (state == SizePrefixState::Invalid) {
+                return fail("invalid frame size prefix");
+            }
+            if (state == SizePrefixState::Complete && frameSize > m_maxFrameSize) {
+                return fail("frame exceeds the max frame size");
+            }
+            isComplete = state == SizePrefixState::Complete && headerSize + frameSize <= size;
+            if (state == SizePrefixState::Complete) {
+                m_pendingHeaderSize = headerSize;
+                m_pendingFrameSize = frameSize;
+            }
+        }
+        if (!isComplete) {
+            // Keep the beginning of a frame, the rest will come with next chunks.
+            m_pending.assign(data, size);
+            data += size;
+            size = 0;
+            return true;
+        }
+        m_pendingHeaderSize = 0;
+        m_pendingFrameSize = 0;
+        if (frameSize > 0) {
+            m_handler.handleMessage(data + headerSize, frameSize);
+        }
+        // For new line delimited frames the delimiter is consumed, the size prefix is already counted in headerSize.
+        const auto consumed = headerSize + frameSize + (m_mode == FramingMode::NewlineDelimited ? 1 : 0);
+        data += consumed;
+        size -= consumed;
+    }
+    return true;
+}
+
+bool FrameDecoder::fail(const std::string& reason)
+{
+    m_failed = true;
+    m_pending.clear();
+    m_pendingHeaderSize = 0;
+    m_pendingFrameSize = 0;
+    emitLog(LogLevel::Error, "FrameDecoder: " + reason + ", stream dropped");
+    return false;
+}
+
+} } // ApiGear::ObjectLink
@@ -0,0 +1,113 @@
+/*
+* MIT License
+*
+* Copyright (c) 2021 ApiGear
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#pragma once
+
+#include "olink_common.h"
+#include "types.h"
+#include <cstddef>
+#include <string>
+
+namespace ApiGear { namespace ObjectLink {
+
+/**
+* Describes how frames are delimited on a byte stream transport, like TCP, pipes or serial links.
+*/
+enum class FramingMode
+{
+    /** Each frame is preceded with its size encoded as unsigned LEB128 varint. Works with any message format. */
+    LengthPrefixed,
+    /** Each frame is terminated with a '\n'. Works only with JSON message format, which never contains raw new line. */
+    NewlineDelimited,
+};
+
+/**
+* Incremental frame assembler for byte stream transports.
+* Accepts the stream in chunks of any size, finds the frame boundaries and passes complete frames
+* to the message handler, typically a ClientNode or a RemoteNode.
+* Frames that lie entirely inside of a chunk are passed as pointer into that chunk without copying,
+* only frames split between chunks are collected in an internal buffer.
+* Not thread safe, use one decoder per connection and feed it from one thread.
+*/
+class OLINK_EXPORT FrameDecoder : public LoggerBase
+{
+public:
+    /** Default limit for a size of a single frame. */
+    static const std::size_t defaultMaxFrameSize = 64 * 1024 * 1024;
+
+    /**
+    * ctor
+    * @param handler A handler to which complete frames are passed. Must outlive the decoder.
+    * @param mode Framing used on the stream.
+    * @param maxFrameSize Frames bigger than this size are considered a stream corruption.
+    */
+    FrameDecoder(IMessageHandler& handler, FramingMode mode = FramingMode::LengthPrefixed, std::size_t maxFrameSize = defaultMaxFrameSize);
+
+    /**
+    * Consumes next chunk of the stream. All frames completed with this chunk are passed to the handler.
+    * Empty frames are skipped, they may be used as keep alive.
+    * @param data Pointer to the received bytes, needs to be valid only for the duration of the call.
+    * @param size Number of received bytes.
+    * @return false if the stream is corrupted: a frame exceeds the max frame size or has an invalid size prefix.
+    *   Any further data is rejected until reset is called, the connection should be closed.
+    */
+    bool feed(const char* data, std::size_t size);
+    /**
+    * Drops any partially received frame and clears the error state, use when the connection is re-established.
+    */
+    void reset();
+    /** @return number of bytes of a partially received frame, that are kept in internal buffer. */
+    std::size_t pendingSize() const;
+
+    /**
+    * Puts a message into a frame, use it to prepare messages before writing them to the stream.
+    * @param message A message in network format.
+    * @param mode Framing used on the stream.
+    * @return The framed message.
+    */
+    static std::string encodeFrame(const std::string& message, FramingMode mode = FramingMode::LengthPrefixed);
+private:
+    /** Continues the frame started in previous chunks. Advances data and size by consumed bytes. */
+    bool feedPending(const char*& data, std::size_t& size);
+    /** Passes frames lying entirely within the chunk to the handler. Advances data and size by consumed bytes. */
+    bool feedComplete(const char*& data, std::size_t& size);
+    /** Marks stream as corrupted. @return always false. */
+    bool fail(const std::string& reason);
+
+    /** Handler for complete frames. */
+    IMessageHandler& m_handler;
+    /** Framing used on the stream. */
+    FramingMode m_mode;
+    /** Limit for size of a single frame. */
+    std::size_t m_maxFrameSize;
+    /** Bytes of a frame which is split between chunks, including its size prefix. */
+    std::string m_pending;
+    /** Size of the size prefix of pending frame, 0 if the prefix is not complete yet. */
+    std::size_t m_pendingHeaderSize;
+    /** Size of the pending frame, not including its size prefix. */
+    std::size_t m_pendingFrameSize;
+    /** Set when the stream is corrupted. */
+    bool m_failed;
+};
+
+} } // ApiGear::ObjectLink
@@ -0,0 +1,204 @@
+/*
+* MIT License
+*
+* Copyright (c) 2021 ApiGear
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "handshake.h"
+#include <algorithm>
+#include <cstdint>
+
+namespace ApiGear { namespace ObjectLink {
+
+const char* const Handshake::chunks = "chunks";
+const char* const Handshake::lz4 = "lz4";
+const char* const Handshake::zstd = "zstd";
+const char* const Handshake::compact = "compact";
+const char* const Handshake::batching = "batching";
+
+namespace {
+
+/** @return the names of a string array in a handshake payload, ignoring other values. */
+std::vector<std::string> namesOf(const nlohmann::json& payload, const char* key)
+{
+    std::vector<std::string> names;
+    const auto list = payload.find(key);
+    if(list == payload.end() || !list->is_array()) {
+        return names;
+    }
+    for(const auto& name : *list) {
+        if(name.is_string()) {
+            names.push_back(name.get<std::string>());
+        }
+    }
+    return names;
+}
+
+bool contains(const std::vector<std::string>& names, const std::string& name)
+{
+    return std::find(names.begin(), names.end(), name) != names.end();
+}
+
+} // namespace
+
+std::vector<std::string> Handshake::offeredFeatures(const NodeCapabilities& capabilities)
+{
+    std::vector<std::string> features;
+    for(const auto& feature : capabilities.features) {
+        const auto compression = compressionOf(feature);
+        if(compression != Compression::None && !CompressedCodec::isAvailable(compression)) {
+            continue;
+        }
+        if(feature == zstd && !capabilities.compression.dictionary.empty()) {
+            features.push_back(feature + ":" + std::to_string(CompressedCodec::dictionaryId(capabilities.compression.dictionary)));
+        } else {
+            features.push_back(feature);
+        }
+    }
+    return features;
+}
+
+nlohmann::json Handshake::offer(const NodeCapabilities& capabilities)
+{
+    auto formats = nlohmann::json::array();
+    for(auto format : capabilities.formats) {
+        formats.push_back(toString(format));
+    }
+    return {
+        { "formats", std::move(formats) },
+        { "features", offeredFeatures(capabilities) },
+    };
+}
+
+nlohmann::json Handshake::choose(const NodeCapabilities& capabilities, const nlohmann::json& offer, MessageFormat current)
+{
+    const auto offeredFormats = namesOf(offer, "formats");
+    auto format = current;
+    for(auto candidate : capabilities.formats) {
+        if(contains(offeredFormats, toString(candidate))) {
+            format = candidate;
+            break;
+        }
+    }
+    const auto offered = namesOf(offer, "features");
+    auto features = nlohmann::json::array();
+    bool compressed = false;
+    bool shared = false;
+    for(const auto& feature : offeredFeatures(capabilities)) {
+        // "zstd:<dictionary id>" is only offered with a dictionary
+        const bool share = capabilities.shareDictionary && feature.compare(0, 5, "zstd:") == 0 && contains(offered, zstd);
+        if(!contains(offered, feature) && !share) {
+            continue;
+        }
+        if(compressionOf(feature) != Compression::None) {
+            if(compressed) {
+                continue;
+            }
+            compressed = true;
+            shared = share && !contains(offered, feature);
+        }
+        features.push_back(feature);
+    }
+    nlohmann::json choice = {
+        { "format", toString(format) },
+        { "features", std::move(features) },
+    };
+    if(shared) {
+        const auto& dictionary = capabilities.compression.dictionary;
+        const auto bytes = reinterpret_cast<const std::uint8_t*>(dictionary.data());
+        std::vector<std::uint8_t> data(bytes, bytes + dictionary.size());
+        // JSON has no binary values
+        choice["dictionary"] = current == MessageFormat::JSON ? nlohmann::json(data) : nlohmann::json::binary(std::move(data));
+    }
+    return choice;
+}
+
+nlohmann::json Handshake::accept(const NodeCapabilities& capabilities, const nlohmann::json& choice, MessageFormat current)
+{
+    auto format = current;
+    const auto chosenFormat = choice.find("format");
+    for(auto candidate : capabilities.formats) {
+        if(chosenFormat != choice.end() && *chosenFormat == toString(candidate)) {
+            format = candidate;
+            break;
+        }
+    }
+    const auto offered = offeredFeatures(capabilities);
+    const bool dictionaryShared = contains(offered, zstd) && !sharedDictionary(choice).empty();
+    auto features = nlohmann::json::array();
+    bool compressed = false;
+    for(const auto& feature : namesOf(choice, "features")) {
+        const bool shared = dictionaryShared && feature.compare(0, 5, "zstd:") == 0;
+        if(!contains(offered, feature) && !shared) {
+            continue;
+        }
+        if(compressionOf(feature) != Compression::None) {
+            if(compressed) {
+                continue;
+            }
+            compressed = true;
+        }
+        features.push_back(feature);
+    }
+    nlohmann::json accepted = {
+        { "format", toString(format) },
+        { "features", std::move(features) },
+    };
+    if(dictionaryShared) {
+        accepted["dictionary"] = choice["dictionary"];
+    }
+    return accepted;
+}
+
+Compression Handshake::compressionOf(const std::string& feature)
+{
+    if(feature == lz4) {
+        return Compression::LZ4;
+    }
+    if(feature == zstd || feature.compare(0, 5, "zstd:") == 0) {
+        return Compression::Zstd;
+    }
+    return Compression::None;
+}
+
+std::string Handshake::sharedDictionary(const nlohmann::json& choice)
+{
+    const auto data = choice.find("dictionary");
+    if(data == choice.end()) {
+        return std::string();
+    }
+    std::string dictionary;
+    if(data->is_binary()) {
+        dictionary.assign(data->get_binary().begin(), data->get_binary().end());
+    } else if(data->is_array()) {
+        dictionary.reserve(data->size());
+        for(const auto& byte : *data) {
+            if(!byte.is_number_unsigned() || byte.get<unsigned>() > 0xff) {
+                return std::string();
+            }
+            dictionary.push_back(static_cast<char>(byte.get<unsigned>()));
+        }
+    }
+    const auto feature = std::string(zstd) + ":" + std::to_string(CompressedCodec::dictionaryId(dictionary));
+    return contains(namesOf(choice, "features"), feature) ? dictionary : std::string();
+}
+
+} } // ApiGear::ObjectLink
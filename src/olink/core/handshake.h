@@ -0,0 +1,115 @@
+/*
+* MIT License
+*
+* Copyright (c) 2021 ApiGear
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#pragma once
+
+#include "olink_common.h"
+#include "compressedcodec.h"
+#include "types.h"
+#include "nlohmann/json.hpp"
+#include <string>
+#include <vector>
+
+namespace ApiGear { namespace ObjectLink {
+
+/**
+* Formats and features a node offers in a handshake, see BaseNode::startHandshake.
+*/
+struct OLINK_EXPORT NodeCapabilities
+{
+    /** Supported message formats, in order of preference. */
+    std::vector<MessageFormat> formats { MessageFormat::JSON };
+    /**
+    * Supported features, in order of preference. BaseNode applies the features it knows, see Handshake,
+    * other names are negotiated for the application, e.g. "batching", see BaseNode::hasFeature.
+    */
+    std::vector<std::string> features;
+    /**
+    * Settings of the CompressedCodec used if compression is negotiated, the algorithm is chosen by the handshake.
+    * With a dictionary the "zstd" feature is offered as "zstd:<dictionary id>", so it is only chosen if the peer
+    * has the same dictionary or the dictionary is shared, see shareDictionary.
+    */
+    CompressionOptions compression;
+    /**
+    * Whether the answering node sends its zstd dictionary to peers which offer "zstd" without a dictionary.
+    * The dictionary is sent once in the handshake reply, e.g. a server ships the dictionary trained on its traffic to all clients.
+    */
+    bool shareDictionary = false;
+};
+
+/**
+* Negotiation of message format and features between two nodes.
+* The requesting node offers its formats and features, the answering node picks the first of its own formats
+* the requester supports and the features both support, in its own order of preference.
+*/
+class OLINK_EXPORT Handshake
+{
+public:
+    /** Feature name for reassembling chunked messages, see BaseNode::setChunkSize. */
+    static const char* const chunks;
+    /** Feature name for CompressedCodec with LZ4. */
+    static const char* const lz4;
+    /** Feature name for CompressedCodec with zstd. */
+    static const char* const zstd;
+    /** Feature name for the compact messages of protocol v2, see Protocol::compactMessage. */
+    static const char* const compact;
+    /** Feature name for invoke batch messages, see ClientNode::invokeRemoteBatch. */
+    static const char* const batching;
+
+    /**
+    * @return The features of capabilities which can be offered: compression features for algorithms which are not built in
+    * are left out, "zstd" gets the suffix with the dictionary id if a dictionary is set.
+    */
+    static std::vector<std::string> offeredFeatures(const NodeCapabilities& capabilities);
+    /** @return The payload of a handshake message, {"formats": [names], "features": [names]}. */
+    static nlohmann::json offer(const NodeCapabilities& capabilities);
+    /**
+    * Picks the format and features for a connection. At most one compression feature is chosen.
+    * If the answering node shares its dictionary and the offer has "zstd", "zstd:<dictionary id>" is chosen
+    * and the reply carries the dictionary, as binary value or for JSON as array of byte values.
+    * @param capabilities Capabilities of the answering node.
+    * @param offer The payload of the received handshake message.
+    * @param current The format the answering node currently uses, kept if no offered format is supported.
+    * @return The payload of the handshake reply, {"format": name, "features": [names], "dictionary": bytes}.
+    */
+    static nlohmann::json choose(const NodeCapabilities& capabilities, const nlohmann::json& offer, MessageFormat current);
+    /**
+    * Restricts a received choice to what the requesting node offered, so a peer can not switch it to anything else.
+    * @param capabilities Capabilities of the requesting node.
+    * @param choice The payload of the received handshake reply.
+    * @param current The format the requesting node currently uses, kept if the chosen one was not offered.
+    * @return The choice with the chosen format if it was offered and the offered features, at most one compression.
+    *  "zstd:<dictionary id>" is accepted for an offered "zstd" if the reply carries the dictionary.
+    */
+    static nlohmann::json accept(const NodeCapabilities& capabilities, const nlohmann::json& choice, MessageFormat current);
+    /** @return Compression of a negotiated feature, Compression::None for other features. */
+    static Compression compressionOf(const std::string& feature);
+    /**
+    * @return The dictionary sent in the payload of a handshake reply, empty if there is none
+    *  or its id does not match the chosen "zstd:<dictionary id>" feature.
+    */
+    static std::string sharedDictionary(const nlohmann::json& choice);
+};
+
+} } // ApiGear::ObjectLink
@@ -0,0 +1,160 @@
+/*
+* MIT License
+*
+* Copyright (c) 2021 ApiGear
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "membertraffic.h"
+#include <algorithm>
+
+namespace ApiGear { namespace ObjectLink {
+
+const std::size_t MemberTraffic::defaultCapacity;
+
+MemberTraffic::Summary::Summary(std::size_t capacity)
+    : m_capacity(std::max<std::size_t>(capacity, 1))
+{
+    m_heap.reserve(m_capacity);
+    m_positions.reserve(m_capacity);
+}
+
+void MemberTraffic::Summary::add(const std::string& memberId, std::uint64_t weight)
+{
+    auto found = m_positions.find(memberId);
+    if (found != m_positions.end()) {
+        m_heap[found->second].count += weight;
+        siftDown(found->second);
+        return;
+    }
+    if (m_heap.size() < m_capacity) {
+        MemberTrafficEntry entry;
+        entry.memberId = memberId;
+        entry.count = weight;
+        m_heap.push_back(entry);
+        const auto last = m_heap.size() - 1;
+        m_positions[memberId] = last;
+        auto index = last;
+        while (index > 0) {
+            const auto parent = (index - 1) / 2;
+            if (m_heap[parent].count <= m_heap[index].count) {
+                break;
+            }
+            swapEntries(parent, index);
+            index = parent;
+        }
+        return;
+    }
+    // replace the member with the lowest count
+    auto& minimal = m_heap.front();
+    m_positions.erase(minimal.memberId);
+    minimal.error = minimal.count;
+    minimal.count += weight;
+    minimal.memberId = memberId;
+    m_positions[memberId] = 0;
+    siftDown(0);
+}
+
+std::vector<MemberTrafficEntry> MemberTraffic::Summary::top(std::size_t count) const
+{
+    auto result = m_heap;
+    const auto resultSize = std::min(count, result.size());
+    std::partial_sort(result.begin(), result.begin() + resultSize, result.end(),
+        [](const MemberTrafficEntry& first, const MemberTrafficEntry& second) { return first.count > second.count; });
+    result.resize(resultSize);
+    return result;
+}
+
+std::size_t MemberTraffic::Summary::capacity() const
+{
+    return m_capacity;
+}
+
+void MemberTraffic::Summary::clear()
+{
+    m_heap.clear();
+    m_positions.clear();
+}
+
+void MemberTraffic::Summary::siftDown(std::size_t index)
+{
+    while (true) {
+        const auto left = 2 * index + 1;
+        const auto right = left + 1;
+        auto smallest = index;
+        if (left < m_heap.size() && m_heap[left].count < m_heap[smallest].count) {
+            smallest = left;
+        }
+        if (right < m_heap.size() && m_heap[right].count < m_heap[smallest].count) {
+            smallest = right;
+        }
+        if (smallest == index) {
+            return;
+        }
+        swapEntries(index, smallest);
+        index = smallest;
+    }
+}
+
+void MemberTraffic::Summary::swapEntries(std::size_t first, std::size_t second)
+{
+    std::swap(m_heap[first], m_heap[second]);
+    m_positions[m_heap[first].memberId] = first;
+    m_positions[m_heap[second].memberId] = second;
+}
+
+MemberTraffic::MemberTraffic(std::size_t capacity)
+    : m_messages(capacity)
+    , m_bytes(capacity)
+{
+}
+
+void MemberTraffic::record(const std::string& memberId, std::size_t bytes)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_messages.add(memberId, 1);
+    m_bytes.add(memberId, bytes);
+}
+
+std::vector<MemberTrafficEntry> MemberTraffic::topByMessages(std::size_t count) const
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_messages.top(count);
+}
+
+std::vector<MemberTrafficEntry> MemberTraffic::topByBytes(std::size_t count) const
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_bytes.top(count);
+}
+
+void MemberTraffic::reset()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_messages.clear();
+    m_bytes.clear();
+}
+
+std::size_t MemberTraffic::capacity() const
+{
+    return m_bytes.capacity();
+}
+
+} } // ApiGear::ObjectLink
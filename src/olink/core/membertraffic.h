@@ -0,0 +1,98 @@
+/*
+* MIT License
+*
+* Copyright (c) 2021 ApiGear
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#pragma once
+
+#include "olink_common.h"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ApiGear { namespace ObjectLink {
+
+/**
+* Estimated traffic of one member, see MemberTraffic.
+*/
+struct OLINK_EXPORT MemberTrafficEntry
+{
+    /** Member id in form "object/member". */
+    std::string memberId;
+    /** Estimated count, never lower than the real one. */
+    std::uint64_t count = 0;
+    /** Maximal overestimation of count, the real count is at least count - error. */
+    std::uint64_t error = 0;
+};
+
+/**
+* Bounded memory accounting of sent messages and bytes per member id, to find the properties, signals
+* and methods which generate the most traffic.
+* Uses the space-saving algorithm: for each of the two measures at most capacity members are tracked,
+* when a new member comes and all the slots are taken it replaces the member with the lowest count and
+* inherits its count as error. Every member with more than total/capacity of the traffic is guaranteed to be listed.
+* Safe to use from many threads, usually one instance is shared by all nodes, see BaseNode::setMemberTraffic.
+*/
+class OLINK_EXPORT MemberTraffic
+{
+public:
+    static const std::size_t defaultCapacity = 256;
+
+    explicit MemberTraffic(std::size_t capacity = defaultCapacity);
+
+    /** Counts one message for given member with its size in network format. */
+    void record(const std::string& memberId, std::size_t bytes);
+    /** @return up to count members with the highest number of messages, the highest first. */
+    std::vector<MemberTrafficEntry> topByMessages(std::size_t count) const;
+    /** @return up to count members with the highest number of bytes, the highest first. */
+    std::vector<MemberTrafficEntry> topByBytes(std::size_t count) const;
+    /** Forgets all members. */
+    void reset();
+    /** @return the maximal number of members tracked for each measure. */
+    std::size_t capacity() const;
+private:
+    /** Space-saving summary for one measure, entries are kept in a min-heap by count. */
+    class Summary
+    {
+    public:
+        explicit Summary(std::size_t capacity);
+        void add(const std::string& memberId, std::uint64_t weight);
+        std::vector<MemberTrafficEntry> top(std::size_t count) const;
+        void clear();
+        std::size_t capacity() const;
+    private:
+        void siftDown(std::size_t index);
+        void swapEntries(std::size_t first, std::size_t second);
+
+        std::size_t m_capacity;
+        std::vector<MemberTrafficEntry> m_heap;
+        std::unordered_map<std::string, std::size_t> m_positions;
+    };
+
+    mutable std::mutex m_mutex;
+    Summary m_messages;
+    Summary m_bytes;
+};
+
+} } // ApiGear::ObjectLink
@@ -0,0 +1,127 @@
+/*
+* MIT License
+*
+* Copyright (c) 2021 ApiGear
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "messagecodec.h"
+
+namespace ApiGear { namespace ObjectLink {
+
+namespace {
+
+/** Initial capacity of messages in binary formats, enough for property changes, signals and invokes with small payloads. */
+const std::size_t binaryMessageCapacity = 64;
+
+/** Prepares data for a binary encoder, which appends. */
+void resetBinary(std::string& data)
+{
+    data.clear();
+    if (data.capacity() < binaryMessageCapacity) {
+        data.reserve(binaryMessageCapacity);
+    }
+}
+
+} // namespace
+
+std::shared_ptr<IMessageCodec> IMessageCodec::create(MessageFormat format)
+{
+    static const auto json = std::make_shared<JsonCodec>();
+    static const auto bson = std::make_shared<BsonCodec>();
+    static const auto msgpack = std::make_shared<MsgPackCodec>();
+    static const auto cbor = std::make_shared<CborCodec>();
+    switch(format) {
+    case MessageFormat::JSON:
+        return json;
+    case MessageFormat::BSON:
+        return bson;
+    case MessageFormat::MSGPACK:
+        return msgpack;
+    case MessageFormat::CBOR:
+        return cbor;
+    }
+    return nullptr;
+}
+
+MessageFormat JsonCodec::format() const
+{
+    return MessageFormat::JSON;
+}
+
+void JsonCodec::decode(const char* data, std::size_t size, nlohmann::json& msg, bool allowExceptions)
+{
+    msg = nlohmann::json::parse(data, data + size, nullptr, allowExceptions);
+}
+
+void JsonCodec::encode(const nlohmann::json& msg, std::string& data)
+{
+    data = msg.dump();
+}
+
+MessageFormat BsonCodec::format() const
+{
+    return MessageFormat::BSON;
+}
+
+void BsonCodec::decode(const char* data, std::size_t size, nlohmann::json& msg, bool allowExceptions)
+{
+    msg = nlohmann::json::from_bson(data, data + size, true, allowExceptions);
+}
+
+void BsonCodec::encode(const nlohmann::json& msg, std::string& data)
+{
+    resetBinary(data);
+    nlohmann::json::to_bson(msg, data);
+}
+
+MessageFormat MsgPackCodec::format() const
+{
+    return MessageFormat::MSGPACK;
+}
+
+void MsgPackCodec::decode(const char* data, std::size_t size, nlohmann::json& msg, bool allowExceptions)
+{
+    msg = nlohmann::json::from_msgpack(data, data + size, true, allowExceptions);
+}
+
+void MsgPackCodec::encode(const nlohmann::json& msg, std::string& data)
+{
+    resetBinary(data);
+    nlohmann::json::to_msgpack(msg, data);
+}
+
+MessageFormat CborCodec::format() const
+{
+    return MessageFormat::CBOR;
+}
+
+void CborCodec::decode(const char* data, std::size_t size, nlohmann::json& msg, bool allowExceptions)
+{
+    msg = nlohmann::json::from_cbor(data, data + size, true, allowExceptions, nlohmann::json::cbor_tag_handler_t::store);
+}
+
+void CborCodec::encode(const nlohmann::json& msg, std::string& data)
+{
+    resetBinary(data);
+    nlohmann::json::to_cbor(msg, data);
+}
+
+} } // ApiGear::ObjectLink
@@ -0,0 +1,106 @@
+/*
+* MIT License
+*
+* Copyright (c) 2021 ApiGear
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#pragma once
+
+#include "olink_common.h"
+#include "types.h"
+#include "nlohmann/json.hpp"
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace ApiGear { namespace ObjectLink {
+
+/**
+* Translates protocol messages to and from their network format, see BaseNode::setCodec and MessageConverter.
+* Implement it to plug in another parser or serializer, e.g. a faster JSON parser, or a tuned nlohmann configuration.
+* The protocol layer only sees the decoded nlohmann::json messages.
+* A codec is called from the threads which send and receive messages of the nodes using it,
+* a codec shared by nodes running in different threads must be thread safe. The codecs from create are.
+*/
+class OLINK_EXPORT IMessageCodec
+{
+public:
+    virtual ~IMessageCodec() = default;
+    /**
+    * @return the network format of the data, used e.g. to label captured frames.
+    * Codecs for formats of their own return the format closest to theirs.
+    */
+    virtual MessageFormat format() const = 0;
+    /**
+    * Translates data received from network to a message.
+    * @param msg Receives the message. For malformed data it is set to a discarded value, see nlohmann::json::is_discarded.
+    * @param allowExceptions If true, malformed data results in nlohmann::json::exception instead of the discarded value.
+    */
+    virtual void decode(const char* data, std::size_t size, nlohmann::json& msg, bool allowExceptions) = 0;
+    /**
+    * Translates a message to network format.
+    * @param data Receives the message in network format, its previous content is replaced, its capacity may be reused.
+    */
+    virtual void encode(const nlohmann::json& msg, std::string& data) = 0;
+
+    /**
+    * @return the nlohmann based codec for a MessageFormat or nullptr for an unknown format.
+    * The codecs are stateless, one instance per format is shared by all users.
+    */
+    static std::shared_ptr<IMessageCodec> create(MessageFormat format);
+};
+
+/** JSON text, nlohmann::json::parse and dump. */
+class OLINK_EXPORT JsonCodec : public IMessageCodec
+{
+public:
+    MessageFormat format() const override;
+    void decode(const char* data, std::size_t size, nlohmann::json& msg, bool allowExceptions) override;
+    void encode(const nlohmann::json& msg, std::string& data) override;
+};
+
+/** BSON, note that BSON can not encode the arrays the messages are made of at top level. */
+class OLINK_EXPORT BsonCodec : public IMessageCodec
+{
+public:
+    MessageFormat format() const override;
+    void decode(const char* data, std::size_t size, nlohmann::json& msg, bool allowExceptions) override;
+    void encode(const nlohmann::json& msg, std::string& data) override;
+};
+
+/** MessagePack. */
+class OLINK_EXPORT MsgPackCodec : public IMessageCodec
+{
+public:
+    MessageFormat format() const override;
+    void decode(const char* data, std::size_t size, nlohmann::json& msg, bool allowExceptions) override;
+    void encode(const nlohmann::json& msg, std::string& data) override;
+};
+
+/** CBOR. Tagged byte strings, e.g. typed arrays, decode to binary values with the tag as subtype. */
+class OLINK_EXPORT CborCodec : public IMessageCodec
+{
+public:
+    MessageFormat format() const override;
+    void decode(const char* data, std::size_t size, nlohmann::json& msg, bool allowExceptions) override;
+    void encode(const nlohmann::json& msg, std::string& data) override;
+};
+
+} } // ApiGear::ObjectLink
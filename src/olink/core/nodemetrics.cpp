@@ -0,0 +1,237 @@
+/*
+* MIT License
+*
+* Copyright (c) 2021 ApiGear
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "nodemetrics.h"
+#include "types.h"
+
+namespace ApiGear { namespace ObjectLink {
+
+namespace {
+
+/** Durations below 2^firstBucketShift nanoseconds fall into the first bucket. */
+const unsigned firstBucketShift = 10;
+
+/** MsgType values in order of their slots. */
+const int slotMsgTypes[NodeMetrics::msgTypeSlots - 1] = {
+    int(MsgType::Handshake),
+    int(MsgType::HandshakeReply),
+    int(MsgType::Link),
+    int(MsgType::Init),
+    int(MsgType::Unlink),
+    int(MsgType::SetProperty),
+    int(MsgType::PropertyChange),
+    int(MsgType::Invoke),
+    int(MsgType::InvokeReply),
+    int(MsgType::InvokeBatch),
+    int(MsgType::InvokeBatchReply),
+    int(MsgType::Signal),
+    int(MsgType::Chunk),
+    int(MsgType::Error),
+};
+
+std::uint64_t toNanoseconds(std::chrono::nanoseconds duration)
+{
+    return duration.count() > 0 ? static_cast<std::uint64_t>(duration.count()) : 0;
+}
+
+} // namespace
+
+const std::size_t HistogramSnapshot::bucketCount;
+const std::size_t LatencyHistogram::bucketCount;
+const std::size_t NodeMetricsSnapshot::msgTypeSlots;
+const std::size_t NodeMetrics::msgTypeSlots;
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+void LatencyHistogram::record(std::chrono::nanoseconds duration)
+{
+    const auto nanoseconds = toNanoseconds(duration);
+    m_buckets[bucketIndex(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+}
+
+HistogramSnapshot LatencyHistogram::snapshot() const
+{
+    HistogramSnapshot result;
+    for (std::size_t index = 0; index < bucketCount; ++index) {
+        result.buckets[index] = m_buckets[index].load(std::memory_order_relaxed);
+    }
+    result.count = m_count.load(std::memory_order_relaxed);
+    result.sum = m_sum.load(std::memory_order_relaxed);
+    return result;
+}
+
+void LatencyHistogram::reset()
+{
+    for (auto& bucket : m_buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+}
+
+std::size_t LatencyHistogram::bucketIndex(std::uint64_t nanoseconds)
+{
+    auto scaled = nanoseconds >> firstBucketShift;
+    std::size_t index = 0;
+    while (scaled != 0 && index < bucketCount - 1) {
+        scaled >>= 1;
+        ++index;
+    }
+    return index;
+}
+
+std::uint64_t LatencyHistogram::bucketUpperBound(std::size_t index)
+{
+    return index < bucketCount - 1 ? std::uint64_t(1) << (index + firstBucketShift) : 0;
+}
+
+const MessageCounters& NodeMetricsSnapshot::forType(int msgType) const
+{
+    return perType[NodeMetrics::slotOf(msgType)];
+}
+
+MessageCounters NodeMetricsSnapshot::total() const
+{
+    MessageCounters result;
+    for (const auto& counters : perType) {
+        result.messagesIn += counters.messagesIn;
+        result.bytesIn += counters.bytesIn;
+        result.messagesOut += counters.messagesOut;
+        result.bytesOut += counters.bytesOut;
+    }
+    return result;
+}
+
+NodeMetrics::NodeMetrics()
+    : m_pendingInvokes(0)
+{
+    reset();
+}
+
+void NodeMetrics::recordMessageIn(int msgType, std::size_t bytes)
+{
+    auto& counters = m_perType[slotOf(msgType)];
+    counters.messagesIn.fetch_add(1, std::memory_order_relaxed);
+    counters.bytesIn.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void NodeMetrics::recordMessageOut(int msgType, std::size_t bytes)
+{
+    auto& counters = m_perType[slotOf(msgType)];
+    counters.messagesOut.fetch_add(1, std::memory_order_relaxed);
+    counters.bytesOut.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void NodeMetrics::recordDecodeError()
+{
+    m_decodeErrors.fetch_add(1, std::memory_order_relaxed);
+}
+
+void NodeMetrics::recordDecodeTime(std::chrono::nanoseconds duration)
+{
+    m_decodeTime.record(duration);
+}
+
+void NodeMetrics::recordEncodeTime(std::chrono::nanoseconds duration)
+{
+    m_encodeTime.record(duration);
+}
+
+void NodeMetrics::recordInvokeRoundTrip(std::chrono::nanoseconds duration)
+{
+    m_invokeRoundTrip.record(duration);
+}
+
+void NodeMetrics::setPendingInvokes(std::int64_t count)
+{
+    m_pendingInvokes.store(count, std::memory_order_relaxed);
+}
+
+void NodeMetrics::recordHandlerTime(std::chrono::nanoseconds duration)
+{
+    m_handlerTime.record(duration);
+}
+
+void NodeMetrics::recordSlowHandler()
+{
+    m_slowHandlers.fetch_add(1, std::memory_order_relaxed);
+}
+
+NodeMetricsSnapshot NodeMetrics::snapshot() const
+{
+    NodeMetricsSnapshot result;
+    for (std::size_t slot = 0; slot < msgTypeSlots; ++slot) {
+        const auto& counters = m_perType[slot];
+        result.perType[slot].messagesIn = counters.messagesIn.load(std::memory_order_relaxed);
+        result.perType[slot].bytesIn = counters.bytesIn.load(std::memory_order_relaxed);
+        result.perType[slot].messagesOut = counters.messagesOut.load(std::memory_order_relaxed);
+        result.perType[slot].bytesOut = counters.bytesOut.load(std::memory_order_relaxed);
+    }
+    result.decodeErrors = m_decodeErrors.load(std::memory_order_relaxed);
+    result.decodeTime = m_decodeTime.snapshot();
+    result.encodeTime = m_encodeTime.snapshot();
+    result.invokeRoundTrip = m_invokeRoundTrip.snapshot();
+    result.pendingInvokes = m_pendingInvokes.load(std::memory_order_relaxed);
+    result.handlerTime = m_handlerTime.snapshot();
+    result.slowHandlers = m_slowHandlers.load(std::memory_order_relaxed);
+    return result;
+}
+
+void NodeMetrics::reset()
+{
+    for (auto& counters : m_perType) {
+        counters.messagesIn.store(0, std::memory_order_relaxed);
+        counters.bytesIn.store(0, std::memory_order_relaxed);
+        counters.messagesOut.store(0, std::memory_order_relaxed);
+        counters.bytesOut.store(0, std::memory_order_relaxed);
+    }
+    m_decodeErrors.store(0, std::memory_order_relaxed);
+    m_decodeTime.reset();
+    m_encodeTime.reset();
+    m_invokeRoundTrip.reset();
+    m_handlerTime.reset();
+    m_slowHandlers.store(0, std::memory_order_relaxed);
+}
+
+std::size_t NodeMetrics::slotOf(int msgType)
+{
+    for (std::size_t slot = 0; slot < msgTypeSlots - 1; ++slot) {
+        if (slotMsgTypes[slot] == msgType) {
+            return slot;
+        }
+    }
+    return msgTypeSlots - 1;
+}
+
+int NodeMetrics::msgTypeOfSlot(std::size_t slot)
+{
+    return slot < msgTypeSlots - 1 ? slotMsgTypes[slot] : -1;
+}
+
+} } // ApiGear::ObjectLink
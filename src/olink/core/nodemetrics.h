@@ -0,0 +1,173 @@
+/*
+* MIT License
+*
+* Copyright (c) 2021 ApiGear
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#pragma once
+
+#include "olink_common.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace ApiGear { namespace ObjectLink {
+
+/**
+* Copy of a LatencyHistogram state.
+*/
+struct OLINK_EXPORT HistogramSnapshot
+{
+    static const std::size_t bucketCount = 32;
+    /** Number of samples per bucket, see LatencyHistogram::bucketUpperBound for the bucket ranges. */
+    std::array<std::uint64_t, bucketCount> buckets{};
+    /** Number of all samples. */
+    std::uint64_t count = 0;
+    /** Sum of all samples in nanoseconds. */
+    std::uint64_t sum = 0;
+};
+
+/**
+* Histogram of durations with power of two buckets, safe to record from many threads.
+* The first bucket holds durations below 1024ns, each next bucket doubles the upper bound, the last bucket is unbounded.
+*/
+class OLINK_EXPORT LatencyHistogram
+{
+public:
+    static const std::size_t bucketCount = HistogramSnapshot::bucketCount;
+
+    LatencyHistogram();
+    /** Adds one sample. */
+    void record(std::chrono::nanoseconds duration);
+    /** @return a copy of the current state. */
+    HistogramSnapshot snapshot() const;
+    /** Removes all samples. */
+    void reset();
+
+    /** @return index of the bucket for a duration given in nanoseconds. */
+    static std::size_t bucketIndex(std::uint64_t nanoseconds);
+    /** @return exclusive upper bound in nanoseconds of the bucket with given index, 0 for the last, unbounded one. */
+    static std::uint64_t bucketUpperBound(std::size_t index);
+private:
+    std::array<std::atomic<std::uint64_t>, bucketCount> m_buckets;
+    std::atomic<std::uint64_t> m_count;
+    std::atomic<std::uint64_t> m_sum;
+};
+
+/**
+* Message and byte counts for one message type and direction.
+*/
+struct OLINK_EXPORT MessageCounters
+{
+    std::uint64_t messagesIn = 0;
+    std::uint64_t bytesIn = 0;
+    std::uint64_t messagesOut = 0;
+    std::uint64_t bytesOut = 0;
+};
+
+/**
+* Copy of a NodeMetrics state, taken with NodeMetrics::snapshot.
+*/
+struct OLINK_EXPORT NodeMetricsSnapshot
+{
+    static const std::size_t msgTypeSlots = 15;
+    /** Counters per message type, use NodeMetrics::slotOf to find the slot for a MsgType. */
+    std::array<MessageCounters, msgTypeSlots> perType{};
+    /** Received messages which could not be decoded. */
+    std::uint64_t decodeErrors = 0;
+    /** Time spent translating received data to messages. */
+    HistogramSnapshot decodeTime;
+    /** Time spent translating messages to network format. */
+    HistogramSnapshot encodeTime;
+    /** Time from sending an invoke request to receiving its reply, only measured on client nodes. */
+    HistogramSnapshot invokeRoundTrip;
+    /** Number of invoke requests waiting for a reply. */
+    std::int64_t pendingInvokes = 0;
+    /** Time spent in sink and source handlers called by the node. */
+    HistogramSnapshot handlerTime;
+    /** Handler calls which took longer than the node's slow handler threshold. */
+    std::uint64_t slowHandlers = 0;
+
+    /** @return counters for given message type. */
+    const MessageCounters& forType(int msgType) const;
+    /** @return sum of counters over all message types. */
+    MessageCounters total() const;
+};
+
+/**
+* Per node instrumentation: message and byte counts per message type and direction,
+* encode and decode times, invoke round trip times and pending invokes.
+* All the counters are relaxed atomics, recording is cheap and never locks, a consistent view of
+* a single counter is guaranteed, but not across counters. Use snapshot to read the values.
+* The metrics are owned by a node with a shared pointer, so the metrics may be read after the node is gone.
+*/
+class OLINK_EXPORT NodeMetrics
+{
+public:
+    static const std::size_t msgTypeSlots = NodeMetricsSnapshot::msgTypeSlots;
+
+    NodeMetrics();
+
+    /** Counts a received message of given type with its size in network format. */
+    void recordMessageIn(int msgType, std::size_t bytes);
+    /** Counts a sent message of given type with its size in network format. */
+    void recordMessageOut(int msgType, std::size_t bytes);
+    /** Counts received data which could not be decoded. */
+    void recordDecodeError();
+    void recordDecodeTime(std::chrono::nanoseconds duration);
+    void recordEncodeTime(std::chrono::nanoseconds duration);
+    void recordInvokeRoundTrip(std::chrono::nanoseconds duration);
+    void setPendingInvokes(std::int64_t count);
+    void recordHandlerTime(std::chrono::nanoseconds duration);
+    void recordSlowHandler();
+
+    /** @return a copy of all metrics. */
+    NodeMetricsSnapshot snapshot() const;
+    /** Sets all counters to zero, except of the pending invokes gauge. */
+    void reset();
+
+    /**
+    * @return slot in which messages of given type are counted.
+    * Each MsgType has its own slot, unknown types and already encoded messages share the last one.
+    */
+    static std::size_t slotOf(int msgType);
+    /** @return message type counted in given slot, or -1 for the slot shared by unknown types. */
+    static int msgTypeOfSlot(std::size_t slot);
+private:
+    struct Counters
+    {
+        std::atomic<std::uint64_t> messagesIn;
+        std::atomic<std::uint64_t> bytesIn;
+        std::atomic<std::uint64_t> messagesOut;
+        std::atomic<std::uint64_t> bytesOut;
+    };
+    std::array<Counters, msgTypeSlots> m_perType;
+    std::atomic<std::uint64_t> m_decodeErrors;
+    LatencyHistogram m_decodeTime;
+    LatencyHistogram m_encodeTime;
+    LatencyHistogram m_invokeRoundTrip;
+    std::atomic<std::int64_t> m_pendingInvokes;
+    LatencyHistogram m_handlerTime;
+    std::atomic<std::uint64_t> m_slowHandlers;
+};
+
+} } // ApiGear::ObjectLink
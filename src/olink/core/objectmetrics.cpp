@@ -0,0 +1,115 @@
+/*
+* MIT License
+*
+* Copyright (c) 2021 ApiGear
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "objectmetrics.h"
+#include <mutex>
+
+namespace ApiGear { namespace ObjectLink {
+
+const std::size_t ObjectMetrics::defaultMaxObjects;
+
+ObjectMetrics::ObjectMetrics(std::size_t maxObjects)
+    : m_maxObjects(maxObjects)
+{
+}
+
+void ObjectMetrics::recordMessageIn(const std::string& objectId, std::size_t bytes)
+{
+    if (objectId.empty()) {
+        return;
+    }
+    auto& counters = entry(objectId);
+    counters.messagesIn.fetch_add(1, std::memory_order_relaxed);
+    counters.bytesIn.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void ObjectMetrics::recordMessageOut(const std::string& objectId, std::size_t bytes)
+{
+    if (objectId.empty()) {
+        return;
+    }
+    auto& counters = entry(objectId);
+    counters.messagesOut.fetch_add(1, std::memory_order_relaxed);
+    counters.bytesOut.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void ObjectMetrics::recordInvokeRoundTrip(const std::string& objectId, std::chrono::nanoseconds duration)
+{
+    if (objectId.empty()) {
+        return;
+    }
+    entry(objectId).invokeRoundTrip.record(duration);
+}
+
+std::vector<ObjectMetricsSnapshot> ObjectMetrics::snapshot() const
+{
+    std::shared_lock<std::shared_timed_mutex> lock(m_entriesMutex);
+    std::vector<ObjectMetricsSnapshot> result;
+    result.reserve(m_entries.size());
+    for (const auto& entry : m_entries) {
+        ObjectMetricsSnapshot object;
+        object.objectId = entry.first;
+        object.traffic.messagesIn = entry.second->messagesIn.load(std::memory_order_relaxed);
+        object.traffic.bytesIn = entry.second->bytesIn.load(std::memory_order_relaxed);
+        object.traffic.messagesOut = entry.second->messagesOut.load(std::memory_order_relaxed);
+        object.traffic.bytesOut = entry.second->bytesOut.load(std::memory_order_relaxed);
+        object.invokeRoundTrip = entry.second->invokeRoundTrip.snapshot();
+        result.push_back(std::move(object));
+    }
+    return result;
+}
+
+void ObjectMetrics::reset()
+{
+    // entries are not removed, recording threads may still use them
+    std::shared_lock<std::shared_timed_mutex> lock(m_entriesMutex);
+    for (auto& entry : m_entries) {
+        entry.second->messagesIn.store(0, std::memory_order_relaxed);
+        entry.second->bytesIn.store(0, std::memory_order_relaxed);
+        entry.second->messagesOut.store(0, std::memory_order_relaxed);
+        entry.second->bytesOut.store(0, std::memory_order_relaxed);
+        entry.second->invokeRoundTrip.reset();
+    }
+}
+
+ObjectMetrics::Entry& ObjectMetrics::entry(const std::string& objectId)
+{
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(m_entriesMutex);
+        auto found = m_entries.find(objectId);
+        if (found != m_entries.end()) {
+            return *found->second;
+        }
+    }
+    std::unique_lock<std::shared_timed_mutex> lock(m_entriesMutex);
+    // the entry with empty id collects objects above the limit, it is not counted in the limit
+    const auto& id = m_entries.size() < m_maxObjects + (m_entries.count(std::string()) ? 1 : 0) ? objectId : std::string();
+    auto& entry = m_entries[id];
+    if (!entry) {
+        entry.reset(new Entry());
+    }
+    return *entry;
+}
+
+} } // ApiGear::ObjectLink
@@ -0,0 +1,94 @@
+/*
+* MIT License
+*
+* Copyright (c) 2021 ApiGear
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#pragma once
+
+#include "nodemetrics.h"
+#include "olink_common.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ApiGear { namespace ObjectLink {
+
+/**
+* Copy of the metrics of one object.
+*/
+struct OLINK_EXPORT ObjectMetricsSnapshot
+{
+    /** The object id, empty for the entry which collects objects above ObjectMetrics capacity. */
+    std::string objectId;
+    /** Messages and bytes for the object, not split by the message type. */
+    MessageCounters traffic;
+    /** Time from sending an invoke request for a method of the object to receiving its reply. */
+    HistogramSnapshot invokeRoundTrip;
+};
+
+/**
+* Traffic and invoke round trip times per object id.
+* Usually one instance is shared by all the nodes of a registry, see BaseNode::setObjectMetrics.
+* Entries are found under a reader lock and updated with relaxed atomics, a writer lock is only taken
+* when an object is seen for the first time. The lock is not shared with the registries.
+* The number of objects is limited, as object ids come from the network. Objects above the limit
+* are counted together in an entry with empty object id. Records for an empty object id are ignored.
+*/
+class OLINK_EXPORT ObjectMetrics
+{
+public:
+    static const std::size_t defaultMaxObjects = 1024;
+
+    explicit ObjectMetrics(std::size_t maxObjects = defaultMaxObjects);
+
+    /** Counts a received message for given object with its size in network format. */
+    void recordMessageIn(const std::string& objectId, std::size_t bytes);
+    /** Counts a sent message for given object with its size in network format. */
+    void recordMessageOut(const std::string& objectId, std::size_t bytes);
+    void recordInvokeRoundTrip(const std::string& objectId, std::chrono::nanoseconds duration);
+
+    /** @return copy of the metrics of all seen objects. */
+    std::vector<ObjectMetricsSnapshot> snapshot() const;
+    /** Sets all counters to zero, the seen objects are kept. */
+    void reset();
+private:
+    struct Entry
+    {
+        std::atomic<std::uint64_t> messagesIn{ 0 };
+        std::atomic<std::uint64_t> bytesIn{ 0 };
+        std::atomic<std::uint64_t> messagesOut{ 0 };
+        std::atomic<std::uint64_t> bytesOut{ 0 };
+        LatencyHistogram invokeRoundTrip;
+    };
+    /** @return the entry for objectId, created if needed. */
+    Entry& entry(const std::string& objectId);
+
+    const std::size_t m_maxObjects;
+    mutable std::shared_timed_mutex m_entriesMutex;
+    std::unordered_map<std::string, std::unique_ptr<Entry>> m_entries;
+};
+
+} } // ApiGear::ObjectLink
@@ -25,10 +25,13 @@
 #include "protocol.h"
 #include "nlohmann/json.hpp"
 #include <string>
+#include <type_traits>
 
 
 namespace ApiGear { namespace ObjectLink {
 
+const int Protocol::oneWayRequestId = -1;
+
 nlohmann::json Protocol::linkMessage(const std::string& objectId)
 {
     return nlohmann::json::array(
@@ -50,6 +53,13 @@ nlohmann::json Protocol::initMessage(const std::string& objectId, const nlohmann
                 );
 }
 
+nlohmann::json Protocol::initMessage(const std::string& objectId, nlohmann::json&& props)
+{
+    return nlohmann::json::array(
+                { MsgType::Init, objectId, std::move(props) }
+                );
+}
+
 nlohmann::json Protocol::setPropertyMessage(const std::string& propertyId, const nlohmann::json& value)
 {
     return nlohmann::json::array(
@@ -58,6 +68,13 @@ nlohmann::json Protocol::setPropertyMessage(const std::string& propertyId, const
 
 }
 
+nlohmann::json Protocol::setPropertyMessage(const std::string& propertyId, nlohmann::json&& value)
+{
+    return nlohmann::json::array(
+                { MsgType::SetProperty, propertyId, std::move(value) }
+                );
+}
+
 nlohmann::json Protocol::propertyChangeMessage(const std::string& propertyId, const nlohmann::json& value)
 {
     return nlohmann::json::array(
@@ -65,6 +82,13 @@ nlohmann::json Protocol::propertyChangeMessage(const std::string& propertyId, co
                 );
 }
 
+nlohmann::json Protocol::propertyChangeMessage(const std::string& propertyId, nlohmann::json&& value)
+{
+    return nlohmann::json::array(
+                { MsgType::PropertyChange, propertyId, std::move(value) }
+                );
+}
+
 nlohmann::json Protocol::invokeMessage(int requestId, const std::string& methodId, const nlohmann::json& args)
 {
     return nlohmann::json::array(
@@ -72,6 +96,13 @@ nlohmann::json Protocol::invokeMessage(int requestId, const std::string& methodI
                 );
 }
 
+nlohmann::json Protocol::invokeMessage(int requestId, const std::string& methodId, nlohmann::json&& args)
+{
+    return nlohmann::json::array(
+                { MsgType::Invoke, requestId, methodId, std::move(args) }
+                );
+}
+
 nlohmann::json Protocol::invokeReplyMessage(int requestId, const std::string& methodId, const nlohmann::json& value)
 {
     return nlohmann::json::array(
@@ -79,6 +110,27 @@ nlohmann::json Protocol::invokeReplyMessage(int requestId, const std::string& me
                 );
 }
 
+nlohmann::json Protocol::invokeReplyMessage(int requestId, const std::string& methodId, nlohmann::json&& value)
+{
+    return nlohmann::json::array(
+                { MsgType::InvokeReply, requestId, methodId, std::move(value) }
+                );
+}
+
+nlohmann::json Protocol::invokeBatchMessage(nlohmann::json&& calls)
+{
+    return nlohmann::json::array(
+                { MsgType::InvokeBatch, std::move(calls) }
+                );
+}
+
+nlohmann::json Protocol::invokeBatchReplyMessage(nlohmann::json&& replies)
+{
+    return nlohmann::json::array(
+                { MsgType::InvokeBatchReply, std::move(replies) }
+                );
+}
+
 nlohmann::json Protocol::signalMessage(const std::string& signalId , const nlohmann::json& args)
 {
     return nlohmann::json::array(
@@ -86,6 +138,13 @@ nlohmann::json Protocol::signalMessage(const std::string& signalId , const nlohm
                 );
 }
 
+nlohmann::json Protocol::signalMessage(const std::string& signalId , nlohmann::json&& args)
+{
+    return nlohmann::json::array(
+                { MsgType::Signal, signalId, std::move(args) }
+                );
+}
+
 nlohmann::json Protocol::errorMessage(MsgType msgType, int requestId, const std::string& error)
 {
     return nlohmann::json::array(
@@ -93,77 +152,399 @@ nlohmann::json Protocol::errorMessage(MsgType msgType, int requestId, const std:
                 );
 }
 
-bool Protocol::handleMessage(const nlohmann::json& msg, IProtocolListener& listener) {
+nlohmann::json Protocol::chunkMessage(int transferId, std::size_t offset, std::size_t size, nlohmann::json&& data)
+{
+    return nlohmann::json::array(
+                { MsgType::Chunk, transferId, offset, size, std::move(data) }
+                );
+}
 
-    m_lastError = "";
-    if(!msg.is_array()) {
-        m_lastError = "message must be array";
+nlohmann::json Protocol::handshakeMessage(const nlohmann::json& offer)
+{
+    return nlohmann::json::array(
+                { MsgType::Handshake, offer }
+                );
+}
+
+nlohmann::json Protocol::handshakeReplyMessage(const nlohmann::json& choice)
+{
+    return nlohmann::json::array(
+                { MsgType::HandshakeReply, choice }
+                );
+}
+
+namespace {
+
+/** Removes the last field of a message if it has the value which is assumed when it is omitted. */
+void omitDefault(nlohmann::json& msg, std::size_t index, const nlohmann::json& omitted)
+{
+    if(msg.size() == index + 1 && msg[index] == omitted) {
+        msg.erase(index);
+    }
+}
+
+} // namespace
+
+nlohmann::json Protocol::compactMessage(nlohmann::json&& msg)
+{
+    if(!msg.is_array() || msg.empty() || !msg[0].is_number_integer()) {
+        return std::move(msg);
+    }
+    switch(msg[0].get<int>()) {
+    case int(MsgType::Link):
+        msg[0] = MsgType::CompactLink;
+        break;
+    case int(MsgType::Unlink):
+        msg[0] = MsgType::CompactUnlink;
+        break;
+    case int(MsgType::Init):
+        msg[0] = MsgType::CompactInit;
+        omitDefault(msg, 2, nlohmann::json::object());
+        break;
+    case int(MsgType::SetProperty):
+        msg[0] = MsgType::CompactSetProperty;
+        break;
+    case int(MsgType::PropertyChange):
+        msg[0] = MsgType::CompactPropertyChange;
+        break;
+    case int(MsgType::Invoke):
+        msg[0] = MsgType::CompactInvoke;
+        omitDefault(msg, 3, nlohmann::json::array());
+        break;
+    case int(MsgType::InvokeReply):
+        if(msg.size() > 2) {
+            msg[0] = MsgType::CompactInvokeReply;
+            msg.erase(2);
+            omitDefault(msg, 2, nullptr);
+        }
+        break;
+    case int(MsgType::InvokeBatch):
+        if(msg.size() > 1 && msg[1].is_array()) {
+            msg[0] = MsgType::CompactInvokeBatch;
+            for(auto& call : msg[1]) {
+                omitDefault(call, 2, nlohmann::json::array());
+            }
+        }
+        break;
+    case int(MsgType::InvokeBatchReply):
+        if(msg.size() > 1 && msg[1].is_array()) {
+            msg[0] = MsgType::CompactInvokeBatchReply;
+            for(auto& reply : msg[1]) {
+                if(reply.is_array() && reply.size() > 1) {
+                    reply.erase(1);
+                    omitDefault(reply, 1, nullptr);
+                }
+            }
+        }
+        break;
+    case int(MsgType::Signal):
+        msg[0] = MsgType::CompactSignal;
+        omitDefault(msg, 2, nlohmann::json::array());
+        break;
+    case int(MsgType::Error):
+        if(msg.size() > 1) {
+            auto msgType = std::move(msg[1]);
+            msg[0] = MsgType::CompactError;
+            msg.erase(1);
+            if(msgType != int(MsgType::Invoke)) {
+                msg.push_back(std::move(msgType));
+            }
+        }
+        break;
+    }
+    return std::move(msg);
+}
+
+namespace {
+
+/**
+* Payload type passed to the listener for given Message type:
+* const reference for messages kept by the caller, rvalue reference for messages handed over.
+*/
+template<typename Message>
+using PayloadRef = typename std::conditional<std::is_lvalue_reference<Message>::value,
+                                             const nlohmann::json&,
+                                             nlohmann::json&&>::type;
+
+/** Passes a message element on either as a const reference or as an rvalue, depending on Message. */
+template<typename Message, typename Element>
+PayloadRef<Message> forwardPayload(Element& element)
+{
+    return static_cast<PayloadRef<Message>>(element);
+}
+
+/**
+* Checks the entries of an invoke batch or batch reply message.
+* @param idIndex Index of the methodId in an entry, -1 for compact replies which have none.
+* @param minSize Minimal number of fields of an entry.
+*/
+bool checkBatchEntries(const nlohmann::json& entries, int idIndex, std::size_t minSize)
+{
+    if(!entries.is_array()) {
         return false;
     }
-    const int msgType = msg[0].get<int>();
+    for(const auto& entry : entries) {
+        if(!entry.is_array() || entry.size() < minSize || !entry[0].is_number_integer()
+                || (idIndex > 0 && !entry[idIndex].is_string())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+* Checks that the message has all the fields required for its type and that they have expected types.
+* Additional trailing fields are allowed.
+* @return nullptr for a well formed message, otherwise a description of the problem.
+*/
+const char* checkMessageShape(const nlohmann::json& msg, int msgType)
+{
+    switch(msgType) {
+    case int(MsgType::Handshake):
+    case int(MsgType::HandshakeReply):
+        return msg.size() < 2 || !msg[1].is_object()
+            ? "expected [msgType, {capabilities}]" : nullptr;
+    case int(MsgType::Link):
+    case int(MsgType::Unlink):
+    case int(MsgType::CompactLink):
+    case int(MsgType::CompactUnlink):
+        return msg.size() < 2 || !msg[1].is_string()
+            ? "expected [msgType, objectId]" : nullptr;
+    case int(MsgType::Init):
+    case int(MsgType::SetProperty):
+    case int(MsgType::PropertyChange):
+    case int(MsgType::Signal):
+    case int(MsgType::CompactSetProperty):
+    case int(MsgType::CompactPropertyChange):
+        return msg.size() < 3 || !msg[1].is_string()
+            ? "expected [msgType, id, payload]" : nullptr;
+    case int(MsgType::CompactInit):
+    case int(MsgType::CompactSignal):
+        return msg.size() < 2 || !msg[1].is_string()
+            ? "expected [msgType, id, optional payload]" : nullptr;
+    case int(MsgType::Invoke):
+    case int(MsgType::InvokeReply):
+        return msg.size() < 4 || !msg[1].is_number_integer() || !msg[2].is_string()
+            ? "expected [msgType, requestId, methodId, payload]" : nullptr;
+    case int(MsgType::CompactInvoke):
+        return msg.size() < 3 || !msg[1].is_number_integer() || !msg[2].is_string()
+            ? "expected [msgType, requestId, methodId, optional payload]" : nullptr;
+    case int(MsgType::CompactInvokeReply):
+        return msg.size() < 2 || !msg[1].is_number_integer()
+            ? "expected [msgType, requestId, optional payload]" : nullptr;
+    case int(MsgType::InvokeBatch):
+    case int(MsgType::InvokeBatchReply):
+        return msg.size() < 2 || !checkBatchEntries(msg[1], 1, 3)
+            ? "expected [msgType, [[requestId, methodId, payload], ...]]" : nullptr;
+    case int(MsgType::CompactInvokeBatch):
+        return msg.size() < 2 || !checkBatchEntries(msg[1], 1, 2)
+            ? "expected [msgType, [[requestId, methodId, optional payload], ...]]" : nullptr;
+    case int(MsgType::CompactInvokeBatchReply):
+        return msg.size() < 2 || !checkBatchEntries(msg[1], -1, 1)
+            ? "expected [msgType, [[requestId, optional payload], ...]]" : nullptr;
+    case int(MsgType::Chunk):
+        return msg.size() < 5 || !msg[1].is_number_integer() || !msg[2].is_number_unsigned() || !msg[3].is_number_unsigned()
+                || !(msg[4].is_string() || msg[4].is_binary())
+            ? "expected [msgType, transferId, offset, size, data]" : nullptr;
+    case int(MsgType::Error):
+        return msg.size() < 4 || !msg[1].is_number_integer() || !msg[2].is_number_integer() || !msg[3].is_string()
+            ? "expected [msgType, msgType, requestId, error]" : nullptr;
+    case int(MsgType::CompactError):
+        return msg.size() < 3 || !msg[1].is_number_integer() || !msg[2].is_string() || (msg.size() > 3 && !msg[3].is_number_integer())
+            ? "expected [msgType, requestId, error, optional msgType]" : nullptr;
+    default:
+        return "message not supported";
+    }
+}
+
+/**
+* Describes a rejected message for the error report. Only the first fields and a prefix of strings are shown,
+* so the cost does not grow with the size of a hostile message.
+*/
+std::string describeMessage(const nlohmann::json& msg)
+{
+    const std::size_t maxFields = 8;
+    const std::size_t maxStringLength = 32;
+    std::string text = "[";
+    for(std::size_t i = 0; i < msg.size() && i < maxFields; ++i) {
+        const auto& field = msg[i];
+        if(i > 0) {
+            text += ",";
+        }
+        if(field.is_array()) {
+            text += "[" + std::to_string(field.size()) + " items]";
+        } else if(field.is_object()) {
+            text += "{" + std::to_string(field.size()) + " items}";
+        } else if(field.is_binary()) {
+            text += "<" + std::to_string(field.get_binary().size()) + " bytes>";
+        } else if(field.is_string() && field.get_ref<const std::string&>().size() > maxStringLength) {
+            text += nlohmann::json(field.get_ref<const std::string&>().substr(0, maxStringLength))
+                        .dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+            text += "...";
+        } else {
+            text += field.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+        }
+    }
+    if(msg.size() > maxFields) {
+        text += ",...";
+    }
+    return text + "]";
+}
+
+} // namespace
+
+bool Protocol::handleMessage(const nlohmann::json& msg, IProtocolListener& listener)
+{
+    return dispatchMessage(msg, listener);
+}
+
+bool Protocol::handleMessage(nlohmann::json&& msg, IProtocolListener& listener)
+{
+    return dispatchMessage(std::move(msg), listener);
+}
+
+template<typename Message>
+bool Protocol::dispatchMessage(Message&& msg, IProtocolListener& listener) {
+
+    m_lastError = "";
+    if(msg.is_discarded()) {
+        return reportError(listener, 0, 0, "message could not be decoded");
+    }
+    if(!msg.is_array() || msg.empty() || !msg[0].is_number_integer()) {
+        return reportError(listener, 0, 0, "message must be array starting with message type");
+    }
+    const int msgType = msg[0].template get<int>();
+    const char* shapeError = checkMessageShape(msg, msgType);
+    if(shapeError) {
+        const bool isInvokeRelated = (fullMsgType(msgType) == int(MsgType::Invoke) || fullMsgType(msgType) == int(MsgType::InvokeReply));
+        const int requestId = isInvokeRelated && msg.size() > 1 && msg[1].is_number_integer() ? msg[1].template get<int>() : 0;
+        return reportError(listener, msgType, requestId, std::string(shapeError) + ": " + describeMessage(msg));
+    }
+    // value of payloads omitted in compact messages
+    nlohmann::json omitted;
     switch(msgType) {
-    case int(MsgType::Link): {
-        const auto& objectId = msg[1].get<std::string>();
+    case int(MsgType::Handshake):
+        listener.handleHandshake(msg[1]);
+        break;
+    case int(MsgType::HandshakeReply):
+        listener.handleHandshakeReply(msg[1]);
+        break;
+    case int(MsgType::Link):
+    case int(MsgType::CompactLink): {
+        const auto& objectId = msg[1].template get_ref<const std::string&>();
         listener.handleLink(objectId);
         break;
     }
-    case int(MsgType::Init): {
-        const auto& objectId = msg[1].get<std::string>();
-        const auto& props = msg[2].get<nlohmann::json>();
-        listener.handleInit(objectId, props);
+    case int(MsgType::Init):
+    case int(MsgType::CompactInit): {
+        const auto& objectId = msg[1].template get_ref<const std::string&>();
+        if(msg.size() <= 2) {
+            omitted = nlohmann::json::object();
+        }
+        auto& props = msg.size() > 2 ? msg[2] : omitted;
+        listener.handleInit(objectId, forwardPayload<Message>(props));
         break;
     }
-    case int(MsgType::Unlink): {
-        const auto& objectId = msg[1].get<std::string>();
+    case int(MsgType::Unlink):
+    case int(MsgType::CompactUnlink): {
+        const auto& objectId = msg[1].template get_ref<const std::string&>();
         listener.handleUnlink(objectId);
         break;
     }
-    case int(MsgType::SetProperty): {
-        const auto& propertyId = msg[1].get<std::string>();
-        const auto& value = msg[2].get<nlohmann::json>();
-        listener.handleSetProperty(propertyId, value);
+    case int(MsgType::SetProperty):
+    case int(MsgType::CompactSetProperty): {
+        const auto& propertyId = msg[1].template get_ref<const std::string&>();
+        listener.handleSetProperty(propertyId, forwardPayload<Message>(msg[2]));
         break;
     }
-    case int(MsgType::PropertyChange): {
-        const auto& propertyId = msg[1].get<std::string>();
-        const auto& value = msg[2].get<nlohmann::json>();
-        listener.handlePropertyChange(propertyId, value);
+    case int(MsgType::PropertyChange):
+    case int(MsgType::CompactPropertyChange): {
+        const auto& propertyId = msg[1].template get_ref<const std::string&>();
+        listener.handlePropertyChange(propertyId, forwardPayload<Message>(msg[2]));
         break;
     }
-    case int(MsgType::Invoke): {
-        const auto& id = msg[1].get<int>();
-        const auto& methodId = msg[2].get<std::string>();
-        const auto& args = msg[3].get<nlohmann::json>();
-        listener.handleInvoke(id, methodId, args);
+    case int(MsgType::Invoke):
+    case int(MsgType::CompactInvoke): {
+        const auto& id = msg[1].template get<int>();
+        const auto& methodId = msg[2].template get_ref<const std::string&>();
+        if(msg.size() <= 3) {
+            omitted = nlohmann::json::array();
+        }
+        auto& args = msg.size() > 3 ? msg[3] : omitted;
+        listener.handleInvoke(id, methodId, forwardPayload<Message>(args));
         break;
     }
     case int(MsgType::InvokeReply): {
-        const auto& id = msg[1].get<int>();
-        const auto& methodId = msg[2].get<std::string>();
-        const auto& value = msg[3].get<nlohmann::json>();
-        listener.handleInvokeReply(id, methodId, value);
+        const auto& id = msg[1].template get<int>();
+        const auto& methodId = msg[2].template get_ref<const std::string&>();
+        listener.handleInvokeReply(id, methodId, forwardPayload<Message>(msg[3]));
+        break;
+    }
+    case int(MsgType::InvokeBatch):
+    case int(MsgType::CompactInvokeBatch):
+        listener.handleInvokeBatch(forwardPayload<Message>(msg[1]));
+        break;
+    case int(MsgType::InvokeBatchReply):
+        for(auto& reply : msg[1]) {
+            const auto& methodId = reply[1].template get_ref<const std::string&>();
+            listener.handleInvokeReply(reply[0].template get<int>(), methodId, forwardPayload<Message>(reply[2]));
+        }
+        break;
+    case int(MsgType::CompactInvokeBatchReply):
+        for(auto& reply : msg[1]) {
+            omitted = nullptr;
+            auto& value = reply.size() > 1 ? reply[1] : omitted;
+            listener.handleCompactInvokeReply(reply[0].template get<int>(), forwardPayload<Message>(value));
+        }
+        break;
+    case int(MsgType::CompactInvokeReply): {
+        const auto& id = msg[1].template get<int>();
+        auto& value = msg.size() > 2 ? msg[2] : omitted;
+        listener.handleCompactInvokeReply(id, forwardPayload<Message>(value));
+        break;
+    }
+    case int(MsgType::Signal):
+    case int(MsgType::CompactSignal): {
+        const auto& signalId = msg[1].template get_ref<const std::string&>();
+        if(msg.size() <= 2) {
+            omitted = nlohmann::json::array();
+        }
+        auto& args = msg.size() > 2 ? msg[2] : omitted;
+        listener.handleSignal(signalId, forwardPayload<Message>(args));
         break;
     }
-    case int(MsgType::Signal): {
-        const auto& signalId = msg[1].get<std::string>();
-        const auto& args = msg[2].get<nlohmann::json>();
-        listener.handleSignal(signalId, args);
+    case int(MsgType::Chunk): {
+        const auto transferId = msg[1].template get<int>();
+        const auto offset = msg[2].template get<std::size_t>();
+        const auto size = msg[3].template get<std::size_t>();
+        listener.handleChunk(transferId, offset, size, msg[4]);
         break;
     }
     case int(MsgType::Error): {
-        const auto& msgTypeErr = msg[1].get<int>();
-        const auto& requestId = msg[2].get<int>();
-        const auto& error = msg[3].get<std::string>();
+        const auto& msgTypeErr = msg[1].template get<int>();
+        const auto& requestId = msg[2].template get<int>();
+        const auto& error = msg[3].template get_ref<const std::string&>();
+        listener.handleError(msgTypeErr, requestId, error);
+        break;
+    }
+    case int(MsgType::CompactError): {
+        const auto msgTypeErr = msg.size() > 3 ? msg[3].template get<int>() : int(MsgType::Invoke);
+        const auto& requestId = msg[1].template get<int>();
+        const auto& error = msg[2].template get_ref<const std::string&>();
         listener.handleError(msgTypeErr, requestId, error);
         break;
     }
-    default:
-        m_lastError = "message not supported: " + msg.dump();
-        return false;
     }
     return true;
 }
 
+bool Protocol::reportError(IProtocolListener& listener, int msgType, int requestId, std::string error)
+{
+    m_lastError = std::move(error);
+    listener.handleError(msgType, requestId, m_lastError);
+    return false;
+}
+
 std::string Protocol::lastError()
 {
     return m_lastError;
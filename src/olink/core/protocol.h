@@ -60,18 +60,42 @@ public:
      * @param props Current values of properties for object service.
      */
     virtual void handleInit(const std::string& objectId, const nlohmann::json& props) = 0;
+    /**
+     * Client side handler, handles remote init message, the props are handed over to the handler.
+     * Default implementation forwards to handleInit(const std::string&, const nlohmann::json&).
+     */
+    virtual void handleInit(const std::string& objectId, nlohmann::json&& props)
+    {
+        handleInit(objectId, static_cast<const nlohmann::json&>(props));
+    }
     /**
      * Server side handler, handles setProperty message.
      * @param propertyId Unambiguously describes property in object for which setProperty message was received.
      * @param value A value to which client request a property to be set.
      */
     virtual void handleSetProperty(const std::string& propertyId, const nlohmann::json& value) = 0;
+    /**
+     * Server side handler, handles setProperty message, the value is handed over to the handler.
+     * Default implementation forwards to handleSetProperty(const std::string&, const nlohmann::json&).
+     */
+    virtual void handleSetProperty(const std::string& propertyId, nlohmann::json&& value)
+    {
+        handleSetProperty(propertyId, static_cast<const nlohmann::json&>(value));
+    }
     /**
      * Client side handler, handles propertyChange message.
      * @param propertyId Unambiguously describes property in object for which propertyChange message was received.
      * @param value A current value of property on server side
      */
     virtual void handlePropertyChange(const std::string& propertyId, const nlohmann::json& value) = 0;
+    /**
+     * Client side handler, handles propertyChange message, the value is handed over to the handler.
+     * Default implementation forwards to handlePropertyChange(const std::string&, const nlohmann::json&).
+     */
+    virtual void handlePropertyChange(const std::string& propertyId, nlohmann::json&& value)
+    {
+        handlePropertyChange(propertyId, static_cast<const nlohmann::json&>(value));
+    }
     /**
      * Server side handler, handles Invoke message. 
      * Implementation shall call the method on object and return the result the invokeReplyMessage.
@@ -80,6 +104,14 @@ public:
      * @param args Arguments with which method should be invoked.
      */
     virtual void handleInvoke(int requestId, const std::string& methodId, const nlohmann::json& args) = 0;
+    /**
+     * Server side handler, handles Invoke message, the args are handed over to the handler.
+     * Default implementation forwards to handleInvoke(int, const std::string&, const nlohmann::json&).
+     */
+    virtual void handleInvoke(int requestId, const std::string& methodId, nlohmann::json&& args)
+    {
+        handleInvoke(requestId, methodId, static_cast<const nlohmann::json&>(args));
+    }
     /**
      * Client side handler, handles invokeReply message.
      * @param requestId Identifier of a request with which the client requested method invocation.
@@ -88,12 +120,67 @@ public:
      * @param value Method's result value.
      */
     virtual void handleInvokeReply(int requestId, const std::string& methodId, const nlohmann::json& value) = 0;
+    /**
+     * Client side handler, handles invokeReply message, the value is handed over to the handler.
+     * Default implementation forwards to handleInvokeReply(int, const std::string&, const nlohmann::json&).
+     */
+    virtual void handleInvokeReply(int requestId, const std::string& methodId, nlohmann::json&& value)
+    {
+        handleInvokeReply(requestId, methodId, static_cast<const nlohmann::json&>(value));
+    }
+    /**
+     * Server side handler, handles invokeBatch message with several invoke requests.
+     * Implementation should answer the requests with one invokeBatchReply message.
+     * The replies of an invokeBatchReply message are passed to handleInvokeReply one by one.
+     * @param calls The requests, [[requestId, methodId, args], ...], args may be omitted for compact messages.
+     * Default implementation passes the requests to handleInvoke one by one.
+     */
+    virtual void handleInvokeBatch(const nlohmann::json& calls)
+    {
+        const nlohmann::json noArgs = nlohmann::json::array();
+        for(const auto& call : calls) {
+            handleInvoke(call[0].get<int>(), call[1].get_ref<const std::string&>(), call.size() > 2 ? call[2] : noArgs);
+        }
+    }
+    /**
+     * Server side handler, handles invokeBatch message, the args are handed over to the handler.
+     * Default implementation forwards to handleInvokeBatch(const nlohmann::json&).
+     */
+    virtual void handleInvokeBatch(nlohmann::json&& calls)
+    {
+        handleInvokeBatch(static_cast<const nlohmann::json&>(calls));
+    }
+    /**
+     * Client side handler, handles compact invokeReply message of protocol v2, which identifies the call by requestId only.
+     * Default implementation forwards to handleInvokeReply with an empty methodId,
+     * implementations which keep the methodId of pending calls should override it.
+     */
+    virtual void handleCompactInvokeReply(int requestId, const nlohmann::json& value)
+    {
+        handleInvokeReply(requestId, std::string(), value);
+    }
+    /**
+     * Client side handler, handles compact invokeReply message of protocol v2, the value is handed over to the handler.
+     * Default implementation forwards to handleInvokeReply with an empty methodId.
+     */
+    virtual void handleCompactInvokeReply(int requestId, nlohmann::json&& value)
+    {
+        handleInvokeReply(requestId, std::string(), std::move(value));
+    }
     /**
      * Client side handler, handles signal message.
      * @param signalId Unambiguously describes signal in object for which signal message was received.
      * @param args Arguments with which signal was emitted.
      */
     virtual void handleSignal(const std::string& signalId, const nlohmann::json& args) = 0;
+    /**
+     * Client side handler, handles signal message, the args are handed over to the handler.
+     * Default implementation forwards to handleSignal(const std::string&, const nlohmann::json&).
+     */
+    virtual void handleSignal(const std::string& signalId, nlohmann::json&& args)
+    {
+        handleSignal(signalId, static_cast<const nlohmann::json&>(args));
+    }
     /**
      * Handles error message.
      * @param msgType Type of a message for which error occurred.
@@ -102,6 +189,41 @@ public:
      * @param error The error message.
      */
     virtual void handleError(int msgType, int requestId, const std::string& error) = 0;
+    /**
+     * Handles chunk message, a part of a message sent in chunks.
+     * Implementation should collect the data of a transfer until size bytes arrived and handle the whole message then.
+     * @param transferId Identifies the chunked message.
+     * @param offset Position of the data in the whole message.
+     * @param size Size of the whole message in network format.
+     * @param data A string with part of a JSON message or a binary value with part of a message in binary format.
+     * Default implementation ignores the chunks, BaseNode reassembles them.
+     */
+    virtual void handleChunk(int transferId, std::size_t offset, std::size_t size, const nlohmann::json& data)
+    {
+        (void)transferId;
+        (void)offset;
+        (void)size;
+        (void)data;
+    }
+    /**
+     * Handles handshake message, an offer of message formats and features.
+     * Implementation should reply with handshakeReplyMessage and switch to the chosen format after the reply.
+     * @param offer The offer, {"formats": [names], "features": [names]}, see Handshake::offer.
+     * Default implementation ignores the offer, BaseNode answers it.
+     */
+    virtual void handleHandshake(const nlohmann::json& offer)
+    {
+        (void)offer;
+    }
+    /**
+     * Handles handshake reply message with the format and features chosen for the connection.
+     * @param choice The choice, {"format": name, "features": [names]}, see Handshake::choose.
+     * Default implementation ignores the reply, BaseNode applies the choice.
+     */
+    virtual void handleHandshakeReply(const nlohmann::json& choice)
+    {
+        (void)choice;
+    }
 };
 
 /**
@@ -138,6 +260,8 @@ public:
     * @return Composed initMessage in json format.
     */
     static nlohmann::json initMessage(const std::string& objectId, const nlohmann::json& props);
+    /** Overload of initMessage, which moves the props into the message instead of copying them. */
+    static nlohmann::json initMessage(const std::string& objectId, nlohmann::json&& props);
     /**
     * Properties message.
     * Composes request a change of property described with propretyId.
@@ -147,6 +271,8 @@ public:
     * @return Composed setPropertyMessage in json format.
     */
     static nlohmann::json setPropertyMessage(const std::string& propertyId, const nlohmann::json& value);
+    /** Overload of setPropertyMessage, which moves the value into the message instead of copying it. */
+    static nlohmann::json setPropertyMessage(const std::string& propertyId, nlohmann::json&& value);
     /**
     * Properties message.
     * Composes a notification message for change of property described with propretyId.
@@ -156,6 +282,13 @@ public:
     * @return Composed propertyChangeMessage in json format.
     */
     static nlohmann::json propertyChangeMessage(const std::string& propertyId, const nlohmann::json& value);
+    /** Overload of propertyChangeMessage, which moves the value into the message instead of copying it. */
+    static nlohmann::json propertyChangeMessage(const std::string& propertyId, nlohmann::json&& value);
+    /**
+    * Request id of invoke messages for which no reply is sent, see IClientNode::invokeRemoteOneWay.
+    * Ids of invokes with reply are not negative.
+    */
+    static const int oneWayRequestId;
     /**
     * Method message.
     * Composes a request of method invocation message for a methodId.
@@ -166,6 +299,8 @@ public:
     * @return Composed invokeMessage in json format.
     */
     static nlohmann::json invokeMessage(int requestId, const std::string& methodId, const nlohmann::json& args);
+    /** Overload of invokeMessage, which moves the args into the message instead of copying them. */
+    static nlohmann::json invokeMessage(int requestId, const std::string& methodId, nlohmann::json&& args);
     /**
     * Method message.
     * Composes a response to a method invocation message for a methodId.
@@ -176,6 +311,22 @@ public:
     * @return Composed invokeReplyMessage in json format.
     */
     static nlohmann::json invokeReplyMessage(int requestId, const std::string& methodId, const nlohmann::json& value);
+    /** Overload of invokeReplyMessage, which moves the value into the message instead of copying it. */
+    static nlohmann::json invokeReplyMessage(int requestId, const std::string& methodId, nlohmann::json&& value);
+    /**
+    * Method batch message.
+    * Requests several method invocations in one message, see ClientNode::invokeRemoteBatch.
+    * @param calls The requests, an array of [requestId, methodId, args] arrays. The methods may belong to different objects.
+    * @return Composed invokeBatchMessage in json format.
+    */
+    static nlohmann::json invokeBatchMessage(nlohmann::json&& calls);
+    /**
+    * Method batch reply message.
+    * Sends the results of the invocations requested with an invoke batch message in one message.
+    * @param replies The results, an array of [requestId, methodId, value] arrays.
+    * @return Composed invokeBatchReplyMessage in json format.
+    */
+    static nlohmann::json invokeBatchReplyMessage(nlohmann::json&& replies);
     /**
     * Signal message.
     * Composes a notification message for signal emitted for signalId.
@@ -185,6 +336,8 @@ public:
     * @return Composed signalMessage in json format.
     */
     static nlohmann::json signalMessage(const std::string& signalId, const nlohmann::json& args);
+    /** Overload of signalMessage, which moves the args into the message instead of copying them. */
+    static nlohmann::json signalMessage(const std::string& signalId, nlohmann::json&& args);
     /**
     * Error message.
     * Send this message to inform that message was not accepted.
@@ -193,18 +346,76 @@ public:
     * @return Composed error message in json format.
     */
     static nlohmann::json errorMessage(MsgType msgType, int requestId, const std::string&error);
+    /**
+    * Chunk message.
+    * Carries a part of a message in network format which is too large to be sent at once, see BaseNode::setChunkSize.
+    * @param transferId Identifies the chunked message among the messages the sender currently sends in chunks.
+    * @param offset Position of the data in the whole message.
+    * @param size Size of the whole message in network format.
+    * @param data The part of the message, a string for JSON format, a binary value for binary formats.
+    * @return Composed chunk message in json format.
+    */
+    static nlohmann::json chunkMessage(int transferId, std::size_t offset, std::size_t size, nlohmann::json&& data);
+    /**
+    * Handshake message.
+    * Offers message formats and features to the peer, see BaseNode::startHandshake.
+    * @param offer The offer, {"formats": [names], "features": [names]}, see Handshake::offer.
+    * @return Composed handshake message in json format.
+    */
+    static nlohmann::json handshakeMessage(const nlohmann::json& offer);
+    /**
+    * Handshake reply message.
+    * Informs the peer which format and features are used for the connection from now on.
+    * @param choice The choice, {"format": name, "features": [names]}, see Handshake::choose.
+    * @return Composed handshake reply message in json format.
+    */
+    static nlohmann::json handshakeReplyMessage(const nlohmann::json& choice);
+    /**
+    * Translates a message of protocol v1 to its compact variant of protocol v2, for peers which chose
+    * the "compact" feature in the handshake. Compact messages have type tags below 24, see MsgType, and:
+    * - invokeReply omits the methodId, [CompactInvokeReply, requestId, value],
+    * - error omits the msgType of invoke errors, [CompactError, requestId, error] or [CompactError, requestId, error, msgType],
+    * - empty init properties, invoke and signal arguments and null reply values are omitted,
+    * - invokeBatch and invokeBatchReply entries are compacted like invoke and invokeReply messages.
+    * Other messages are returned unchanged. handleMessage accepts both protocol versions.
+    * @param msg The message of protocol v1, its payload is moved to the result.
+    * @return The compact message in json format.
+    */
+    static nlohmann::json compactMessage(nlohmann::json&& msg);
 
     /**
     * Decodes the message and calls appropriate function handler with decoded arguments.
+    * The message arity and field types are validated before any handler is called,
+    * malformed messages are reported with IProtocolListener::handleError and lastError, no exception is thrown.
     * @param msg A message payload in json format. 
     * @param listener An object providing handlers for protocol messages.
     * @return true if message translation was successful and a proper listener handler was called, false otherwise.
     */
     bool handleMessage(const nlohmann::json& msg, IProtocolListener& listener);
+    /**
+    * Overload of handleMessage for a message that is no longer needed by the caller.
+    * The payloads are moved out of the message into the rvalue handlers of the listener.
+    * @param msg A message payload in json format. It is left in valid but unspecified state.
+    * @param listener An object providing handlers for protocol messages.
+    * @return true if message translation was successful and a proper listener handler was called, false otherwise.
+    */
+    bool handleMessage(nlohmann::json&& msg, IProtocolListener& listener);
     
     /** @return error for most recent handleMessage execution*/
     std::string lastError();
 private:
+    /**
+    * Common implementation of both handleMessage overloads.
+    * Message is either a const lvalue reference, for which payloads are passed by const reference,
+    * or a non-reference type, for which payloads are moved to the listener.
+    */
+    template<typename Message>
+    bool dispatchMessage(Message&& msg, IProtocolListener& listener);
+    /**
+    * Stores the error as lastError and informs the listener about it with handleError.
+    * @return always false, the result for handleMessage.
+    */
+    bool reportError(IProtocolListener& listener, int msgType, int requestId, std::string error);
     /** Error for most recent handleMessage execution*/
     std::string m_lastError;
 };
@@ -0,0 +1,119 @@
+/*
+* MIT License
+*
+* Copyright (c) 2021 ApiGear
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "simdjsoncodec.h"
+#include <simdjson.h>
+
+namespace ApiGear { namespace ObjectLink {
+
+namespace {
+
+/** Converts a simdjson value to nlohmann::json, with the same number types nlohmann::json::parse would choose. */
+bool convert(simdjson::dom::element element, nlohmann::json& out)
+{
+    switch(element.type()) {
+    case simdjson::dom::element_type::ARRAY: {
+        nlohmann::json::array_t values;
+        const auto array = simdjson::dom::array(element);
+        values.reserve(array.size());
+        for (auto child : array) {
+            values.emplace_back();
+            if (!convert(child, values.back())) {
+                return false;
+            }
+        }
+        out = std::move(values);
+        return true;
+    }
+    case simdjson::dom::element_type::OBJECT: {
+        out = nlohmann::json::object();
+        auto& values = out.get_ref<nlohmann::json::object_t&>();
+        for (auto field : simdjson::dom::object(element)) {
+            // like nlohmann::json::parse the last of duplicated keys wins
+            auto& value = values[std::string(field.key.data(), field.key.size())];
+            if (!convert(field.value, value)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    case simdjson::dom::element_type::INT64: {
+        const auto value = int64_t(element);
+        if (value >= 0) {
+            out = static_cast<nlohmann::json::number_unsigned_t>(value);
+        } else {
+            out = static_cast<nlohmann::json::number_integer_t>(value);
+        }
+        return true;
+    }
+    case simdjson::dom::element_type::UINT64:
+        out = static_cast<nlohmann::json::number_unsigned_t>(uint64_t(element));
+        return true;
+    case simdjson::dom::element_type::DOUBLE:
+        out = double(element);
+        return true;
+    case simdjson::dom::element_type::STRING: {
+        const auto value = std::string_view(element);
+        out = std::string(value.data(), value.size());
+        return true;
+    }
+    case simdjson::dom::element_type::BOOL:
+        out = bool(element);
+        return true;
+    case simdjson::dom::element_type::NULL_VALUE:
+        out = nullptr;
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+MessageFormat SimdJsonCodec::format() const
+{
+    return MessageFormat::JSON;
+}
+
+void SimdJsonCodec::decode(const char* data, std::size_t size, nlohmann::json& msg, bool allowExceptions)
+{
+    thread_local simdjson::dom::parser parser;
+    simdjson::dom::element root;
+    // the data is copied to a padded buffer of the parser, the transport buffers do not need any padding
+    if (parser.parse(data, size, true).get(root) == simdjson::SUCCESS && convert(root, msg)) {
+        return;
+    }
+    msg = nlohmann::json::parse(data, data + size, nullptr, allowExceptions);
+}
+
+void SimdJsonCodec::encode(const nlohmann::json& msg, std::string& data)
+{
+    data = msg.dump();
+}
+
+std::string SimdJsonCodec::implementation()
+{
+    return simdjson::get_active_implementation()->name();
+}
+
+} } // ApiGear::ObjectLink
@@ -0,0 +1,49 @@
+/*
+* MIT License
+*
+* Copyright (c) 2021 ApiGear
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#pragma once
+
+#include "messagecodec.h"
+
+namespace ApiGear { namespace ObjectLink {
+
+/**
+* JSON codec parsing with simdjson, which indexes the structure of a message with SIMD instructions
+* and picks the best implementation for the running CPU (AVX2, SSE4.2, NEON or scalar) at runtime.
+* Available when olink_core is built with -DOLINK_SIMDJSON=ON, which needs the simdjson package.
+* Messages are written with nlohmann::json::dump like JsonCodec and decode to the same messages as JsonCodec.
+* Data simdjson does not accept, e.g. integers beyond 64 bits, is given to nlohmann::json::parse,
+* so errors are reported exactly as by JsonCodec.
+* The codec is thread safe, each thread parses with a parser of its own.
+*/
+class OLINK_EXPORT SimdJsonCodec : public IMessageCodec
+{
+public:
+    MessageFormat format() const override;
+    void decode(const char* data, std::size_t size, nlohmann::json& msg, bool allowExceptions) override;
+    void encode(const nlohmann::json& msg, std::string& data) override;
+    /** @return name of the simdjson implementation chosen for this CPU, e.g. "haswell" for AVX2. */
+    static std::string implementation();
+};
+
+} } // ApiGear::ObjectLink
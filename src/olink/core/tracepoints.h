@@ -0,0 +1,58 @@
+/*
+* MIT License
+*
+* Copyright (c) 2021 ApiGear
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#pragma once
+
+/**
+* USDT (user statically defined tracing) probes of olink_core, provider "olink".
+* Compiled in when olink_core is built with -DOLINK_USDT_PROBES=ON, which needs sys/sdt.h
+* (systemtap-sdt-dev, systemtap-sdt-devel). A probe is a single nop instruction until a tracer attaches to it,
+* without the option the macros expand to nothing and their arguments are not evaluated.
+*
+* Probes, all carry message type (-1 if not known), member id (object id for link, unlink and init) and message size:
+*   message_receive(-1, "", size)         data received from network, before decoding
+*   message_decoded(msgType, id, size)     message decoded
+*   dispatch_start(msgType, id, size)      before the message is passed to the node handlers, sinks and sources
+*   dispatch_done(msgType, id, size)       after the handlers returned
+*   message_write(msgType, id, size)       message encoded and passed to the network layer
+*   invoke_send(requestId, methodId, size) invoke request sent
+*   invoke_reply(requestId, methodId, size) invoke reply received
+*
+* Example, invoke round trip per method:
+*   bpftrace -e 'usdt:./app:olink:invoke_send { @start[arg0] = nsecs; }
+*                usdt:./app:olink:invoke_reply /@start[arg0]/ { @us[str(arg1)] = hist((nsecs - @start[arg0]) / 1000); delete(@start[arg0]); }'
+*/
+
+#if defined(OLINK_USDT_PROBES)
+
+#include <sys/sdt.h>
+
+#define OLINK_TRACE_ENABLED 1
+#define OLINK_TRACE(name, first, id, size) DTRACE_PROBE3(olink, name, (first), (id), (size))
+
+#else
+
+#define OLINK_TRACE_ENABLED 0
+#define OLINK_TRACE(name, first, id, size) do {} while (0)
+
+#endif
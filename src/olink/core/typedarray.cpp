@@ -0,0 +1,114 @@
+/*
+* MIT License
+*
+* Copyright (c) 2021 ApiGear
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "typedarray.h"
+
+namespace ApiGear { namespace ObjectLink {
+
+namespace {
+
+// Loads and stores go through memcpy and the swaps are plain shifts, which the compiler turns into
+// byte shuffles over whole vector registers (pshufb, vpshufb, rev) when vectorizing the loops.
+inline std::uint16_t swap16(std::uint16_t value)
+{
+    return static_cast<std::uint16_t>((value >> 8) | (value << 8));
+}
+
+inline std::uint32_t swap32(std::uint32_t value)
+{
+    return (value >> 24) | ((value >> 8) & 0x0000ff00u) | ((value << 8) & 0x00ff0000u) | (value << 24);
+}
+
+inline std::uint64_t swap64(std::uint64_t value)
+{
+    return (static_cast<std::uint64_t>(swap32(static_cast<std::uint32_t>(value))) << 32)
+        | swap32(static_cast<std::uint32_t>(value >> 32));
+}
+
+template<typename Word, Word (*swap)(Word)>
+void swapWords(const std::uint8_t* source, std::uint8_t* destination, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        Word word;
+        std::memcpy(&word, source + i * sizeof(Word), sizeof(Word));
+        word = swap(word);
+        std::memcpy(destination + i * sizeof(Word), &word, sizeof(Word));
+    }
+}
+
+} // namespace
+
+bool typedArrayElement(std::uint64_t tag, TypedArrayElement& element)
+{
+    // RFC 8746 tags 64..87 are 0b010fsell: f float, s signed integer, e little endian, ll size
+    if (tag < 64 || tag > 87) {
+        return false;
+    }
+    const auto bits = static_cast<unsigned>(tag);
+    const unsigned sizeBits = bits & 0x03;
+    element.isFloat = (bits & 0x10) != 0;
+    element.isSigned = !element.isFloat && (bits & 0x08) != 0;
+    element.littleEndian = (bits & 0x04) != 0;
+    if (element.isFloat) {
+        // float16 and float128 have no C++ type
+        if ((bits & 0x08) != 0 || sizeBits == 0 || sizeBits == 3) {
+            return false;
+        }
+        element.size = sizeBits == 1 ? 4 : 8;
+        return true;
+    }
+    element.size = std::size_t(1) << sizeBits;
+    if (element.size == 1) {
+        // 68 is uint8 with clamped arithmetic, 76 is reserved
+        if (element.isSigned && element.littleEndian) {
+            return false;
+        }
+        element.littleEndian = nativeLittleEndian;
+    }
+    return true;
+}
+
+void swapByteOrder(const void* source, void* destination, std::size_t count, std::size_t size)
+{
+    const auto from = static_cast<const std::uint8_t*>(source);
+    const auto to = static_cast<std::uint8_t*>(destination);
+    switch (size) {
+    case 2:
+        swapWords<std::uint16_t, swap16>(from, to, count);
+        break;
+    case 4:
+        swapWords<std::uint32_t, swap32>(from, to, count);
+        break;
+    case 8:
+        swapWords<std::uint64_t, swap64>(from, to, count);
+        break;
+    default:
+        if (from != to) {
+            std::memmove(to, from, count * size);
+        }
+        break;
+    }
+}
+
+} } // ApiGear::ObjectLink
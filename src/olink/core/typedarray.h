@@ -0,0 +1,261 @@
+/*
+* MIT License
+*
+* Copyright (c) 2021 ApiGear
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#pragma once
+
+#include "olink_common.h"
+#include "nlohmann/json.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace ApiGear { namespace ObjectLink {
+
+/*
+* Typed arrays are contiguous numeric arrays sent as raw bytes instead of element by element.
+* A typed array is a nlohmann::json binary value whose subtype is the RFC 8746 CBOR tag naming element type and byte order.
+* CBOR writes it as a tagged byte string, MessagePack as an ext value with the tag as type, BSON as binary with the tag as subtype.
+* JSON has no binary values, nlohmann writes them as an object {"bytes": [...], "subtype": tag}, which TypedArrayView reads as well.
+* Create typed arrays with makeTypedArray, read them with TypedArrayView.
+*/
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+/** True if this machine stores numbers little endian. */
+constexpr bool nativeLittleEndian = false;
+#else
+/** True if this machine stores numbers little endian. */
+constexpr bool nativeLittleEndian = true;
+#endif
+
+/**
+* @return the RFC 8746 tag of an array of T in native byte order.
+* T is an integer of 8, 16, 32 or 64 bits, float or double.
+*/
+template<typename T>
+constexpr std::uint8_t typedArrayTag()
+{
+    static_assert(std::is_arithmetic<T>::value && !std::is_same<T, bool>::value, "typed arrays hold numbers");
+    static_assert(std::is_floating_point<T>::value ? (sizeof(T) == 4 || sizeof(T) == 8)
+                  : (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8),
+                  "typed arrays hold integers of 8 to 64 bits, float and double");
+    // 0b010fsell: f float, s signed integer, e little endian (for 8 bit integers clamped), ll size
+    return static_cast<std::uint8_t>(0x40
+        | (std::is_floating_point<T>::value ? 0x10 : 0)
+        | (std::is_integral<T>::value && std::is_signed<T>::value ? 0x08 : 0)
+        | (nativeLittleEndian && sizeof(T) > 1 ? 0x04 : 0)
+        | (std::is_floating_point<T>::value ? (sizeof(T) == 4 ? 1 : 2)
+           : (sizeof(T) == 1 ? 0 : sizeof(T) == 2 ? 1 : sizeof(T) == 4 ? 2 : 3)));
+}
+
+/**
+* Element type of a typed array as described by its RFC 8746 tag.
+*/
+struct OLINK_EXPORT TypedArrayElement
+{
+    bool isFloat = false;
+    bool isSigned = false;
+    bool littleEndian = false;
+    /** Size of an element in bytes. */
+    std::size_t size = 0;
+};
+
+/**
+* Reads the element type of a typed array from its tag.
+* @return false if the tag is no RFC 8746 typed array tag or names an element type not supported, float16 and float128.
+*/
+OLINK_EXPORT bool typedArrayElement(std::uint64_t tag, TypedArrayElement& element);
+
+/**
+* Copies count elements of size 2, 4 or 8 bytes and reverses the byte order of each element.
+* The loops are written to be vectorized by the compiler, source and destination may be the same but must not overlap otherwise.
+*/
+OLINK_EXPORT void swapByteOrder(const void* source, void* destination, std::size_t count, std::size_t size);
+
+/**
+* @return a typed array holding a copy of count elements starting at data, in native byte order.
+*/
+template<typename T>
+nlohmann::json makeTypedArray(const T* data, std::size_t count)
+{
+    const auto bytes = reinterpret_cast<const std::uint8_t*>(data);
+    return nlohmann::json::binary(std::vector<std::uint8_t>(bytes, bytes + count * sizeof(T)), typedArrayTag<T>());
+}
+
+/** @return a typed array holding a copy of values. */
+template<typename T>
+nlohmann::json makeTypedArray(const std::vector<T>& values)
+{
+    return makeTypedArray(values.data(), values.size());
+}
+
+/**
+* Reads a message value as a contiguous array of T, e.g. in IObjectSink::olinkOnPropertyChanged.
+* A typed array of T in native byte order is viewed in place without a copy, the view is usable as long as the value
+* lives unchanged. Otherwise the elements are converted into a buffer owned by the view:
+* typed arrays in the other byte order are byte swapped, typed arrays of other element types and
+* JSON arrays of numbers are converted element by element, as is the JSON form of typed arrays.
+* For any other value the view is not valid and empty.
+*/
+template<typename T>
+class TypedArrayView
+{
+public:
+    explicit TypedArrayView(const nlohmann::json& value)
+    {
+        if (value.is_binary()) {
+            const auto& binary = value.get_binary();
+            if (binary.has_subtype()) {
+                readBytes(binary.data(), binary.size(), binary.subtype(), true);
+            }
+        } else if (value.is_array()) {
+            readNumbers(value);
+        } else if (value.is_object() && value.size() == 2) {
+            readObjectForm(value);
+        }
+    }
+    TypedArrayView(TypedArrayView&&) = default;
+    TypedArrayView& operator=(TypedArrayView&&) = default;
+    TypedArrayView(const TypedArrayView&) = delete;
+    TypedArrayView& operator=(const TypedArrayView&) = delete;
+
+    /** @return false if the value is no array of numbers. */
+    bool valid() const { return m_valid; }
+    /** @return true if the elements were converted, false if they are viewed in place. */
+    bool converted() const { return m_data != nullptr && m_data == m_converted.data(); }
+    const T* data() const { return m_data; }
+    std::size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    const T* begin() const { return m_data; }
+    const T* end() const { return m_data + m_size; }
+    const T& operator[](std::size_t index) const { return m_data[index]; }
+    /** @return a copy of the elements. */
+    std::vector<T> toVector() const { return std::vector<T>(begin(), end()); }
+private:
+    void setConverted()
+    {
+        m_data = m_converted.data();
+        m_size = m_converted.size();
+        m_valid = true;
+    }
+
+    void readBytes(const std::uint8_t* bytes, std::size_t size, std::uint64_t tag, bool inPlace)
+    {
+        TypedArrayElement element;
+        if (!typedArrayElement(tag, element) || size % element.size != 0) {
+            return;
+        }
+        const std::size_t count = size / element.size;
+        const bool swap = element.size > 1 && element.littleEndian != nativeLittleEndian;
+        const bool sameType = element.size == sizeof(T) && element.isFloat == std::is_floating_point<T>::value
+            && (element.isFloat || element.isSigned == std::is_signed<T>::value);
+        if (sameType && !swap && inPlace && reinterpret_cast<std::uintptr_t>(bytes) % alignof(T) == 0) {
+            m_data = reinterpret_cast<const T*>(bytes);
+            m_size = count;
+            m_valid = true;
+            return;
+        }
+        if (sameType) {
+            m_converted.resize(count);
+            if (swap) {
+                swapByteOrder(bytes, m_converted.data(), count, sizeof(T));
+            } else if (count > 0) {
+                std::memcpy(m_converted.data(), bytes, size);
+            }
+            setConverted();
+            return;
+        }
+        if (element.isFloat) {
+            element.size == 4 ? convertFrom<float>(bytes, count, swap) : convertFrom<double>(bytes, count, swap);
+        } else if (element.isSigned) {
+            switch (element.size) {
+            case 1: convertFrom<std::int8_t>(bytes, count, swap); break;
+            case 2: convertFrom<std::int16_t>(bytes, count, swap); break;
+            case 4: convertFrom<std::int32_t>(bytes, count, swap); break;
+            default: convertFrom<std::int64_t>(bytes, count, swap); break;
+            }
+        } else {
+            switch (element.size) {
+            case 1: convertFrom<std::uint8_t>(bytes, count, swap); break;
+            case 2: convertFrom<std::uint16_t>(bytes, count, swap); break;
+            case 4: convertFrom<std::uint32_t>(bytes, count, swap); break;
+            default: convertFrom<std::uint64_t>(bytes, count, swap); break;
+            }
+        }
+    }
+
+    template<typename Source>
+    void convertFrom(const std::uint8_t* bytes, std::size_t count, bool swap)
+    {
+        std::vector<Source> source(count);
+        if (swap) {
+            swapByteOrder(bytes, source.data(), count, sizeof(Source));
+        } else if (count > 0) {
+            std::memcpy(source.data(), bytes, count * sizeof(Source));
+        }
+        m_converted.resize(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            m_converted[i] = static_cast<T>(source[i]);
+        }
+        setConverted();
+    }
+
+    void readNumbers(const nlohmann::json& value)
+    {
+        m_converted.reserve(value.size());
+        for (const auto& element : value) {
+            if (!element.is_number()) {
+                m_converted.clear();
+                return;
+            }
+            m_converted.push_back(element.get<T>());
+        }
+        setConverted();
+    }
+
+    void readObjectForm(const nlohmann::json& value)
+    {
+        const auto bytes = value.find("bytes");
+        const auto subtype = value.find("subtype");
+        if (bytes == value.end() || subtype == value.end() || !bytes->is_array() || !subtype->is_number_unsigned()) {
+            return;
+        }
+        std::vector<std::uint8_t> raw;
+        raw.reserve(bytes->size());
+        for (const auto& byte : *bytes) {
+            if (!byte.is_number_unsigned() || byte.get<std::uint64_t>() > 0xff) {
+                return;
+            }
+            raw.push_back(byte.get<std::uint8_t>());
+        }
+        readBytes(raw.data(), raw.size(), subtype->get<std::uint64_t>(), false);
+    }
+
+    const T* m_data = nullptr;
+    std::size_t m_size = 0;
+    bool m_valid = false;
+    std::vector<T> m_converted;
+};
+
+} } // ApiGear::ObjectLink
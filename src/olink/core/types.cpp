@@ -22,6 +22,7 @@
 * SOFTWARE.
 */
 #include "types.h"
+#include "messagecodec.h"
 
 #include <string>
 #include <map>
@@ -62,52 +63,75 @@ std::string Name::createMemberId(const std::string& objectId, const std::string&
 // ********************************************************************
 
 MessageConverter::MessageConverter(MessageFormat format)
-    : m_format(format)
+    : m_codec(IMessageCodec::create(format))
+{
+}
+
+MessageConverter::MessageConverter(std::shared_ptr<IMessageCodec> codec)
+    : m_codec(std::move(codec))
 {
 }
 
 void MessageConverter::setMessageFormat(MessageFormat format)
 {
-    m_format = format;
+    m_codec = IMessageCodec::create(format);
 }
 
-nlohmann::json MessageConverter::fromString(const std::string& message)
+MessageFormat MessageConverter::messageFormat() const
 {
-    switch(m_format) {
-    case MessageFormat::JSON:
-        return nlohmann::json::parse(message);
-    case MessageFormat::BSON:
-        return nlohmann::json::from_bson(message);
-    case MessageFormat::MSGPACK:
-        return nlohmann::json::from_msgpack(message);
-    case MessageFormat::CBOR:
-        return nlohmann::json::from_cbor(message);
-    }
+    return m_codec ? m_codec->format() : MessageFormat::JSON;
+}
 
-    return nlohmann::json();
+void MessageConverter::setCodec(std::shared_ptr<IMessageCodec> codec)
+{
+    m_codec = std::move(codec);
+}
+
+const std::shared_ptr<IMessageCodec>& MessageConverter::codec() const
+{
+    return m_codec;
+}
+
+nlohmann::json MessageConverter::fromString(const std::string& message, bool allowExceptions)
+{
+    return fromString(message.data(), message.size(), allowExceptions);
+}
+
+nlohmann::json MessageConverter::fromString(const char* data, std::size_t size, bool allowExceptions)
+{
+    nlohmann::json msg;
+    if(m_codec) {
+        m_codec->decode(data, size, msg, allowExceptions);
+    }
+    return msg;
 }
 
 std::string MessageConverter::toString(const nlohmann::json& j)
 {
-    std::vector<uint8_t> v;
-    switch(m_format) {
-    case MessageFormat::JSON:
-        return j.dump();
-    case MessageFormat::BSON:
-        v = nlohmann::json::to_bson(j);
-        return std::string(v.begin(), v.end());
-    case MessageFormat::MSGPACK:
-        v = nlohmann::json::to_msgpack(j);
-        return std::string(v.begin(), v.end());
-    case MessageFormat::CBOR:
-        v = nlohmann::json::to_cbor(j);
-        return std::string(v.begin(), v.end());
+    std::string data;
+    if(m_codec) {
+        m_codec->encode(j, data);
     }
-    return std::string();
+    return data;
 }
 
 std::string toString(MsgType type) {
     static std::map<MsgType, std::string> typeNames = {
+        { MsgType::Handshake, "handshake" },
+        { MsgType::HandshakeReply, "handshake_reply" },
+        { MsgType::CompactLink, "compact_link" },
+        { MsgType::CompactInit, "compact_init" },
+        { MsgType::CompactUnlink, "compact_unlink" },
+        { MsgType::CompactSetProperty, "compact_property_change" },
+        { MsgType::CompactPropertyChange, "compact_signal_property_change" },
+        { MsgType::CompactInvoke, "compact_invoke" },
+        { MsgType::CompactInvokeReply, "compact_invoke_reply" },
+        { MsgType::CompactSignal, "compact_signal" },
+        { MsgType::CompactError, "compact_error" },
+        { MsgType::CompactInvokeBatch, "compact_invoke_batch" },
+        { MsgType::CompactInvokeBatchReply, "compact_invoke_batch_reply" },
+        { MsgType::InvokeBatch, "invoke_batch" },
+        { MsgType::InvokeBatchReply, "invoke_batch_reply" },
         { MsgType::Link, "link" },
         { MsgType::Unlink, "unlink" },
         { MsgType::Init, "init" },
@@ -116,6 +140,7 @@ std::string toString(MsgType type) {
         { MsgType::Invoke, "invoke" },
         { MsgType::InvokeReply, "invoke_reply" },
         { MsgType::Signal, "signal" },
+        { MsgType::Chunk, "chunk" },
         { MsgType::Error, "error"
         },
     };
@@ -127,6 +152,56 @@ std::string toString(MsgType type) {
     return result->second;
 }
 
+int fullMsgType(int msgType)
+{
+    switch(msgType) {
+    case int(MsgType::CompactLink): return int(MsgType::Link);
+    case int(MsgType::CompactInit): return int(MsgType::Init);
+    case int(MsgType::CompactUnlink): return int(MsgType::Unlink);
+    case int(MsgType::CompactSetProperty): return int(MsgType::SetProperty);
+    case int(MsgType::CompactPropertyChange): return int(MsgType::PropertyChange);
+    case int(MsgType::CompactInvoke): return int(MsgType::Invoke);
+    case int(MsgType::CompactInvokeReply): return int(MsgType::InvokeReply);
+    case int(MsgType::CompactSignal): return int(MsgType::Signal);
+    case int(MsgType::CompactError): return int(MsgType::Error);
+    case int(MsgType::CompactInvokeBatch): return int(MsgType::InvokeBatch);
+    case int(MsgType::CompactInvokeBatchReply): return int(MsgType::InvokeBatchReply);
+    default: return msgType;
+    }
+}
+
+namespace {
+
+const std::pair<MessageFormat, const char*> formatNames[] = {
+    { MessageFormat::JSON, "json" },
+    { MessageFormat::BSON, "bson" },
+    { MessageFormat::MSGPACK, "msgpack" },
+    { MessageFormat::CBOR, "cbor" },
+};
+
+} // namespace
+
+std::string toString(MessageFormat format)
+{
+    for(const auto& name : formatNames) {
+        if(name.first == format) {
+            return name.second;
+        }
+    }
+    return std::string("unknown");
+}
+
+bool parseMessageFormat(const std::string& name, MessageFormat& format)
+{
+    for(const auto& formatName : formatNames) {
+        if(name == formatName.second) {
+            format = formatName.first;
+            return true;
+        }
+    }
+    return false;
+}
+
 // ********************************************************************
 // LoggerBase
 // ********************************************************************
@@ -141,6 +216,11 @@ void LoggerBase::emitLog(LogLevel level, const std::string& msg){
     }
 }
 
+bool LoggerBase::isLogEnabled() const
+{
+    return m_logFunc != nullptr;
+}
+
 
 
 } } // ApiGear::ObjectLink
@@ -26,6 +26,9 @@
 #include "olink_common.h"
 #include "nlohmann/json.hpp"
 #include <string>
+#include <cstddef>
+#include <functional>
+#include <memory>
 
 namespace ApiGear { namespace ObjectLink {
 
@@ -36,6 +39,25 @@ namespace ApiGear { namespace ObjectLink {
 */
 enum class MsgType : int
 {
+    /** Offer of message formats and features, see BaseNode::startHandshake. */
+    Handshake = 1,
+    /** The format and features chosen for the connection. */
+    HandshakeReply = 2,
+    /**
+    * Compact variants of protocol v2, used if the "compact" feature is chosen in the handshake, see Protocol::compactMessage.
+    * The tags are below 24, so CBOR encodes them in one byte.
+    */
+    CompactLink = 3,
+    CompactInit = 4,
+    CompactUnlink = 5,
+    CompactSetProperty = 6,
+    CompactPropertyChange = 7,
+    CompactInvoke = 8,
+    CompactInvokeReply = 9,
+    CompactSignal = 13,
+    CompactError = 14,
+    CompactInvokeBatch = 15,
+    CompactInvokeBatchReply = 16,
     Link = 10,
     Init = 11,
     Unlink = 12,
@@ -43,7 +65,13 @@ enum class MsgType : int
     PropertyChange = 21,
     Invoke = 30,
     InvokeReply = 31,
+    /** Several invoke requests in one message, see ClientNode::invokeRemoteBatch. */
+    InvokeBatch = 32,
+    /** Replies to the invoke requests of an InvokeBatch message. */
+    InvokeBatchReply = 33,
     Signal = 40,
+    /** Part of a message too large to be sent at once, see BaseNode::setChunkSize. */
+    Chunk = 50,
     Error = 99,
 };
 
@@ -52,6 +80,11 @@ enum class MsgType : int
 */
 std::string toString(MsgType type);
 
+/**
+* @return The message type of protocol v1 for a compact message type of protocol v2, other message types unchanged.
+*/
+OLINK_EXPORT int fullMsgType(int msgType);
+
 /**
 * Choose one of the available message formats for object link protocol messages.
 */
@@ -63,6 +96,16 @@ enum MessageFormat
     CBOR = 4,
 };
 
+/**
+* @return Name of the message format used in the handshake: "json", "bson", "msgpack" or "cbor".
+*/
+OLINK_EXPORT std::string toString(MessageFormat format);
+/**
+* Reads a message format name returned by toString(MessageFormat).
+* @return true if the name is known, format is left unchanged otherwise.
+*/
+OLINK_EXPORT bool parseMessageFormat(const std::string& name, MessageFormat& format);
+
 /**
 * Logging levels for logs across the application.
 */
@@ -97,8 +140,10 @@ public:
     static std::string createMemberId(const std::string& objectId, const std::string& memberName);
 };
 
+class IMessageCodec;
+
 /**
-* 
+* Translates messages to and from network format with an IMessageCodec.
 */
 class OLINK_EXPORT MessageConverter {
 public:
@@ -106,17 +151,37 @@ public:
     * @param network message format used for packing messages
     */
     MessageConverter(MessageFormat format);
+    /**ctor
+    * @param codec Codec used for packing messages, see IMessageCodec.
+    */
+    MessageConverter(std::shared_ptr<IMessageCodec> codec);
     /**
-    * Change network format used for message packing.
+    * Change network format used for message packing, selects the built in codec for the format.
     * @param format. Requested message format.
     */
     void setMessageFormat(MessageFormat format);
+    /** @return currently used network message format. */
+    MessageFormat messageFormat() const;
+    /** Change the codec used for message packing. */
+    void setCodec(std::shared_ptr<IMessageCodec> codec);
+    const std::shared_ptr<IMessageCodec>& codec() const;
     /**
     * Unpacks message received from network according to selected message format.
     * @param message A message received from network.
+    * @param allowExceptions If true, malformed message results in nlohmann::json::parse_error exception,
+    *    if false no exception is thrown and a discarded json value is returned instead, see nlohmann::json::is_discarded.
+    * @return Unpacked message in json format.
+    */
+    nlohmann::json fromString(const std::string& message, bool allowExceptions = true);
+    /**
+    * Unpacks message received from network according to selected message format.
+    * The message is parsed in place, use it for messages kept in transport buffers.
+    * @param data Pointer to first byte of a message received from network.
+    * @param size Number of bytes of the message.
+    * @param allowExceptions see fromString(const std::string&, bool).
     * @return Unpacked message in json format.
     */
-    nlohmann::json fromString(const std::string& message);
+    nlohmann::json fromString(const char* data, std::size_t size, bool allowExceptions = true);
     /**
     * Formats message to selected network message format.
     * @param message Message to send, not formated.
@@ -124,8 +189,8 @@ public:
     */
     std::string toString(const nlohmann::json& j);
 private:
-    /**Currently used network message format*/
-    MessageFormat m_format;
+    /**Currently used codec, nullptr for an unknown message format*/
+    std::shared_ptr<IMessageCodec> m_codec;
 };
 
 /**
@@ -141,6 +206,16 @@ public:
     * @param message from network still in network format.
     */
     virtual void handleMessage(const std::string& message) = 0;
+    /**
+    * Use this function to translate message given as a range of bytes, e.g. a frame inside of a transport receive buffer.
+    * Default implementation copies the bytes and calls handleMessage(const std::string&).
+    * @param data Pointer to first byte of a message in network format.
+    * @param size Number of bytes of the message.
+    */
+    virtual void handleMessage(const char* data, std::size_t size)
+    {
+        handleMessage(std::string(data, size));
+    }
 };
 
 /**
@@ -157,6 +232,19 @@ public:
 /** A type of function for handling invokeReply message*/
 using InvokeReplyFunc = std::function<void(InvokeReplyArg)>;
 
+/**
+* A method call sent with IClientNode::invokeRemoteBatch.
+*/
+class OLINK_EXPORT InvokeRequest {
+public:
+    /** Id of the method, consists of the objectId and the method name. */
+    std::string methodId;
+    /** Arguments of the call. */
+    nlohmann::json args;
+    /** Handler for the reply, may be nullptr. */
+    InvokeReplyFunc func;
+};
+
 /** A type of function to log*/
 using WriteLogFunc = std::function<void(LogLevel level, const std::string& msg)>;
 
@@ -165,6 +253,19 @@ using WriteLogFunc = std::function<void(LogLevel level, const std::string& msg)>
 */
 using WriteMessageFunc = std::function<void(const std::string& msg)>;
 
+/** A message formated to network format, immutable so it can be shared between many consumers without copying. */
+using MessageBuffer = std::shared_ptr<const std::string>;
+
+/** A type of function to write messages to network, which takes over the message buffer.
+Transports that keep the message after the call, e.g. queue it, should use it instead of WriteMessageFunc to avoid copying.
+The same buffer may be given to many connections.
+@param message formated to network format.
+*/
+using WriteMessageBufferFunc = std::function<void(MessageBuffer msg)>;
+
+/** A type of function to notify the network layer that a node has chunks to write, see BaseNode::onChunksPending. */
+using ChunksPendingFunc = std::function<void()>;
+
 /**
 * Helper base class enabling consistent logging behavior.
 */
@@ -179,6 +280,10 @@ public:
     * Use this function to log any message using set logger function.
     */
     void emitLog(LogLevel level, const std::string& msg);
+    /**
+    * @return true if a logger writer is set. Use it on hot paths to skip building log messages nobody receives.
+    */
+    bool isLogEnabled() const;
 private:
     /**
     * User provided function that writes a log into user defined endpoint.
@@ -104,6 +104,15 @@ public:
         return std::weak_ptr<ObjectType>();
     }
 
+    /*
+    * @return Number of stored objects.
+    */
+    std::size_t size()
+    {
+        std::unique_lock<std::mutex> lock(m_objectsMutex);
+        return m_objects.size();
+    }
+
     /*
     * @return An id that is considered as invalid in this storage. It is the maximum value of unsigned long.
     */
@@ -0,0 +1,321 @@
+/*
+* MIT License
+*
+* Copyright (c) 2021 ApiGear
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "wirecapture.h"
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace ApiGear { namespace ObjectLink {
+
+namespace {
+
+const char captureMagic[8] = { 'O', 'L', 'N', 'K', 'C', 'A', 'P', '\0' };
+/** The mapped file starts with this size and at least doubles when it is full. */
+const std::size_t initialCapacity = 16 * 1024 * 1024;
+
+template<typename Value>
+void writeValue(char*& out, Value value)
+{
+    std::memcpy(out, &value, sizeof(value));
+    out += sizeof(value);
+}
+
+template<typename Value>
+Value readValue(const char*& in)
+{
+    Value value;
+    std::memcpy(&value, in, sizeof(value));
+    in += sizeof(value);
+    return value;
+}
+
+void writeFileHeader(char* out)
+{
+    std::memcpy(out, captureMagic, sizeof(captureMagic));
+    out += sizeof(captureMagic);
+    writeValue<std::uint32_t>(out, WireCapture::version);
+    writeValue<std::uint32_t>(out, static_cast<std::uint32_t>(WireCapture::headerSize));
+    const auto startNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    writeValue<std::int64_t>(out, startNs);
+    writeValue<std::uint64_t>(out, 0);
+}
+
+void writeFrameHeader(char* out, std::uint64_t time, std::uint32_t stream, CaptureDirection direction, MessageFormat format, std::size_t size)
+{
+    writeValue<std::uint64_t>(out, time);
+    writeValue<std::uint32_t>(out, stream);
+    writeValue<std::uint32_t>(out, static_cast<std::uint32_t>(size));
+    writeValue<std::uint8_t>(out, static_cast<std::uint8_t>(direction));
+    writeValue<std::uint8_t>(out, static_cast<std::uint8_t>(format));
+    writeValue<std::uint16_t>(out, WireCapture::frameMarker);
+    writeValue<std::uint32_t>(out, 0);
+}
+
+} // namespace
+
+const std::uint32_t WireCapture::version;
+const std::size_t WireCapture::headerSize;
+const std::size_t WireCapture::frameHeaderSize;
+const std::uint16_t WireCapture::frameMarker;
+
+WireCapture::WireCapture()
+{
+}
+
+WireCapture::~WireCapture()
+{
+    close();
+}
+
+std::uint32_t WireCapture::addStream()
+{
+    return m_nextStream++;
+}
+
+std::size_t WireCapture::size() const
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_used;
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+
+bool WireCapture::open(const std::string& path)
+{
+    close();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_file = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (m_file < 0) {
+        emitLog(LogLevel::Error, "WireCapture: can not create " + path + ": " + std::strerror(errno));
+        return false;
+    }
+    m_used = 0;
+    m_capacity = 0;
+    if (!reserve(headerSize)) {
+        ::close(m_file);
+        m_file = -1;
+        return false;
+    }
+    writeFileHeader(m_mapped);
+    m_used = headerSize;
+    m_start = std::chrono::steady_clock::now();
+    return true;
+}
+
+void WireCapture::close()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_file < 0) {
+        return;
+    }
+    if (m_mapped) {
+        ::munmap(m_mapped, m_capacity);
+        m_mapped = nullptr;
+    }
+    // drop the unused, zero filled end of the last step
+    if (::ftruncate(m_file, static_cast<off_t>(m_used)) != 0) {
+        emitLog(LogLevel::Warning, "WireCapture: can not truncate capture file: " + std::string(std::strerror(errno)));
+    }
+    ::close(m_file);
+    m_file = -1;
+    m_capacity = 0;
+}
+
+bool WireCapture::isOpen() const
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_file >= 0;
+}
+
+void WireCapture::record(std::uint32_t stream, CaptureDirection direction, MessageFormat format, const char* data, std::size_t size)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_mapped || !reserve(m_used + frameHeaderSize + size)) {
+        return;
+    }
+    const auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count();
+    writeFrameHeader(m_mapped + m_used, static_cast<std::uint64_t>(time), stream, direction, format, size);
+    std::memcpy(m_mapped + m_used + frameHeaderSize, data, size);
+    m_used += frameHeaderSize + size;
+}
+
+bool WireCapture::reserve(std::size_t required)
+{
+    if (required <= m_capacity) {
+        return true;
+    }
+    auto capacity = m_capacity ? m_capacity : initialCapacity;
+    while (capacity < required) {
+        capacity *= 2;
+    }
+    if (m_mapped) {
+        ::munmap(m_mapped, m_capacity);
+        m_mapped = nullptr;
+    }
+    if (::ftruncate(m_file, static_cast<off_t>(capacity)) != 0) {
+        emitLog(LogLevel::Error, "WireCapture: can not grow capture file: " + std::string(std::strerror(errno)));
+        return false;
+    }
+    void* mapped = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, m_file, 0);
+    if (mapped == MAP_FAILED) {
+        emitLog(LogLevel::Error, "WireCapture: can not map capture file: " + std::string(std::strerror(errno)));
+        return false;
+    }
+    m_mapped = static_cast<char*>(mapped);
+    m_capacity = capacity;
+    return true;
+}
+
+#else
+
+bool WireCapture::open(const std::string& path)
+{
+    close();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_file = std::fopen(path.c_str(), "wb");
+    if (!m_file) {
+        emitLog(LogLevel::Error, "WireCapture: can not create " + path + ": " + std::strerror(errno));
+        return false;
+    }
+    char header[headerSize];
+    writeFileHeader(header);
+    std::fwrite(header, 1, headerSize, m_file);
+    m_used = headerSize;
+    m_start = std::chrono::steady_clock::now();
+    return true;
+}
+
+void WireCapture::close()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_file) {
+        std::fclose(m_file);
+        m_file = nullptr;
+    }
+}
+
+bool WireCapture::isOpen() const
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_file != nullptr;
+}
+
+void WireCapture::record(std::uint32_t stream, CaptureDirection direction, MessageFormat format, const char* data, std::size_t size)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_file) {
+        return;
+    }
+    const auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count();
+    char header[frameHeaderSize];
+    writeFrameHeader(header, static_cast<std::uint64_t>(time), stream, direction, format, size);
+    std::fwrite(header, 1, frameHeaderSize, m_file);
+    std::fwrite(data, 1, size, m_file);
+    m_used += frameHeaderSize + size;
+}
+
+bool WireCapture::reserve(std::size_t)
+{
+    return true;
+}
+
+#endif
+
+bool WireCaptureReader::open(const std::string& path)
+{
+    m_content.clear();
+    m_position = 0;
+    m_firstFrame = 0;
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return false;
+    }
+    const auto fileSize = static_cast<std::size_t>(file.tellg());
+    if (fileSize < WireCapture::headerSize) {
+        return false;
+    }
+    m_content.resize(fileSize);
+    file.seekg(0);
+    if (!file.read(m_content.data(), static_cast<std::streamsize>(fileSize))) {
+        m_content.clear();
+        return false;
+    }
+    const char* in = m_content.data();
+    if (std::memcmp(in, captureMagic, sizeof(captureMagic)) != 0) {
+        m_content.clear();
+        return false;
+    }
+    in += sizeof(captureMagic);
+    const auto fileVersion = readValue<std::uint32_t>(in);
+    const auto fileHeaderSize = readValue<std::uint32_t>(in);
+    if (fileVersion != WireCapture::version || fileHeaderSize < WireCapture::headerSize || fileHeaderSize > fileSize) {
+        m_content.clear();
+        return false;
+    }
+    m_firstFrame = fileHeaderSize;
+    m_position = m_firstFrame;
+    return true;
+}
+
+bool WireCaptureReader::next(CapturedFrame& frame)
+{
+    if (m_position + WireCapture::frameHeaderSize > m_content.size()) {
+        return false;
+    }
+    const char* in = m_content.data() + m_position;
+    const auto time = readValue<std::uint64_t>(in);
+    const auto stream = readValue<std::uint32_t>(in);
+    const auto size = readValue<std::uint32_t>(in);
+    const auto direction = readValue<std::uint8_t>(in);
+    const auto format = readValue<std::uint8_t>(in);
+    const auto marker = readValue<std::uint16_t>(in);
+    // a zero filled or cut off end of a file which was not closed
+    if (marker != WireCapture::frameMarker || m_position + WireCapture::frameHeaderSize + size > m_content.size()) {
+        return false;
+    }
+    frame.time = std::chrono::nanoseconds(time);
+    frame.stream = stream;
+    frame.direction = static_cast<CaptureDirection>(direction);
+    frame.format = static_cast<MessageFormat>(format);
+    frame.data = m_content.data() + m_position + WireCapture::frameHeaderSize;
+    frame.size = size;
+    m_position += WireCapture::frameHeaderSize + size;
+    return true;
+}
+
+void WireCaptureReader::rewind()
+{
+    if (!m_content.empty()) {
+        m_position = m_firstFrame;
+    }
+}
+
+} } // ApiGear::ObjectLink
@@ -0,0 +1,140 @@
+/*
+* MIT License
+*
+* Copyright (c) 2021 ApiGear
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#pragma once
+
+#include "olink_common.h"
+#include "types.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ApiGear { namespace ObjectLink {
+
+/**
+* Direction of a captured frame, seen from the node which captured it.
+*/
+enum class CaptureDirection : std::uint8_t
+{
+    Received = 0,
+    Sent = 1,
+};
+
+/**
+* Records frames received and sent by nodes into a binary, append-only capture file, see BaseNode::setWireCapture.
+* On POSIX systems the file is memory mapped and grows in steps, elsewhere it is written with buffered file output.
+* One capture may be shared by many nodes, each node gets its own stream id. Frames are stored with the time since
+* the capture was opened, so they can be replayed with the original timing, see WireCaptureReader.
+*
+* File layout, all numbers in host byte order:
+*   header: 8 bytes magic "OLNKCAP", u32 version, u32 header size, i64 capture start as unix time in ns, u64 reserved
+*   frames: u64 time since start in ns, u32 stream id, u32 data size, u8 direction, u8 MessageFormat,
+*           u16 frame marker, u32 reserved, followed by data size bytes of the frame in network format
+*/
+class OLINK_EXPORT WireCapture : public LoggerBase
+{
+public:
+    static const std::uint32_t version = 1;
+    static const std::size_t headerSize = 32;
+    static const std::size_t frameHeaderSize = 24;
+    static const std::uint16_t frameMarker = 0x4F4C;
+
+    WireCapture();
+    /** dtor, closes the capture file. */
+    ~WireCapture() override;
+    WireCapture(const WireCapture&) = delete;
+    WireCapture& operator=(const WireCapture&) = delete;
+
+    /**
+    * Creates the capture file, an existing file is overwritten.
+    * @return false if the file can not be created, the reason is logged.
+    */
+    bool open(const std::string& path);
+    /** Writes out all frames and closes the file, no frames are recorded afterwards. */
+    void close();
+    bool isOpen() const;
+
+    /** @return a new stream id for a node which records to this capture. */
+    std::uint32_t addStream();
+    /** Appends a frame, ignored if the capture is not open. */
+    void record(std::uint32_t stream, CaptureDirection direction, MessageFormat format, const char* data, std::size_t size);
+    /** @return number of bytes written so far, including the file header. */
+    std::size_t size() const;
+private:
+    bool reserve(std::size_t required);
+
+    mutable std::mutex m_mutex;
+    std::chrono::steady_clock::time_point m_start;
+    std::atomic<std::uint32_t> m_nextStream{ 0 };
+    std::size_t m_used = 0;
+#if defined(__unix__) || defined(__APPLE__)
+    int m_file = -1;
+    char* m_mapped = nullptr;
+    std::size_t m_capacity = 0;
+#else
+    std::FILE* m_file = nullptr;
+#endif
+};
+
+/**
+* A frame read from a capture file. The data points into the reader buffer and is valid while the reader lives.
+*/
+struct OLINK_EXPORT CapturedFrame
+{
+    std::chrono::nanoseconds time{ 0 };
+    std::uint32_t stream = 0;
+    CaptureDirection direction = CaptureDirection::Received;
+    MessageFormat format = MessageFormat::JSON;
+    const char* data = nullptr;
+    std::size_t size = 0;
+};
+
+/**
+* Reads frames of a file written by WireCapture. The whole file is loaded on open, frames are not copied.
+* A file which was not closed properly is read up to the last complete frame.
+*/
+class OLINK_EXPORT WireCaptureReader
+{
+public:
+    /** @return false if the file can not be read or is not a capture file. */
+    bool open(const std::string& path);
+    /**
+    * Reads the next frame.
+    * @return false when there are no more frames.
+    */
+    bool next(CapturedFrame& frame);
+    /** Starts reading from the first frame again. */
+    void rewind();
+private:
+    std::vector<char> m_content;
+    std::size_t m_position = 0;
+    /** Offset of the first frame, after the header of the opened file. */
+    std::size_t m_firstFrame = 0;
+};
+
+} } // ApiGear::ObjectLink
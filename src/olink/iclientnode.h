@@ -4,6 +4,7 @@
 #include "core/olink_common.h"
 #include "core/types.h"
 #include <string>
+#include <vector>
 
 namespace ApiGear{
 namespace ObjectLink{
@@ -41,6 +42,39 @@ public:
      * see also: ApiGear::ObjectLink::Name::getObjectId, ApiGear::ObjectLink::getMemberName
      */
     virtual void invokeRemote(const std::string& methodId, const nlohmann::json& args = nlohmann::json{}, InvokeReplyFunc func = nullptr) = 0;
+    /**
+     * Requests a service to invoke a method, the args are moved into the message instead of being copied.
+     * Default implementation forwards to invokeRemote(const std::string&, const nlohmann::json&, InvokeReplyFunc).
+     */
+    virtual void invokeRemote(const std::string& methodId, nlohmann::json&& args, InvokeReplyFunc func = nullptr)
+    {
+        invokeRemote(methodId, static_cast<const nlohmann::json&>(args), func);
+    }
+    /**
+     * Requests a service to invoke a method without sending a reply, for commands whose result is not used.
+     * The service skips the invoke reply message and the client keeps no pending call for it.
+     * Services of older versions reply anyway, the reply is ignored.
+     * Default implementation forwards to invokeRemote without reply handler.
+     * @param methodId Identifier that consists of the object identifier and the name of the method.
+     * @param args The arguments with which method should be invoked on service side, moved into the message.
+     */
+    virtual void invokeRemoteOneWay(const std::string& methodId, nlohmann::json&& args = nlohmann::json{})
+    {
+        invokeRemote(methodId, std::move(args), nullptr);
+    }
+    /**
+     * Requests a service to invoke several methods, which may belong to different objects.
+     * The calls are sent in one message and answered with one reply message, if the "batching" feature
+     * was chosen in the handshake, see BaseNode::startHandshake. Otherwise they are sent as separate invoke messages.
+     * The reply handlers are called in the order of the replies.
+     * Default implementation calls invokeRemote for each call.
+     */
+    virtual void invokeRemoteBatch(std::vector<InvokeRequest> calls)
+    {
+        for(auto& call : calls) {
+            invokeRemote(call.methodId, std::move(call.args), std::move(call.func));
+        }
+    }
     /**
      * Request a service to change a property to requested value.
      * Once the request is accepted and property is changed the service side will send propertyChangeMessage.
@@ -51,6 +85,14 @@ public:
      * see also: ApiGear::ObjectLink::Name::getObjectId, ApiGear::ObjectLink::getMemberName
      */
     virtual void setRemoteProperty(const std::string& propertyId, const nlohmann::json& value) = 0;
+    /**
+     * Request a service to change a property, the value is moved into the message instead of being copied.
+     * Default implementation forwards to setRemoteProperty(const std::string&, const nlohmann::json&).
+     */
+    virtual void setRemoteProperty(const std::string& propertyId, nlohmann::json&& value)
+    {
+        setRemoteProperty(propertyId, static_cast<const nlohmann::json&>(value));
+    }
 };
 
 }} // ApiGear::ObjectLink
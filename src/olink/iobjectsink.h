@@ -2,7 +2,9 @@
 
 #include "core/olink_common.h"
 #include "nlohmann/json.hpp"
+#include <cstdint>
 #include <string>
+#include <vector>
 
 namespace ApiGear{
 namespace ObjectLink {
@@ -35,6 +37,15 @@ public:
     */
     virtual void olinkOnSignal(const std::string& signalId, const nlohmann::json& args) = 0;
     /**
+    * Handler function for serving the signal emitted message from the service, which hands over the ownership of the args.
+    * Override it to take the args without a copy.
+    * Default implementation forwards to olinkOnSignal(const std::string&, const nlohmann::json&).
+    */
+    virtual void olinkOnSignal(const std::string& signalId, nlohmann::json&& args)
+    {
+        olinkOnSignal(signalId, static_cast<const nlohmann::json&>(args));
+    }
+    /**
     * Handler function for serving the property changed message from the service.
     * @param propertyId The property identifier in object. Consists the objectId and property name.
     * @param value The new value for the property.
@@ -44,6 +55,26 @@ public:
     */
     virtual void olinkOnPropertyChanged(const std::string& propertyId, const nlohmann::json& value) = 0;
     /**
+    * Handler function for serving the property changed message from the service, which hands over the ownership of the value.
+    * Override it to take the value without a copy.
+    * Default implementation forwards to olinkOnPropertyChanged(const std::string&, const nlohmann::json&).
+    */
+    virtual void olinkOnPropertyChanged(const std::string& propertyId, nlohmann::json&& value)
+    {
+        olinkOnPropertyChanged(propertyId, static_cast<const nlohmann::json&>(value));
+    }
+    /**
+    * Handler function for a property changed to a binary value (blob), see IRemoteNode::notifyBinaryPropertyChange.
+    * Called instead of olinkOnPropertyChanged when the value arrives as a binary value without subtype,
+    * which MSGPACK and CBOR messages carry. Binary values with a subtype, like typed arrays, go to olinkOnPropertyChanged.
+    * @param data The bytes, decoded once from the message and handed over without a copy.
+    * Default implementation forwards them as nlohmann::json::binary to olinkOnPropertyChanged(const std::string&, nlohmann::json&&).
+    */
+    virtual void olinkOnBinaryPropertyChanged(const std::string& propertyId, std::vector<std::uint8_t>&& data)
+    {
+        olinkOnPropertyChanged(propertyId, nlohmann::json::binary(std::move(data)));
+    }
+    /**
     * Handler function for serving the Init message.
     * @param objectId The olink object identifier for which the connection was established.
     * @param props The current values for all the properties from service side.
@@ -51,6 +82,15 @@ public:
     */
     virtual void olinkOnInit(const std::string& objectId, const nlohmann::json& props, IClientNode* node) = 0;
     /**
+    * Handler function for serving the Init message, which hands over the ownership of the props.
+    * Override it to take the props without a copy.
+    * Default implementation forwards to olinkOnInit(const std::string&, const nlohmann::json&, IClientNode*).
+    */
+    virtual void olinkOnInit(const std::string& objectId, nlohmann::json&& props, IClientNode* node)
+    {
+        olinkOnInit(objectId, static_cast<const nlohmann::json&>(props), node);
+    }
+    /**
     * USe this function to inform the sink that connection with service was released.
     */
     virtual void olinkOnRelease() = 0;
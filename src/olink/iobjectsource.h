@@ -36,6 +36,15 @@ public:
     */
     virtual nlohmann::json olinkInvoke(const std::string& methodId, const nlohmann::json& args) = 0;
     /**
+    * Handler function for requesting a invoking a method of a service, which hands over the ownership of the args.
+    * Override it to take the args without a copy.
+    * Default implementation forwards to olinkInvoke(const std::string&, const nlohmann::json&).
+    */
+    virtual nlohmann::json olinkInvoke(const std::string& methodId, nlohmann::json&& args)
+    {
+        return olinkInvoke(methodId, static_cast<const nlohmann::json&>(args));
+    }
+    /**
     * Handler function for requesting a property change.
     * @param propertyId The property identifier in object. Consists of the objectId and property name.
     * @param value A value to which property is requested to be set.
@@ -45,6 +54,15 @@ public:
     */
     virtual void olinkSetProperty(const std::string& propertyId, const nlohmann::json& value) = 0;
     /**
+    * Handler function for requesting a property change, which hands over the ownership of the value.
+    * Override it to take the value without a copy.
+    * Default implementation forwards to olinkSetProperty(const std::string&, const nlohmann::json&).
+    */
+    virtual void olinkSetProperty(const std::string& propertyId, nlohmann::json&& value)
+    {
+        olinkSetProperty(propertyId, static_cast<const nlohmann::json&>(value));
+    }
+    /**
     * Handler function for client request linking with this service.
     * @param objectId The olink object identifier for which the connection was established.
     * @param node The endpoint to with which server side sends messages.
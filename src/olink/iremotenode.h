@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <vector>
 #include <nlohmann/json.hpp>
 #include "core/olink_common.h"
 
@@ -23,6 +25,26 @@ public:
      * see also: ApiGear::ObjectLink::Name::getObjectId, ApiGear::ObjectLink::getMemberName
      */
     virtual void notifyPropertyChange(const std::string& propertyId, const nlohmann::json& value) = 0;
+    /**
+     * Sends information that property has changed, the value is moved into the message instead of being copied.
+     * Default implementation forwards to notifyPropertyChange(const std::string&, const nlohmann::json&).
+     */
+    virtual void notifyPropertyChange(const std::string& propertyId, nlohmann::json&& value)
+    {
+        notifyPropertyChange(propertyId, static_cast<const nlohmann::json&>(value));
+    }
+    /**
+     * Sends a binary property value (blob), e.g. an image or a firmware chunk, as raw bytes.
+     * MSGPACK and CBOR carry it as a byte string, not as an array with an element per byte,
+     * and sinks receive it with IObjectSink::olinkOnBinaryPropertyChanged.
+     * JSON has no binary values, there the bytes are written as nlohmann writes binary values: {"bytes": [...], "subtype": null}.
+     * @param data The bytes, moved into the message.
+     * Default implementation forwards the bytes as nlohmann::json::binary to notifyPropertyChange(const std::string&, nlohmann::json&&).
+     */
+    virtual void notifyBinaryPropertyChange(const std::string& propertyId, std::vector<std::uint8_t> data)
+    {
+        notifyPropertyChange(propertyId, nlohmann::json::binary(std::move(data)));
+    }
     /**
      * Sends notification that signal has was emitted by service on server side.
      * @param signalId Identifier that consists of the objectId and the name of the signal.
@@ -32,6 +54,14 @@ public:
      * see also: ApiGear::ObjectLink::Name::getObjectId, ApiGear::ObjectLink::getMemberName
      */
     virtual void notifySignal(const std::string& signalId, const nlohmann::json& args) = 0;
+    /**
+     * Sends notification that signal was emitted, the args are moved into the message instead of being copied.
+     * Default implementation forwards to notifySignal(const std::string&, const nlohmann::json&).
+     */
+    virtual void notifySignal(const std::string& signalId, nlohmann::json&& args)
+    {
+        notifySignal(signalId, static_cast<const nlohmann::json&>(args));
+    }
 };
 
 }} //ApiGear::ObjectLink
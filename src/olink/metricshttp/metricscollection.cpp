@@ -0,0 +1,338 @@
+/*
+* MIT License
+*
+* Copyright (c) 2021 ApiGear
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "metricscollection.h"
+#include "../clientregistry.h"
+#include "../remoteregistry.h"
+#include "../core/types.h"
+#include <algorithm>
+#include <sstream>
+
+namespace ApiGear { namespace ObjectLink {
+
+namespace {
+
+using Labels = std::vector<std::pair<std::string, std::string>>;
+
+std::string escapeLabelValue(const std::string& value)
+{
+    std::string result;
+    result.reserve(value.size());
+    for (auto character : value) {
+        switch (character) {
+        case '\\': result += "\\\\"; break;
+        case '"': result += "\\\""; break;
+        case '\n': result += "\\n"; break;
+        default: result += character;
+        }
+    }
+    return result;
+}
+
+/** Writes metric families in Prometheus text exposition format. */
+class PrometheusWriter
+{
+public:
+    PrometheusWriter()
+    {
+        m_out.precision(12);
+    }
+    void family(const char* name, const char* type, const char* help)
+    {
+        m_out << "# HELP " << name << " " << help << "\n# TYPE " << name << " " << type << "\n";
+    }
+    template<typename Value>
+    void sample(const std::string& name, const Labels& labels, Value value)
+    {
+        m_out << name;
+        writeLabels(labels);
+        m_out << " " << value << "\n";
+    }
+    void histogram(const std::string& name, Labels labels, const HistogramSnapshot& histogram)
+    {
+        std::uint64_t cumulative = 0;
+        labels.emplace_back("le", "");
+        for (std::size_t index = 0; index < HistogramSnapshot::bucketCount - 1; ++index) {
+            cumulative += histogram.buckets[index];
+            labels.back().second = toSeconds(LatencyHistogram::bucketUpperBound(index));
+            sample(name + "_bucket", labels, cumulative);
+        }
+        labels.back().second = "+Inf";
+        sample(name + "_bucket", labels, histogram.count);
+        labels.pop_back();
+        sample(name + "_sum", labels, static_cast<double>(histogram.sum) / 1e9);
+        sample(name + "_count", labels, histogram.count);
+    }
+    std::string str() const
+    {
+        return m_out.str();
+    }
+private:
+    static std::string toSeconds(std::uint64_t nanoseconds)
+    {
+        std::ostringstream out;
+        out.precision(12);
+        out << static_cast<double>(nanoseconds) / 1e9;
+        return out.str();
+    }
+    void writeLabels(const Labels& labels)
+    {
+        if (labels.empty()) {
+            return;
+        }
+        m_out << "{";
+        for (std::size_t index = 0; index < labels.size(); ++index) {
+            m_out << (index ? "," : "") << labels[index].first << "=\"" << escapeLabelValue(labels[index].second) << "\"";
+        }
+        m_out << "}";
+    }
+    std::ostringstream m_out;
+};
+
+std::string typeLabel(std::size_t slot)
+{
+    const auto msgType = NodeMetrics::msgTypeOfSlot(slot);
+    return msgType < 0 ? std::string("unknown") : toString(MsgType(msgType));
+}
+
+/** Objects above the ObjectMetrics capacity are collected under empty id. */
+std::string objectLabel(const std::string& objectId)
+{
+    return objectId.empty() ? std::string("(other)") : objectId;
+}
+
+} // namespace
+
+void MetricsCollection::addNodeMetrics(const std::string& nodeName, std::weak_ptr<NodeMetrics> metrics)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_nodes.erase(std::remove_if(m_nodes.begin(), m_nodes.end(),
+        [&nodeName](const NodeEntry& entry) { return entry.name == nodeName || entry.metrics.expired(); }),
+        m_nodes.end());
+    m_nodes.push_back({ nodeName, metrics });
+}
+
+void MetricsCollection::removeNodeMetrics(const std::string& nodeName)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_nodes.erase(std::remove_if(m_nodes.begin(), m_nodes.end(),
+        [&nodeName](const NodeEntry& entry) { return entry.name == nodeName; }),
+        m_nodes.end());
+}
+
+void MetricsCollection::addObjectMetrics(const std::string& registryName, std::weak_ptr<ObjectMetrics> metrics)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_objects.erase(std::remove_if(m_objects.begin(), m_objects.end(),
+        [&registryName](const ObjectsEntry& entry) { return entry.registryName == registryName || entry.metrics.expired(); }),
+        m_objects.end());
+    m_objects.push_back({ registryName, metrics });
+}
+
+void MetricsCollection::removeObjectMetrics(const std::string& registryName)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_objects.erase(std::remove_if(m_objects.begin(), m_objects.end(),
+        [&registryName](const ObjectsEntry& entry) { return entry.registryName == registryName; }),
+        m_objects.end());
+}
+
+void MetricsCollection::addMemberTraffic(const std::string& registryName, std::weak_ptr<MemberTraffic> traffic, std::size_t topCount)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_members.erase(std::remove_if(m_members.begin(), m_members.end(),
+        [&registryName](const MembersEntry& entry) { return entry.registryName == registryName || entry.traffic.expired(); }),
+        m_members.end());
+    m_members.push_back({ registryName, traffic, topCount });
+}
+
+void MetricsCollection::removeMemberTraffic(const std::string& registryName)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_members.erase(std::remove_if(m_members.begin(), m_members.end(),
+        [&registryName](const MembersEntry& entry) { return entry.registryName == registryName; }),
+        m_members.end());
+}
+
+void MetricsCollection::addRegistry(const std::string& registryName, const RemoteRegistry& registry)
+{
+    removeRegistry(registryName);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_registries.push_back({ registryName, &registry, nullptr });
+}
+
+void MetricsCollection::addRegistry(const std::string& registryName, const ClientRegistry& registry)
+{
+    removeRegistry(registryName);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_registries.push_back({ registryName, nullptr, &registry });
+}
+
+void MetricsCollection::removeRegistry(const std::string& registryName)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_registries.erase(std::remove_if(m_registries.begin(), m_registries.end(),
+        [&registryName](const RegistryEntry& entry) { return entry.name == registryName; }),
+        m_registries.end());
+}
+
+std::string MetricsCollection::renderPrometheus() const
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    std::vector<std::pair<std::string, NodeMetricsSnapshot>> nodes;
+    for (const auto& entry : m_nodes) {
+        auto metrics = entry.metrics.lock();
+        if (metrics) {
+            nodes.emplace_back(entry.name, metrics->snapshot());
+        }
+    }
+    std::vector<std::pair<std::string, std::vector<ObjectMetricsSnapshot>>> objects;
+    for (const auto& entry : m_objects) {
+        auto metrics = entry.metrics.lock();
+        if (metrics) {
+            objects.emplace_back(entry.registryName, metrics->snapshot());
+        }
+    }
+    struct TopMembers {
+        std::string registryName;
+        std::vector<MemberTrafficEntry> byMessages;
+        std::vector<MemberTrafficEntry> byBytes;
+    };
+    std::vector<TopMembers> members;
+    for (const auto& entry : m_members) {
+        auto traffic = entry.traffic.lock();
+        if (traffic) {
+            members.push_back({ entry.registryName, traffic->topByMessages(entry.topCount), traffic->topByBytes(entry.topCount) });
+        }
+    }
+    PrometheusWriter writer;
+    if (!m_registries.empty()) {
+        writer.family("olink_registry_objects", "gauge", "Number of object ids in a registry.");
+        for (const auto& registry : m_registries) {
+            const auto count = registry.remote ? registry.remote->objectCount() : registry.client->objectCount();
+            writer.sample("olink_registry_objects", { { "registry", registry.name } }, count);
+        }
+        writer.family("olink_registry_nodes", "gauge", "Number of nodes registered in a registry.");
+        for (const auto& registry : m_registries) {
+            const auto count = registry.remote ? registry.remote->nodeCount() : registry.client->nodeCount();
+            writer.sample("olink_registry_nodes", { { "registry", registry.name } }, count);
+        }
+        writer.family("olink_registry_links", "gauge", "Number of links between remote nodes and objects.");
+        for (const auto& registry : m_registries) {
+            if (registry.remote) {
+                writer.sample("olink_registry_links", { { "registry", registry.name } }, registry.remote->linkCount());
+            }
+        }
+    }
+    lock.unlock();
+
+    if (!nodes.empty()) {
+        writer.family("olink_node_messages_total", "counter", "Messages handled by a node.");
+        for (const auto& node : nodes) {
+            for (std::size_t slot = 0; slot < NodeMetrics::msgTypeSlots; ++slot) {
+                const auto& counters = node.second.perType[slot];
+                writer.sample("olink_node_messages_total", { { "node", node.first }, { "direction", "in" }, { "type", typeLabel(slot) } }, counters.messagesIn);
+                writer.sample("olink_node_messages_total", { { "node", node.first }, { "direction", "out" }, { "type", typeLabel(slot) } }, counters.messagesOut);
+            }
+        }
+        writer.family("olink_node_bytes_total", "counter", "Bytes of messages in network format handled by a node.");
+        for (const auto& node : nodes) {
+            for (std::size_t slot = 0; slot < NodeMetrics::msgTypeSlots; ++slot) {
+                const auto& counters = node.second.perType[slot];
+                writer.sample("olink_node_bytes_total", { { "node", node.first }, { "direction", "in" }, { "type", typeLabel(slot) } }, counters.bytesIn);
+                writer.sample("olink_node_bytes_total", { { "node", node.first }, { "direction", "out" }, { "type", typeLabel(slot) } }, counters.bytesOut);
+            }
+        }
+        writer.family("olink_node_decode_errors_total", "counter", "Received messages which could not be decoded.");
+        for (const auto& node : nodes) {
+            writer.sample("olink_node_decode_errors_total", { { "node", node.first } }, node.second.decodeErrors);
+        }
+        writer.family("olink_node_pending_invokes", "gauge", "Invoke requests waiting for a reply.");
+        for (const auto& node : nodes) {
+            writer.sample("olink_node_pending_invokes", { { "node", node.first } }, node.second.pendingInvokes);
+        }
+        writer.family("olink_node_slow_handlers_total", "counter", "Sink and source handler calls over the slow handler threshold.");
+        for (const auto& node : nodes) {
+            writer.sample("olink_node_slow_handlers_total", { { "node", node.first } }, node.second.slowHandlers);
+        }
+        writer.family("olink_node_handler_seconds", "histogram", "Time spent in sink and source handlers.");
+        for (const auto& node : nodes) {
+            writer.histogram("olink_node_handler_seconds", { { "node", node.first } }, node.second.handlerTime);
+        }
+        writer.family("olink_node_decode_seconds", "histogram", "Time to translate received data to messages.");
+        for (const auto& node : nodes) {
+            writer.histogram("olink_node_decode_seconds", { { "node", node.first } }, node.second.decodeTime);
+        }
+        writer.family("olink_node_encode_seconds", "histogram", "Time to translate messages to network format.");
+        for (const auto& node : nodes) {
+            writer.histogram("olink_node_encode_seconds", { { "node", node.first } }, node.second.encodeTime);
+        }
+        writer.family("olink_node_invoke_seconds", "histogram", "Time from an invoke request to its reply.");
+        for (const auto& node : nodes) {
+            writer.histogram("olink_node_invoke_seconds", { { "node", node.first } }, node.second.invokeRoundTrip);
+        }
+    }
+    if (!objects.empty()) {
+        writer.family("olink_object_messages_total", "counter", "Messages for an object.");
+        for (const auto& registry : objects) {
+            for (const auto& object : registry.second) {
+                writer.sample("olink_object_messages_total", { { "registry", registry.first }, { "object", objectLabel(object.objectId) }, { "direction", "in" } }, object.traffic.messagesIn);
+                writer.sample("olink_object_messages_total", { { "registry", registry.first }, { "object", objectLabel(object.objectId) }, { "direction", "out" } }, object.traffic.messagesOut);
+            }
+        }
+        writer.family("olink_object_bytes_total", "counter", "Bytes of messages in network format for an object.");
+        for (const auto& registry : objects) {
+            for (const auto& object : registry.second) {
+                writer.sample("olink_object_bytes_total", { { "registry", registry.first }, { "object", objectLabel(object.objectId) }, { "direction", "in" } }, object.traffic.bytesIn);
+                writer.sample("olink_object_bytes_total", { { "registry", registry.first }, { "object", objectLabel(object.objectId) }, { "direction", "out" } }, object.traffic.bytesOut);
+            }
+        }
+        writer.family("olink_object_invoke_seconds", "histogram", "Time from an invoke request for an object method to its reply.");
+        for (const auto& registry : objects) {
+            for (const auto& object : registry.second) {
+                if (object.invokeRoundTrip.count) {
+                    writer.histogram("olink_object_invoke_seconds", { { "registry", registry.first }, { "object", objectLabel(object.objectId) } }, object.invokeRoundTrip);
+                }
+            }
+        }
+    }
+    if (!members.empty()) {
+        // space-saving estimates, a member may drop out of the top and come back with a different value
+        writer.family("olink_member_messages", "gauge", "Estimated messages sent for a member, only members with the most messages are listed.");
+        for (const auto& registry : members) {
+            for (const auto& member : registry.byMessages) {
+                writer.sample("olink_member_messages", { { "registry", registry.registryName }, { "member", member.memberId } }, member.count);
+            }
+        }
+        writer.family("olink_member_bytes", "gauge", "Estimated bytes sent for a member, only members with the most bytes are listed.");
+        for (const auto& registry : members) {
+            for (const auto& member : registry.byBytes) {
+                writer.sample("olink_member_bytes", { { "registry", registry.registryName }, { "member", member.memberId } }, member.count);
+            }
+        }
+    }
+    return writer.str();
+}
+
+} } // ApiGear::ObjectLink
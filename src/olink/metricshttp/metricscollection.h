@@ -0,0 +1,95 @@
+/*
+* MIT License
+*
+* Copyright (c) 2021 ApiGear
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#pragma once
+
+#include "../core/membertraffic.h"
+#include "../core/nodemetrics.h"
+#include "../core/objectmetrics.h"
+#include "../core/olink_common.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ApiGear { namespace ObjectLink {
+
+class ClientRegistry;
+class RemoteRegistry;
+
+/**
+* Collects the metrics to export and renders them in Prometheus text exposition format.
+* Node and object metrics are held with weak pointers, metrics of destroyed nodes are skipped.
+* Registries are held by reference and must be removed before they are destroyed.
+* Rendering only reads atomics of the metrics and registries and takes the lock of this collection
+* and the one of ObjectMetrics, never the registry locks used when dispatching messages.
+*/
+class OLINK_EXPORT MetricsCollection
+{
+public:
+    /** Adds metrics of a node, the name is used as "node" label and should be unique. */
+    void addNodeMetrics(const std::string& nodeName, std::weak_ptr<NodeMetrics> metrics);
+    void removeNodeMetrics(const std::string& nodeName);
+    /** Adds per object metrics, the name is used as "registry" label. */
+    void addObjectMetrics(const std::string& registryName, std::weak_ptr<ObjectMetrics> metrics);
+    void removeObjectMetrics(const std::string& registryName);
+    /**
+    * Adds per member traffic accounting, the name is used as "registry" label.
+    * @param topCount Number of members with highest traffic to export for each measure.
+    */
+    void addMemberTraffic(const std::string& registryName, std::weak_ptr<MemberTraffic> traffic, std::size_t topCount = 20);
+    void removeMemberTraffic(const std::string& registryName);
+    /** Adds sizes of a registry, the name is used as "registry" label. */
+    void addRegistry(const std::string& registryName, const RemoteRegistry& registry);
+    void addRegistry(const std::string& registryName, const ClientRegistry& registry);
+    void removeRegistry(const std::string& registryName);
+
+    /** @return all collected metrics in Prometheus text format. */
+    std::string renderPrometheus() const;
+private:
+    struct NodeEntry {
+        std::string name;
+        std::weak_ptr<NodeMetrics> metrics;
+    };
+    struct ObjectsEntry {
+        std::string registryName;
+        std::weak_ptr<ObjectMetrics> metrics;
+    };
+    struct MembersEntry {
+        std::string registryName;
+        std::weak_ptr<MemberTraffic> traffic;
+        std::size_t topCount;
+    };
+    struct RegistryEntry {
+        std::string name;
+        const RemoteRegistry* remote;
+        const ClientRegistry* client;
+    };
+    mutable std::mutex m_mutex;
+    std::vector<NodeEntry> m_nodes;
+    std::vector<ObjectsEntry> m_objects;
+    std::vector<MembersEntry> m_members;
+    std::vector<RegistryEntry> m_registries;
+};
+
+} } // ApiGear::ObjectLink
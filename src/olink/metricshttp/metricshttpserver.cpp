@@ -0,0 +1,195 @@
+/*
+* MIT License
+*
+* Copyright (c) 2021 ApiGear
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "metricshttpserver.h"
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace ApiGear { namespace ObjectLink {
+
+namespace {
+
+/** Upper limit for the request head, a scrape request is much shorter. */
+const std::size_t maxRequestSize = 8192;
+/** How often the server thread checks whether it should stop. */
+const int pollIntervalMs = 100;
+// a scraper closing the connection early must not raise SIGPIPE
+#ifdef MSG_NOSIGNAL
+const int sendFlags = MSG_NOSIGNAL;
+#else
+const int sendFlags = 0;
+#endif
+
+bool sendAll(int connection, const std::string& data)
+{
+    std::size_t sent = 0;
+    while (sent < data.size()) {
+        const auto result = ::send(connection, data.data() + sent, data.size() - sent, sendFlags);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            return false;
+        }
+        sent += static_cast<std::size_t>(result);
+    }
+    return true;
+}
+
+std::string response(const std::string& status, const std::string& contentType, const std::string& body)
+{
+    return "HTTP/1.1 " + status + "\r\n"
+        + "Content-Type: " + contentType + "\r\n"
+        + "Content-Length: " + std::to_string(body.size()) + "\r\n"
+        + "Connection: close\r\n\r\n"
+        + body;
+}
+
+} // namespace
+
+const std::uint16_t MetricsHttpServer::defaultPort;
+
+MetricsHttpServer::MetricsHttpServer(const MetricsCollection& metrics)
+    : m_metrics(metrics)
+{
+}
+
+MetricsHttpServer::~MetricsHttpServer()
+{
+    stop();
+}
+
+bool MetricsHttpServer::start(std::uint16_t port)
+{
+    if (m_running) {
+        return false;
+    }
+    m_listenSocket = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (m_listenSocket < 0) {
+        emitLog(LogLevel::Error, "MetricsHttpServer: can not create socket: " + std::string(std::strerror(errno)));
+        return false;
+    }
+    const int reuse = 1;
+    ::setsockopt(m_listenSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addressSize = sizeof(address);
+    if (::bind(m_listenSocket, reinterpret_cast<sockaddr*>(&address), addressSize) != 0
+        || ::listen(m_listenSocket, 8) != 0
+        || ::getsockname(m_listenSocket, reinterpret_cast<sockaddr*>(&address), &addressSize) != 0) {
+        emitLog(LogLevel::Error, "MetricsHttpServer: can not listen on port " + std::to_string(port) + ": " + std::strerror(errno));
+        ::close(m_listenSocket);
+        m_listenSocket = -1;
+        return false;
+    }
+    m_port = ntohs(address.sin_port);
+    emitLog(LogLevel::Info, "MetricsHttpServer: serving metrics on 127.0.0.1:" + std::to_string(m_port) + "/metrics");
+    m_running = true;
+    m_thread = std::thread(&MetricsHttpServer::serve, this);
+    return true;
+}
+
+void MetricsHttpServer::stop()
+{
+    if (!m_running) {
+        return;
+    }
+    m_running = false;
+    m_thread.join();
+    ::close(m_listenSocket);
+    m_listenSocket = -1;
+    m_port = 0;
+}
+
+std::uint16_t MetricsHttpServer::port() const
+{
+    return m_port;
+}
+
+void MetricsHttpServer::serve()
+{
+    while (m_running) {
+        pollfd listening{};
+        listening.fd = m_listenSocket;
+        listening.events = POLLIN;
+        const auto ready = ::poll(&listening, 1, pollIntervalMs);
+        if (ready <= 0) {
+            continue;
+        }
+        const auto connection = ::accept(m_listenSocket, nullptr, nullptr);
+        if (connection < 0) {
+            continue;
+        }
+        handleConnection(connection);
+        ::close(connection);
+    }
+}
+
+void MetricsHttpServer::handleConnection(int connection)
+{
+    // a client which does not send its request must not block the server
+    timeval timeout{};
+    timeout.tv_sec = 1;
+    ::setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+#ifdef SO_NOSIGPIPE
+    const int noSigPipe = 1;
+    ::setsockopt(connection, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+#endif
+
+    std::string request;
+    char buffer[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < maxRequestSize) {
+        const auto received = ::recv(connection, buffer, sizeof(buffer), 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            break;
+        }
+        request.append(buffer, static_cast<std::size_t>(received));
+    }
+    const auto requestLine = request.substr(0, request.find("\r\n"));
+    if (requestLine.compare(0, 4, "GET ") != 0) {
+        sendAll(connection, response("405 Method Not Allowed", "text/plain", "only GET is supported\n"));
+        return;
+    }
+    const auto pathEnd = requestLine.find(' ', 4);
+    const auto path = requestLine.substr(4, pathEnd == std::string::npos ? std::string::npos : pathEnd - 4);
+    if (path != "/metrics" && path.compare(0, 9, "/metrics?") != 0) {
+        sendAll(connection, response("404 Not Found", "text/plain", "metrics are served on /metrics\n"));
+        return;
+    }
+    sendAll(connection, response("200 OK", "text/plain; version=0.0.4; charset=utf-8", m_metrics.renderPrometheus()));
+}
+
+} } // ApiGear::ObjectLink
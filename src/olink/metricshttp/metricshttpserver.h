@@ -0,0 +1,73 @@
+/*
+* MIT License
+*
+* Copyright (c) 2021 ApiGear
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#pragma once
+
+#include "metricscollection.h"
+#include "../core/olink_common.h"
+#include "../core/types.h"
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+namespace ApiGear { namespace ObjectLink {
+
+/**
+* Minimal HTTP server exposing a MetricsCollection for Prometheus scrapes.
+* Listens only on the loopback interface, answers GET /metrics with the rendered metrics
+* and 404 for other paths. Connections are served one at a time in a background thread.
+* Available on POSIX systems.
+*/
+class OLINK_EXPORT MetricsHttpServer : public LoggerBase
+{
+public:
+    /** Default port, the one registered for Prometheus exporters of OpenTelemetry. */
+    static const std::uint16_t defaultPort = 9464;
+
+    /** @param metrics The collection to render, must outlive the server. */
+    explicit MetricsHttpServer(const MetricsCollection& metrics);
+    /** dtor, stops the server. */
+    ~MetricsHttpServer() override;
+
+    /**
+    * Starts listening on 127.0.0.1.
+    * @param port The port to listen on, 0 lets the system pick a free one, see port().
+    * @return false if the server is already running or the port can not be bound.
+    */
+    bool start(std::uint16_t port = defaultPort);
+    /** Stops listening and waits for the server thread to finish. */
+    void stop();
+    /** @return the port the server listens on or 0 if it is not running. */
+    std::uint16_t port() const;
+private:
+    void serve();
+    void handleConnection(int connection);
+
+    const MetricsCollection& m_metrics;
+    int m_listenSocket = -1;
+    std::uint16_t m_port = 0;
+    std::atomic<bool> m_running{ false };
+    std::thread m_thread;
+};
+
+} } // ApiGear::ObjectLink
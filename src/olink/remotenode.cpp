@@ -56,9 +56,13 @@ void RemoteNode::handleLink(const std::string& objectId)
     auto source = m_registry.getSource(objectId).lock();
     if(source) {
         m_registry.addNodeForSource(m_nodeId, objectId);
+        auto started = handlerStarted();
         source->olinkLinked(objectId, this);
+        handlerFinished("olinkLinked", objectId, started);
+        started = handlerStarted();
         nlohmann::json props = source->olinkCollectProperties();
-        emitWrite(Protocol::initMessage(objectId, props));
+        handlerFinished("olinkCollectProperties", objectId, started);
+        emitWrite(compactIfNegotiated(Protocol::initMessage(objectId, std::move(props))));
     } else {
         emitLog(LogLevel::Warning, "no source to link: " + objectId);
     }
@@ -69,38 +73,93 @@ void RemoteNode::handleUnlink(const std::string& objectId)
 {
     auto source = m_registry.getSource(objectId).lock();
     if(source) {
+        const auto started = handlerStarted();
         source->olinkUnlinked(objectId);
+        handlerFinished("olinkUnlinked", objectId, started);
         m_registry.removeNodeFromSource(m_nodeId, objectId);
     }
 }
 
 void RemoteNode::handleSetProperty(const std::string& propertyId, const nlohmann::json& value)
+{
+    handleSetProperty(propertyId, nlohmann::json(value));
+}
+
+void RemoteNode::handleSetProperty(const std::string& propertyId, nlohmann::json&& value)
 {
     auto objectId = ApiGear::ObjectLink::Name::getObjectId(propertyId);
     auto source = m_registry.getSource(objectId).lock();
     if(source) {
-        source->olinkSetProperty(propertyId, value);
+        const auto started = handlerStarted();
+        source->olinkSetProperty(propertyId, std::move(value));
+        handlerFinished("olinkSetProperty", propertyId, started);
     }
 }
 
 void RemoteNode::handleInvoke(int requestId, const std::string& methodId, const nlohmann::json& args)
+{
+    handleInvoke(requestId, methodId, nlohmann::json(args));
+}
+
+void RemoteNode::handleInvoke(int requestId, const std::string& methodId, nlohmann::json&& args)
 {
     auto objectId = ApiGear::ObjectLink::Name::getObjectId(methodId);
     auto source = m_registry.getSource(objectId).lock();
     if(source) {
-        nlohmann::json value = source->olinkInvoke(methodId, args);
-        emitWrite(Protocol::invokeReplyMessage(requestId, methodId, value));
+        const auto started = handlerStarted();
+        nlohmann::json value = source->olinkInvoke(methodId, std::move(args));
+        handlerFinished("olinkInvoke", methodId, started);
+        if(requestId != Protocol::oneWayRequestId) {
+            emitWrite(compactIfNegotiated(Protocol::invokeReplyMessage(requestId, methodId, std::move(value))));
+        }
+    }
+}
+
+void RemoteNode::handleInvokeBatch(const nlohmann::json& calls)
+{
+    handleInvokeBatch(nlohmann::json(calls));
+}
+
+void RemoteNode::handleInvokeBatch(nlohmann::json&& calls)
+{
+    auto replies = nlohmann::json::array();
+    for(auto& call : calls) {
+        const auto requestId = call[0].get<int>();
+        const auto& methodId = call[1].get_ref<const std::string&>();
+        auto source = m_registry.getSource(ApiGear::ObjectLink::Name::getObjectId(methodId)).lock();
+        if(!source) {
+            continue;
+        }
+        const auto started = handlerStarted();
+        nlohmann::json value = source->olinkInvoke(methodId, call.size() > 2 ? std::move(call[2]) : nlohmann::json::array());
+        handlerFinished("olinkInvoke", methodId, started);
+        if(requestId != Protocol::oneWayRequestId) {
+            replies.push_back(nlohmann::json::array({ requestId, methodId, std::move(value) }));
+        }
+    }
+    if(!replies.empty()) {
+        emitWrite(compactIfNegotiated(Protocol::invokeBatchReplyMessage(std::move(replies))));
     }
 }
 
 void RemoteNode::notifyPropertyChange(const std::string& propertyId, const nlohmann::json& value)
 {
-    emitWrite(Protocol::propertyChangeMessage(propertyId, value));
+    emitWrite(compactIfNegotiated(Protocol::propertyChangeMessage(propertyId, value)));
+}
+
+void RemoteNode::notifyPropertyChange(const std::string& propertyId, nlohmann::json&& value)
+{
+    emitWrite(compactIfNegotiated(Protocol::propertyChangeMessage(propertyId, std::move(value))));
 }
 
 void RemoteNode::notifySignal(const std::string& signalId, const nlohmann::json& args)
 {
-    emitWrite(Protocol::signalMessage(signalId, args));
+    emitWrite(compactIfNegotiated(Protocol::signalMessage(signalId, args)));
+}
+
+void RemoteNode::notifySignal(const std::string& signalId, nlohmann::json&& args)
+{
+    emitWrite(compactIfNegotiated(Protocol::signalMessage(signalId, std::move(args))));
 }
 
 RemoteRegistry& RemoteNode::registry()
@@ -80,13 +80,25 @@ public:
     void handleUnlink(const std::string& objectId) override;
     /** IProtocolListener::handleSetProperty implementation. */
     void handleSetProperty(const std::string& propertyId, const nlohmann::json& value) override;
+    /** IProtocolListener::handleSetProperty implementation, hands the value over to the source. */
+    void handleSetProperty(const std::string& propertyId, nlohmann::json&& value) override;
     /** IProtocolListener::handleInvoke implementation. */
     void handleInvoke(int requestId, const std::string& methodId, const nlohmann::json& args) override;
+    /** IProtocolListener::handleInvoke implementation, hands the args over to the source. */
+    void handleInvoke(int requestId, const std::string& methodId, nlohmann::json&& args) override;
+    /** IProtocolListener::handleInvokeBatch implementation, answers the calls with one invoke batch reply. */
+    void handleInvokeBatch(const nlohmann::json& calls) override;
+    /** IProtocolListener::handleInvokeBatch implementation, hands the args over to the sources. */
+    void handleInvokeBatch(nlohmann::json&& calls) override;
 
     /** IRemoteNode::notifyPropertyChange implementation. */
     void notifyPropertyChange(const std::string& propertyId, const nlohmann::json& value) override;
+    /** IRemoteNode::notifyPropertyChange implementation, moves the value into the message. */
+    void notifyPropertyChange(const std::string& propertyId, nlohmann::json&& value) override;
     /** IRemoteNode::notifySignal implementation. */
     void notifySignal(const std::string& signalId, const nlohmann::json& args) override;
+    /** IRemoteNode::notifySignal implementation, moves the args into the message. */
+    void notifySignal(const std::string& signalId, nlohmann::json&& args) override;
 
     /* 
     * The id that registry assigned to a node. 
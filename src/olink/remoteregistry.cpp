@@ -22,6 +22,7 @@ void RemoteRegistry::addSource(std::weak_ptr<IObjectSource> source)
         SourceToNodesEntry entry;
         entry.source = source;
         m_entries[objectId] = entry;
+        m_objectCount = m_entries.size();
     }
     else if (alreadyAdded){
         return;
@@ -39,7 +40,9 @@ void RemoteRegistry::removeSource(const std::string& objectId)
 
 std::weak_ptr<IObjectSource> RemoteRegistry::getSource(const std::string& objectId)
 {
-    emitLog(LogLevel::Info, "RemoteRegistry.getObjectSource: " + objectId);
+    if(isLogEnabled()) {
+        emitLog(LogLevel::Info, "RemoteRegistry.getObjectSource: " + objectId);
+    }
     std::unique_lock<std::mutex> lock(m_entriesMutex);
     auto found = m_entries.find(objectId);
     auto source = found != m_entries.end() ? found->second.source : std::weak_ptr<IObjectSource>();
@@ -48,7 +51,9 @@ std::weak_ptr<IObjectSource> RemoteRegistry::getSource(const std::string& object
 
 std::vector< std::weak_ptr<IRemoteNode>> RemoteRegistry::getNodes(const std::string& objectId)
 {
-    emitLog(LogLevel::Info, "RemoteRegistry.getRemoteNodes: " + objectId);
+    if(isLogEnabled()) {
+        emitLog(LogLevel::Info, "RemoteRegistry.getRemoteNodes: " + objectId);
+    }
     std::unique_lock<std::mutex> lock(m_entriesMutex);
     auto found = m_entries.find(objectId);
     if (found != m_entries.end())
@@ -108,6 +113,7 @@ void RemoteRegistry::addNodeForSource(unsigned long nodeId, const std::string& o
         if (!alreadyAdded)
         {
             foundEntry->second.nodes.push_back(nodeId);
+            ++m_linkCount;
         }
     }
 }
@@ -124,6 +130,7 @@ void RemoteRegistry::removeNodeFromSource(unsigned long nodeId, const std::strin
                                 [nodeId](auto element){ return nodeId == element; });
         if (nodeInCollection != found->second.nodes.end()){
             found->second.nodes.erase(nodeInCollection);
+            --m_linkCount;
         }
     }
 }
@@ -135,6 +142,8 @@ void RemoteRegistry::removeEntry(const std::string& objectId)
     if (found != m_entries.end()) {
         auto nodeIds = found->second.nodes;
         m_entries.erase(found);
+        m_objectCount = m_entries.size();
+        m_linkCount -= nodeIds.size();
         lock.unlock();
     }
 }
@@ -145,7 +154,9 @@ unsigned long RemoteRegistry::registerNode(std::weak_ptr<IRemoteNode> node)
     if (!lockedNode){
         emitLog(LogLevel::Warning, "Trying to add node, but it is already gone. Node NOT added.");
     }
-    return m_remoteNodesById.add(lockedNode);
+    auto id = m_remoteNodesById.add(lockedNode);
+    m_nodeCount = m_remoteNodesById.size();
+    return id;
 }
 
 void RemoteRegistry::unregisterNode(unsigned long id)
@@ -159,11 +170,28 @@ void RemoteRegistry::unregisterNode(unsigned long id)
                 [id](auto element){ return id == element; });
             if (nodeInCollection != entry.second.nodes.end()){
                 entry.second.nodes.erase(nodeInCollection);
+                --m_linkCount;
             }
         }
         lock.unlock();
         m_remoteNodesById.remove(id);
+        m_nodeCount = m_remoteNodesById.size();
     }
 }
 
+std::size_t RemoteRegistry::objectCount() const
+{
+    return m_objectCount;
+}
+
+std::size_t RemoteRegistry::nodeCount() const
+{
+    return m_nodeCount;
+}
+
+std::size_t RemoteRegistry::linkCount() const
+{
+    return m_linkCount;
+}
+
 } } // Apigear::ObjectLink
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "core/types.h"
 #include "core/uniqueidobjectstorage.h"
 
+#include <atomic>
 #include <chrono>
 #include <memory>
 #include <mutex>
@@ -93,6 +94,16 @@ public:
     * Remove the node from registry, it will be no longer valid to use with any sink object.
     */
     void unregisterNode(unsigned long id);
+
+    /**
+    * Registry sizes, meant for monitoring. Values are kept in atomics, reading them does not lock the registry.
+    * @return number of object ids with an entry in the registry.
+    */
+    std::size_t objectCount() const;
+    /** @return number of registered remote nodes. */
+    std::size_t nodeCount() const;
+    /** @return number of links between remote nodes and objects. */
+    std::size_t linkCount() const;
 private:
 
     /**
@@ -120,6 +131,10 @@ private:
     std::mutex m_entriesMutex;
     /* Storage for client nodes, keeps them by Id*/
     UniqueIdObjectStorage<ApiGear::ObjectLink::IRemoteNode> m_remoteNodesById;
+    /* Registry sizes, updated with the entries and read without locking.*/
+    std::atomic<std::size_t> m_objectCount{ 0 };
+    std::atomic<std::size_t> m_nodeCount{ 0 };
+    std::atomic<std::size_t> m_linkCount{ 0 };
 };
 
 }} //ApiGear::ObjectLink
@@ -0,0 +1,119 @@
+#include "allocationcounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+thread_local std::size_t threadAllocationCount = 0;
+thread_local std::size_t threadAllocationBytes = 0;
+std::atomic<std::uint64_t> processAllocationCount{ 0 };
+
+void* allocate(std::size_t size)
+{
+    ++threadAllocationCount;
+    threadAllocationBytes += size;
+    processAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    void* memory = std::malloc(size ? size : 1);
+    if (!memory) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+} // namespace
+
+void* operator new(std::size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    try {
+        return allocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    try {
+        return allocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+    std::free(memory);
+}
+
+AllocationCounter::AllocationCounter()
+{
+    reset();
+}
+
+std::size_t AllocationCounter::allocations() const
+{
+    return threadAllocationCount - m_allocations;
+}
+
+std::size_t AllocationCounter::bytes() const
+{
+    return threadAllocationBytes - m_bytes;
+}
+
+void AllocationCounter::reset()
+{
+    m_allocations = threadAllocationCount;
+    m_bytes = threadAllocationBytes;
+}
+
+std::size_t AllocationCounter::threadAllocations()
+{
+    return threadAllocationCount;
+}
+
+std::size_t AllocationCounter::threadBytes()
+{
+    return threadAllocationBytes;
+}
+
+std::uint64_t AllocationCounter::processAllocations()
+{
+    return processAllocationCount.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+* Counts heap allocations made by the current thread, through the global operator new replaced in allocationcounter.cpp.
+* Link the olink_allocation_counter library, it is shared by the tests and the benchmarks.
+* Use it to check that hot paths do not allocate more than expected:
+*   AllocationCounter counter;
+*   node->handleMessage(msg);
+*   REQUIRE(counter.allocations() == 0);
+*/
+class AllocationCounter
+{
+public:
+    AllocationCounter();
+    /** @return number of allocations by this thread since the counter was created or reset. */
+    std::size_t allocations() const;
+    /** @return number of allocated bytes by this thread since the counter was created or reset. */
+    std::size_t bytes() const;
+    void reset();
+
+    /** @return number of allocations made by this thread so far. */
+    static std::size_t threadAllocations();
+    /** @return number of bytes allocated by this thread so far. */
+    static std::size_t threadBytes();
+    /** @return number of allocations made by all threads so far, e.g. for benchmarks running nodes on several threads. */
+    static std::uint64_t processAllocations();
+private:
+    std::size_t m_allocations;
+    std::size_t m_bytes;
+};
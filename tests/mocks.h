@@ -11,9 +11,10 @@ class SinkObjectMock : public trompeloeil::mock_interface<ApiGear::ObjectLink::I
 {
 public:
     IMPLEMENT_MOCK0(olinkObjectName);
-    IMPLEMENT_MOCK2(olinkOnSignal);
-    IMPLEMENT_MOCK2(olinkOnPropertyChanged);
-    IMPLEMENT_MOCK3(olinkOnInit);
+    // Handlers below are overloaded with rvalue versions in the interface, which by default forward to these.
+    MAKE_MOCK2(olinkOnSignal, void(const std::string&, const nlohmann::json&), override);
+    MAKE_MOCK2(olinkOnPropertyChanged, void(const std::string&, const nlohmann::json&), override);
+    MAKE_MOCK3(olinkOnInit, void(const std::string&, const nlohmann::json&, ApiGear::ObjectLink::IClientNode*), override);
     IMPLEMENT_MOCK0(olinkOnRelease);
 };
 
@@ -22,8 +23,9 @@ class SourceObjectMock : public trompeloeil::mock_interface<ApiGear::ObjectLink:
 {
 public:
     IMPLEMENT_MOCK0(olinkObjectName);
-    IMPLEMENT_MOCK2(olinkInvoke);
-    IMPLEMENT_MOCK2(olinkSetProperty);
+    // Handlers below are overloaded with rvalue versions in the interface, which by default forward to these.
+    MAKE_MOCK2(olinkInvoke, nlohmann::json(const std::string&, const nlohmann::json&), override);
+    MAKE_MOCK2(olinkSetProperty, void(const std::string&, const nlohmann::json&), override);
     IMPLEMENT_MOCK2(olinkLinked);
     IMPLEMENT_MOCK1(olinkUnlinked);
     IMPLEMENT_MOCK0(olinkCollectProperties);
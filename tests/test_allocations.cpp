@@ -0,0 +1,143 @@
+#include <catch2/catch.hpp>
+
+#include "allocationcounter.h"
+
+#include "olink/core/protocol.h"
+#include "olink/core/types.h"
+#include "olink/clientnode.h"
+#include "olink/clientregistry.h"
+#include "olink/iobjectsink.h"
+#include "olink/remotenode.h"
+#include "olink/remoteregistry.h"
+
+#include "sourceobject.hpp"
+
+#include "nlohmann/json.hpp"
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace ApiGear::ObjectLink;
+
+namespace {
+
+/** A sink which does not allocate, so the allocations of the node can be counted. */
+class CountingSink : public IObjectSink
+{
+public:
+    std::string olinkObjectName() override
+    {
+        return "demo.Calc";
+    }
+    void olinkOnSignal(const std::string&, const nlohmann::json&) override
+    {
+        ++signals;
+    }
+    void olinkOnPropertyChanged(const std::string&, const nlohmann::json& value) override
+    {
+        total = value.get<int>();
+    }
+    void olinkOnInit(const std::string&, const nlohmann::json&, IClientNode*) override
+    {
+    }
+    void olinkOnRelease() override
+    {
+    }
+    int total = 0;
+    int signals = 0;
+};
+
+const char* formatName(MessageFormat format)
+{
+    switch (format) {
+    case MessageFormat::JSON:
+        return "json";
+    case MessageFormat::BSON:
+        return "bson";
+    case MessageFormat::MSGPACK:
+        return "msgpack";
+    case MessageFormat::CBOR:
+        return "cbor";
+    }
+    return "";
+}
+
+void report(MessageFormat format, const std::string& scenario, std::size_t allocations)
+{
+    std::cout << "allocations " << formatName(format) << " " << scenario << ": " << allocations << "\n";
+}
+
+} // namespace
+
+// The nodes must not add allocations to the decoding and encoding of messages on the steady state paths.
+// Decoding and encoding itself allocates for the message values, the counts are reported to track them.
+TEST_CASE("hot path allocations")
+{
+    RemoteRegistry registry;
+    ClientRegistry clientRegistry;
+    auto remote = RemoteNode::createRemoteNode(registry);
+    auto source = std::make_shared<CalcSource>(registry);
+    registry.addSource(source);
+    auto client = ClientNode::create(clientRegistry);
+    auto sink = std::make_shared<CountingSink>();
+    clientRegistry.addSink(sink);
+    client->onWrite([&remote](const std::string& msg) { remote->handleMessage(msg); });
+    remote->onWrite([&client](const std::string& msg) { client->handleMessage(msg); });
+    client->linkRemote("demo.Calc");
+    remote->onWrite([](const std::string&) {});
+
+    SECTION("registry lookups do not allocate") {
+        AllocationCounter counter;
+        auto foundSink = clientRegistry.getSink("demo.Calc");
+        auto foundNode = clientRegistry.getNode("demo.Calc");
+        auto foundSource = registry.getSource("demo.Calc");
+        REQUIRE(counter.allocations() == 0);
+        REQUIRE(foundSink.lock() == sink);
+        REQUIRE_FALSE(foundNode.expired());
+        REQUIRE(foundSource.lock() == source);
+    }
+    for (auto format : { MessageFormat::JSON, MessageFormat::MSGPACK, MessageFormat::CBOR }) {
+        DYNAMIC_SECTION("steady state paths " << formatName(format)) {
+            client->setMessageFormat(format);
+            remote->setMessageFormat(format);
+            MessageConverter converter(format);
+            const auto propertyChange = converter.toString(Protocol::propertyChangeMessage("demo.Calc/total", 42));
+            const auto signal = converter.toString(Protocol::signalMessage("demo.Calc/hitUpper", nlohmann::json::array({ 1 })));
+
+            AllocationCounter counter;
+            converter.fromString(propertyChange);
+            const auto decodePropertyChange = counter.allocations();
+            counter.reset();
+            converter.fromString(signal);
+            const auto decodeSignal = counter.allocations();
+            counter.reset();
+            converter.toString(Protocol::propertyChangeMessage("demo.Calc/total", nlohmann::json(42)));
+            const auto encodePropertyChange = counter.allocations();
+
+            // warm up, e.g. lazily created metrics
+            client->handleMessage(propertyChange);
+            remote->notifyPropertyChange("demo.Calc/total", nlohmann::json(42));
+
+            counter.reset();
+            client->handleMessage(propertyChange);
+            const auto handlePropertyChange = counter.allocations();
+            REQUIRE(sink->total == 42);
+            counter.reset();
+            client->handleMessage(signal);
+            const auto handleSignal = counter.allocations();
+            REQUIRE(sink->signals == 1);
+            counter.reset();
+            remote->notifyPropertyChange("demo.Calc/total", nlohmann::json(42));
+            const auto notifyPropertyChange = counter.allocations();
+
+            report(format, "decode property change", decodePropertyChange);
+            report(format, "handleMessage property change to sink", handlePropertyChange);
+            report(format, "handleMessage signal to sink", handleSignal);
+            report(format, "encode property change", encodePropertyChange);
+            report(format, "notifyPropertyChange to writer", notifyPropertyChange);
+            REQUIRE(handlePropertyChange == decodePropertyChange);
+            REQUIRE(handleSignal == decodeSignal);
+            REQUIRE(notifyPropertyChange == encodePropertyChange);
+        }
+    }
+}
@@ -0,0 +1,111 @@
+#include <catch2/catch.hpp>
+
+#include "olink/asynclogger.h"
+#include "olink/core/types.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ApiGear::ObjectLink;
+
+namespace {
+
+/** Collects written lines, the writer can be held to fill the ring. */
+struct Output
+{
+    std::mutex mutex;
+    std::vector<std::string> lines;
+    std::size_t batches = 0;
+    std::atomic<bool> hold{ false };
+    std::atomic<bool> writing{ false };
+
+    AsyncLogger::WriteBatchFunc writeFunc()
+    {
+        return [this](const std::string& batch) {
+            writing = true;
+            while (hold) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            std::unique_lock<std::mutex> lock(mutex);
+            ++batches;
+            std::size_t start = 0;
+            for (auto end = batch.find('\n'); end != std::string::npos; end = batch.find('\n', start)) {
+                lines.push_back(batch.substr(start, end - start));
+                start = end + 1;
+            }
+        };
+    }
+};
+
+} // namespace
+
+TEST_CASE("async logger")
+{
+    Output output;
+
+    SECTION("writes records with time and level in the background") {
+        AsyncLogger logger(output.writeFunc(), 16);
+        auto log = logger.logFunc();
+        log(LogLevel::Info, "first");
+        log(LogLevel::Error, "second");
+        logger.flush();
+        REQUIRE(output.lines.size() == 2);
+        REQUIRE(output.lines[0].find("Z [info   ] first") != std::string::npos);
+        REQUIRE(output.lines[1].find("Z [error  ] second") != std::string::npos);
+        REQUIRE(output.lines[0][4] == '-');
+        REQUIRE(output.lines[0][10] == 'T');
+        REQUIRE(logger.dropped() == 0);
+    }
+    SECTION("drops and counts records when the ring is full") {
+        AsyncLogger logger(output.writeFunc(), 4);
+        output.hold = true;
+        logger.writeLog(LogLevel::Info, "taken by the writer");
+        // wait until the writer picked the record and blocks in the write
+        while (!output.writing) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        for (int i = 0; i < 10; ++i) {
+            logger.writeLog(LogLevel::Info, "record " + std::to_string(i));
+        }
+        REQUIRE(logger.dropped() == 6);
+        output.hold = false;
+        logger.flush();
+        REQUIRE(output.lines.size() == 5);
+        REQUIRE(output.lines.back().find("record 3") != std::string::npos);
+    }
+    SECTION("blocks instead of dropping if asked to") {
+        {
+            AsyncLogger logger(output.writeFunc(), 4, AsyncLogger::OverflowPolicy::Block);
+            for (int i = 0; i < 100; ++i) {
+                logger.writeLog(LogLevel::Debug, "record " + std::to_string(i));
+            }
+            REQUIRE(logger.dropped() == 0);
+        }
+        REQUIRE(output.lines.size() == 100);
+        REQUIRE(output.lines.back().find("[debug  ] record 99") != std::string::npos);
+    }
+    SECTION("takes records from many threads and writes them in batches") {
+        const int threads = 4;
+        const int perThread = 1000;
+        {
+            AsyncLogger logger(output.writeFunc(), 1 << 14);
+            std::vector<std::thread> loggers;
+            for (int t = 0; t < threads; ++t) {
+                loggers.emplace_back([&logger, t]() {
+                    for (int i = 0; i < perThread; ++i) {
+                        logger.writeLog(LogLevel::Info, std::to_string(t) + ":" + std::to_string(i));
+                    }
+                });
+            }
+            for (auto& thread : loggers) {
+                thread.join();
+            }
+        }
+        REQUIRE(output.lines.size() == threads * perThread);
+        REQUIRE(output.batches < output.lines.size());
+    }
+}
@@ -0,0 +1,113 @@
+#include <catch2/catch.hpp>
+
+#include "olink/core/protocol.h"
+#include "olink/core/typedarray.h"
+#include "olink/core/types.h"
+#include "olink/clientnode.h"
+#include "olink/clientregistry.h"
+#include "olink/iobjectsink.h"
+#include "olink/remotenode.h"
+#include "olink/remoteregistry.h"
+
+#include "nlohmann/json.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace ApiGear::ObjectLink;
+
+namespace {
+
+/** Records property changes, as blobs if binaryHandler is set. */
+class CameraSink : public IObjectSink
+{
+public:
+    explicit CameraSink(bool binaryHandler)
+        : m_binaryHandler(binaryHandler)
+    {}
+    std::string olinkObjectName() override
+    {
+        return "demo.Camera";
+    }
+    void olinkOnSignal(const std::string&, const nlohmann::json&) override {}
+    void olinkOnPropertyChanged(const std::string&, const nlohmann::json& value) override
+    {
+        values.push_back(value);
+    }
+    void olinkOnBinaryPropertyChanged(const std::string& propertyId, std::vector<std::uint8_t>&& data) override
+    {
+        if (!m_binaryHandler) {
+            IObjectSink::olinkOnBinaryPropertyChanged(propertyId, std::move(data));
+            return;
+        }
+        blobs.push_back(std::move(data));
+    }
+    void olinkOnInit(const std::string&, const nlohmann::json&, IClientNode*) override {}
+    void olinkOnRelease() override {}
+
+    std::vector<nlohmann::json> values;
+    std::vector<std::vector<std::uint8_t>> blobs;
+private:
+    bool m_binaryHandler;
+};
+
+} // namespace
+
+TEST_CASE("binary properties")
+{
+    std::vector<std::uint8_t> thumbnail(1000);
+    for (std::size_t i = 0; i < thumbnail.size(); ++i) {
+        thumbnail[i] = static_cast<std::uint8_t>(i * 7);
+    }
+    RemoteRegistry remoteRegistry;
+    ClientRegistry clientRegistry;
+    auto remote = RemoteNode::createRemoteNode(remoteRegistry);
+    auto client = ClientNode::create(clientRegistry);
+    std::string lastWritten;
+    remote->onWrite([&client, &lastWritten](const std::string& msg) { lastWritten = msg; client->handleMessage(msg); });
+
+    SECTION("blobs are byte strings in binary formats and reach the binary handler") {
+        auto sink = std::make_shared<CameraSink>(true);
+        clientRegistry.addSink(sink);
+        for (auto format : { MessageFormat::MSGPACK, MessageFormat::CBOR }) {
+            remote->setMessageFormat(format);
+            client->setMessageFormat(format);
+            remote->notifyBinaryPropertyChange("demo.Camera/thumbnail", thumbnail);
+            // the bytes plus message type, property id and headers
+            REQUIRE(lastWritten.size() < thumbnail.size() + 40);
+        }
+        REQUIRE(sink->values.empty());
+        REQUIRE(sink->blobs.size() == 2);
+        REQUIRE(sink->blobs[0] == thumbnail);
+        REQUIRE(sink->blobs[1] == thumbnail);
+        clientRegistry.removeSink("demo.Camera");
+    }
+    SECTION("default binary handler forwards the blob as binary value") {
+        auto sink = std::make_shared<CameraSink>(false);
+        clientRegistry.addSink(sink);
+        remote->setMessageFormat(MessageFormat::CBOR);
+        client->setMessageFormat(MessageFormat::CBOR);
+        remote->notifyBinaryPropertyChange("demo.Camera/thumbnail", thumbnail);
+        REQUIRE(sink->blobs.empty());
+        REQUIRE(sink->values.size() == 1);
+        REQUIRE(sink->values[0].is_binary());
+        REQUIRE(std::vector<std::uint8_t>(sink->values[0].get_binary()) == thumbnail);
+        clientRegistry.removeSink("demo.Camera");
+    }
+    SECTION("typed arrays and JSON messages go to the value handler") {
+        auto sink = std::make_shared<CameraSink>(true);
+        clientRegistry.addSink(sink);
+        remote->setMessageFormat(MessageFormat::MSGPACK);
+        client->setMessageFormat(MessageFormat::MSGPACK);
+        remote->notifyPropertyChange("demo.Camera/histogram", makeTypedArray(std::vector<std::uint32_t>{ 1, 2, 3 }));
+        remote->setMessageFormat(MessageFormat::JSON);
+        client->setMessageFormat(MessageFormat::JSON);
+        remote->notifyBinaryPropertyChange("demo.Camera/thumbnail", { 1, 2, 3 });
+        REQUIRE(sink->blobs.empty());
+        REQUIRE(sink->values.size() == 2);
+        REQUIRE(TypedArrayView<std::uint32_t>(sink->values[0]).toVector() == std::vector<std::uint32_t>({ 1, 2, 3 }));
+        REQUIRE(sink->values[1] == nlohmann::json({ { "bytes", { 1, 2, 3 } }, { "subtype", nullptr } }));
+        clientRegistry.removeSink("demo.Camera");
+    }
+}
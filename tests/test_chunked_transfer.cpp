@@ -0,0 +1,290 @@
+#include <catch2/catch.hpp>
+
+#include "allocationcounter.h"
+
+#include "olink/core/compressedcodec.h"
+#include "olink/core/protocol.h"
+#include "olink/core/types.h"
+#include "olink/clientnode.h"
+#include "olink/clientregistry.h"
+#include "olink/iobjectsink.h"
+#include "olink/remotenode.h"
+#include "olink/remoteregistry.h"
+
+#include "nlohmann/json.hpp"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ApiGear::ObjectLink;
+
+namespace {
+
+/** Records property changes and signals in the order they arrive. */
+class RecordingSink : public IObjectSink
+{
+public:
+    std::string olinkObjectName() override
+    {
+        return "demo.Store";
+    }
+    void olinkOnSignal(const std::string& signalId, const nlohmann::json& args) override
+    {
+        events.push_back({ signalId, args });
+    }
+    void olinkOnPropertyChanged(const std::string& propertyId, const nlohmann::json& value) override
+    {
+        events.push_back({ propertyId, value });
+    }
+    void olinkOnInit(const std::string&, const nlohmann::json&, IClientNode*) override {}
+    void olinkOnRelease() override {}
+
+    std::vector<std::pair<std::string, nlohmann::json>> events;
+};
+
+std::string largeText()
+{
+    std::string text;
+    for (int i = 0; text.size() < 5000; ++i) {
+        // one, two, three and four byte UTF-8 characters
+        text += "a\xc3\xa4\xe2\x82\xac\xf0\x9f\x98\x80 " + std::to_string(i) + " \"quoted\" ";
+    }
+    return text;
+}
+
+} // namespace
+
+TEST_CASE("chunked transfer")
+{
+    RemoteRegistry remoteRegistry;
+    ClientRegistry clientRegistry;
+    auto remote = RemoteNode::createRemoteNode(remoteRegistry);
+    auto client = ClientNode::create(clientRegistry);
+    auto sink = std::make_shared<RecordingSink>();
+    clientRegistry.addSink(sink);
+    std::vector<std::string> frames;
+    remote->onWrite([&frames](const std::string& msg) { frames.push_back(msg); });
+    const auto deliver = [&frames, &client]() {
+        for (const auto& frame : frames) {
+            client->handleMessage(frame);
+        }
+        frames.clear();
+    };
+
+    int chunksPending = 0;
+    const auto writeChunksInTurns = [&remote, &chunksPending]() {
+        remote->onChunksPending([&chunksPending]() { ++chunksPending; });
+    };
+
+    SECTION("large JSON messages are split at character boundaries and reassembled") {
+        writeChunksInTurns();
+        remote->setChunkSize(256);
+        REQUIRE(remote->chunkSize() == 256);
+        const auto text = largeText();
+        remote->notifyPropertyChange("demo.Store/text", text);
+        REQUIRE(frames.size() == 1);
+        REQUIRE(chunksPending == 1);
+        REQUIRE(remote->writePendingChunks() == 0);
+        REQUIRE(frames.size() > 20);
+        const auto frameCount = frames.size();
+        std::size_t frameBytes = 0;
+        for (const auto& frame : frames) {
+            const auto msg = nlohmann::json::parse(frame);
+            REQUIRE(msg[0] == int(MsgType::Chunk));
+            REQUIRE(msg[4].get<std::string>().size() <= 256);
+            frameBytes += frame.size();
+        }
+        deliver();
+        REQUIRE(sink->events.size() == 1);
+        REQUIRE(sink->events[0].first == "demo.Store/text");
+        REQUIRE(sink->events[0].second == text);
+        // only the chunk messages on the wire are counted, not the message they carry
+        const auto sent = remote->metrics()->snapshot();
+        REQUIRE(sent.forType(int(MsgType::Chunk)).messagesOut == frameCount);
+        REQUIRE(sent.total().messagesOut == frameCount);
+        REQUIRE(sent.total().bytesOut == frameBytes);
+        const auto received = client->metrics()->snapshot();
+        REQUIRE(received.forType(int(MsgType::Chunk)).messagesIn == frameCount);
+        REQUIRE(received.total().messagesIn == frameCount);
+        REQUIRE(received.total().bytesIn == frameBytes);
+    }
+    SECTION("chunks are interleaved with other messages") {
+        writeChunksInTurns();
+        remote->setChunkSize(1000);
+        remote->notifyPropertyChange("demo.Store/text", largeText());
+        remote->notifySignal("demo.Store/ping", { 1 });
+        remote->notifySignal("demo.Store/ping", { 2 });
+        REQUIRE(remote->pendingChunkedMessages() == 1);
+        REQUIRE(frames.size() == 5);
+        deliver();
+        REQUIRE(sink->events.size() == 2);
+        REQUIRE(sink->events[0].second == nlohmann::json({ 1 }));
+        REQUIRE(remote->writePendingChunks(1) == 1);
+        REQUIRE(remote->writePendingChunks() == 0);
+        deliver();
+        REQUIRE(sink->events.size() == 3);
+        REQUIRE(sink->events[2].first == "demo.Store/text");
+        REQUIRE(sink->events[2].second == largeText());
+    }
+    SECTION("binary formats send chunks as binary values") {
+        std::vector<std::uint8_t> blob(10000);
+        for (std::size_t i = 0; i < blob.size(); ++i) {
+            blob[i] = static_cast<std::uint8_t>(i * 13);
+        }
+        for (auto format : { MessageFormat::MSGPACK, MessageFormat::CBOR }) {
+            remote->setMessageFormat(format);
+            client->setMessageFormat(format);
+            remote->setChunkSize(1024);
+            remote->notifyPropertyChange("demo.Store/blob", nlohmann::json::binary(blob));
+            remote->writePendingChunks();
+            REQUIRE(frames.size() == 10);
+            for (const auto& frame : frames) {
+                REQUIRE(frame.size() < 1024 + 32);
+            }
+            deliver();
+        }
+        REQUIRE(sink->events.size() == 2);
+        REQUIRE(std::vector<std::uint8_t>(sink->events[0].second.get_binary()) == blob);
+        REQUIRE(std::vector<std::uint8_t>(sink->events[1].second.get_binary()) == blob);
+    }
+    SECTION("without a pending chunks handler all chunks are written with the message") {
+        remote->setChunkSize(BaseNode::minChunkSize);
+        remote->notifyPropertyChange("demo.Store/name", std::string(1000, 'x'));
+        REQUIRE(remote->pendingChunkedMessages() == 0);
+        REQUIRE(frames.size() > 15);
+        deliver();
+        REQUIRE(sink->events.size() == 1);
+        REQUIRE(sink->events[0].second == std::string(1000, 'x'));
+    }
+    SECTION("messages written from several threads are reassembled") {
+        std::mutex framesMutex;
+        remote->onWrite([&frames, &framesMutex](const std::string& msg) {
+            std::lock_guard<std::mutex> lock(framesMutex);
+            frames.push_back(msg);
+        });
+        remote->setChunkSize(256);
+        // all messages may be in transfer at the same time
+        client->setMaxChunkedTransfers(40);
+        const auto text = largeText();
+        std::vector<std::thread> writers;
+        for (int i = 0; i < 4; ++i) {
+            writers.emplace_back([&remote, &text]() {
+                for (int j = 0; j < 10; ++j) {
+                    remote->notifyPropertyChange("demo.Store/text", text);
+                    remote->notifySignal("demo.Store/ping", { j });
+                }
+            });
+        }
+        for (auto& writer : writers) {
+            writer.join();
+        }
+        remote->writePendingChunks();
+        deliver();
+        REQUIRE(sink->events.size() == 80);
+        for (const auto& event : sink->events) {
+            if (event.first == "demo.Store/text") {
+                REQUIRE(event.second == text);
+            }
+        }
+    }
+    SECTION("compressed JSON frames are sent at once") {
+        if (!CompressedCodec::isAvailable(Compression::LZ4)) {
+            return;
+        }
+        CompressionOptions options;
+        options.algorithm = Compression::LZ4;
+        remote->setCodec(CompressedCodec::create(IMessageCodec::create(MessageFormat::JSON), options));
+        client->setCodec(CompressedCodec::create(IMessageCodec::create(MessageFormat::JSON), options));
+        remote->setChunkSize(BaseNode::minChunkSize);
+        const auto text = largeText();
+        remote->notifyPropertyChange("demo.Store/text", text);
+        REQUIRE(frames.size() == 1);
+        REQUIRE(remote->pendingChunkedMessages() == 0);
+        deliver();
+        REQUIRE(sink->events.size() == 1);
+        REQUIRE(sink->events[0].second == text);
+    }
+    SECTION("small messages and disabled chunking send messages at once") {
+        remote->setChunkSize(10);
+        REQUIRE(remote->chunkSize() == BaseNode::minChunkSize);
+        remote->notifySignal("demo.Store/ping", { 1 });
+        remote->setChunkSize(0);
+        remote->notifyPropertyChange("demo.Store/text", largeText());
+        REQUIRE(frames.size() == 2);
+        REQUIRE(remote->pendingChunkedMessages() == 0);
+        deliver();
+        REQUIRE(sink->events.size() == 2);
+    }
+    SECTION("broken transfers are dropped") {
+        const std::string message = Protocol::signalMessage("demo.Store/ping", { 1 }).dump();
+        const auto chunk = [&message](int transferId, std::size_t offset, std::size_t length, std::size_t size) {
+            return Protocol::chunkMessage(transferId, offset, size, message.substr(offset, length)).dump();
+        };
+        // missing start
+        client->handleMessage(chunk(1, 10, 100, message.size()));
+        // gap
+        client->handleMessage(chunk(2, 0, 10, message.size()));
+        client->handleMessage(chunk(2, 12, 100, message.size()));
+        // size changes
+        client->handleMessage(chunk(3, 0, 10, message.size()));
+        client->handleMessage(chunk(3, 10, 100, message.size() + 1));
+        // too large
+        client->setMaxChunkedMessageSize(message.size() - 1);
+        client->handleMessage(chunk(4, 0, 10, message.size()));
+        client->handleMessage(chunk(4, 10, 100, message.size()));
+        REQUIRE(sink->events.empty());
+        client->setMaxChunkedMessageSize(message.size());
+        client->handleMessage(chunk(5, 0, 10, message.size()));
+        client->handleMessage(chunk(5, 10, 100, message.size()));
+        REQUIRE(sink->events.size() == 1);
+        // restarted
+        client->handleMessage(chunk(6, 0, 10, message.size()));
+        client->handleMessage(chunk(6, 0, 10, message.size()));
+        client->handleMessage(chunk(6, 10, 100, message.size()));
+        REQUIRE(sink->events.size() == 2);
+        // malformed chunk message
+        Protocol protocol;
+        REQUIRE_FALSE(protocol.handleMessage(nlohmann::json::array({ int(MsgType::Chunk), 1, -1, 10, "x" }), *client));
+        REQUIRE(protocol.lastError().find("expected [msgType, transferId, offset, size, data]") == 0);
+    }
+    SECTION("memory for reassembling messages is limited") {
+        const std::string message = Protocol::signalMessage("demo.Store/ping", { 1 }).dump();
+        const auto chunk = [&message](int transferId, std::size_t offset, std::size_t length, std::size_t size) {
+            return Protocol::chunkMessage(transferId, offset, size, message.substr(offset, length)).dump();
+        };
+        // the announced size is not allocated up front
+        AllocationCounter counter;
+        client->handleMessage(chunk(1, 0, 10, 200 * 1024 * 1024));
+        REQUIRE(counter.bytes() < 64 * 1024);
+        // open transfers
+        client->setMaxChunkedTransfers(2);
+        client->handleMessage(chunk(2, 0, 10, message.size()));
+        client->handleMessage(chunk(3, 0, 10, message.size()));
+        client->handleMessage(chunk(3, 10, 100, message.size()));
+        REQUIRE(sink->events.empty());
+        client->handleMessage(chunk(2, 10, 100, message.size()));
+        REQUIRE(sink->events.size() == 1);
+        // bytes of all open transfers, transfer 1 still holds 10 bytes
+        client->setMaxChunkedBytes(message.size() + 5);
+        client->handleMessage(chunk(4, 0, 10, message.size()));
+        client->handleMessage(chunk(4, 10, 100, message.size()));
+        REQUIRE(sink->events.size() == 1);
+        client->setMaxChunkedBytes(message.size() + 10);
+        client->handleMessage(chunk(5, 0, 10, message.size()));
+        client->handleMessage(chunk(5, 10, 100, message.size()));
+        REQUIRE(sink->events.size() == 2);
+        // the bytes of completed and dropped transfers are released
+        client->handleMessage(chunk(6, 0, 10, message.size()));
+        client->handleMessage(chunk(6, 10, 100, message.size()));
+        REQUIRE(sink->events.size() == 3);
+        // a limit lowered below the buffered bytes
+        client->handleMessage(chunk(7, 0, 10, message.size()));
+        client->setMaxChunkedBytes(5);
+        client->handleMessage(chunk(7, 10, 100, message.size()));
+        REQUIRE(sink->events.size() == 3);
+    }
+    clientRegistry.removeSink("demo.Store");
+}
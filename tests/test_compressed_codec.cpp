@@ -0,0 +1,191 @@
+#include <catch2/catch.hpp>
+
+#include "allocationcounter.h"
+
+#include "olink/core/compressedcodec.h"
+#include "olink/core/messagecodec.h"
+#include "olink/core/protocol.h"
+#include "olink/core/types.h"
+
+#include "nlohmann/json.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace ApiGear::ObjectLink;
+
+namespace {
+
+/** A large, repetitive init message like the ones of objects with many structured properties. */
+nlohmann::json repetitiveMessage()
+{
+    nlohmann::json props = nlohmann::json::object();
+    for (int i = 0; i < 40; ++i) {
+        props["sensor" + std::to_string(i)] = { { "name", "temperature sensor" }, { "unit", "celsius" }, { "value", i * 0.5 }, { "valid", true } };
+    }
+    return Protocol::initMessage("org.demo.Sensors", props);
+}
+
+std::vector<Compression> availableAlgorithms()
+{
+    std::vector<Compression> result;
+    for (auto algorithm : { Compression::LZ4, Compression::Zstd }) {
+        if (CompressedCodec::isAvailable(algorithm)) {
+            result.push_back(algorithm);
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+TEST_CASE("compressed codec")
+{
+    const auto json = IMessageCodec::create(MessageFormat::JSON);
+    const auto large = repetitiveMessage();
+    const auto small = Protocol::propertyChangeMessage("org.demo.Sensors/count", 42);
+    REQUIRE(CompressedCodec::isAvailable(Compression::None));
+
+    SECTION("frames above the threshold are compressed") {
+        for (auto algorithm : availableAlgorithms()) {
+            CompressionOptions options;
+            options.algorithm = algorithm;
+            auto codec = CompressedCodec::create(json, options);
+            REQUIRE(codec);
+            REQUIRE(codec->format() == MessageFormat::JSON);
+            REQUIRE(codec->codec() == json);
+
+            std::string data;
+            codec->encode(large, data);
+            REQUIRE(data[0] == static_cast<char>(algorithm));
+            REQUIRE(data.size() * 4 < large.dump().size());
+            nlohmann::json decoded;
+            codec->decode(data.data(), data.size(), decoded, false);
+            REQUIRE(decoded == large);
+
+            codec->encode(small, data);
+            REQUIRE(data == std::string(1, '\0') + small.dump());
+            codec->decode(data.data(), data.size(), decoded, false);
+            REQUIRE(decoded == small);
+        }
+    }
+    SECTION("without compression frames are only flagged") {
+        CompressionOptions options;
+        options.algorithm = Compression::None;
+        auto codec = CompressedCodec::create(json, options);
+        REQUIRE(codec);
+        std::string data;
+        codec->encode(large, data);
+        REQUIRE(data == std::string(1, '\0') + large.dump());
+    }
+    SECTION("frames which do not get smaller are sent uncompressed") {
+        for (auto algorithm : availableAlgorithms()) {
+            CompressionOptions options;
+            options.algorithm = algorithm;
+            options.threshold = 0;
+            auto codec = CompressedCodec::create(json, options);
+            std::string data;
+            codec->encode(small, data);
+            REQUIRE(data[0] == '\0');
+        }
+    }
+    SECTION("corrupted frames are rejected") {
+        for (auto algorithm : availableAlgorithms()) {
+            CompressionOptions options;
+            options.algorithm = algorithm;
+            options.maxFrameSize = 100000;
+            auto codec = CompressedCodec::create(json, options);
+            std::string data;
+            codec->encode(large, data);
+            std::vector<std::string> broken = { std::string(), std::string("\x07", 1), data.substr(0, 3), data.substr(0, data.size() / 2) };
+            auto wrongSize = data;
+            wrongSize[1] = static_cast<char>(wrongSize[1] + 1);
+            broken.push_back(wrongSize);
+            auto tooLarge = data;
+            tooLarge[4] = '\x7f';
+            broken.push_back(tooLarge);
+            for (const auto& frame : broken) {
+                nlohmann::json decoded;
+                codec->decode(frame.data(), frame.size(), decoded, false);
+                REQUIRE(decoded.is_discarded());
+                REQUIRE_THROWS_AS(codec->decode(frame.data(), frame.size(), decoded, true), nlohmann::json::parse_error);
+            }
+        }
+    }
+    SECTION("announced sizes are bounded by the compressed size before allocating") {
+        for (auto algorithm : availableAlgorithms()) {
+            CompressionOptions options;
+            options.algorithm = algorithm;
+            auto codec = CompressedCodec::create(json, options);
+            // 256 MiB announced, nothing compressed
+            const char hostile[] = { static_cast<char>(algorithm), 0, 0, 0, 0x10, 0x28, static_cast<char>(0xb5), 0x2f, static_cast<char>(0xfd) };
+            for (std::size_t size : { std::size_t(5), sizeof(hostile) }) {
+                AllocationCounter counter;
+                nlohmann::json decoded;
+                codec->decode(hostile, size, decoded, false);
+                REQUIRE(decoded.is_discarded());
+                REQUIRE(counter.bytes() < 64 * 1024);
+            }
+            // highly compressible frames are still accepted
+            const auto uniform = Protocol::propertyChangeMessage("org.demo.Sensors/text", std::string(1024 * 1024, 'x'));
+            std::string data;
+            codec->encode(uniform, data);
+            REQUIRE(data[0] == static_cast<char>(algorithm));
+            nlohmann::json decoded;
+            codec->decode(data.data(), data.size(), decoded, false);
+            REQUIRE(decoded == uniform);
+        }
+    }
+    SECTION("unavailable algorithms and invalid dictionaries are refused") {
+        CompressionOptions options;
+        options.algorithm = static_cast<Compression>(9);
+        REQUIRE_FALSE(CompressedCodec::create(json, options));
+        options.algorithm = Compression::None;
+        REQUIRE_FALSE(CompressedCodec::create(nullptr, options));
+        options.dictionary = "no dictionary";
+        REQUIRE_FALSE(CompressedCodec::create(json, options));
+        REQUIRE(CompressedCodec::dictionaryId(options.dictionary) == 0);
+    }
+    if (CompressedCodec::isAvailable(Compression::Zstd)) {
+        SECTION("trained dictionaries shrink small messages") {
+            std::vector<std::string> samples;
+            std::vector<nlohmann::json> messages;
+            for (int i = 0; i < 500; ++i) {
+                messages.push_back(Protocol::propertyChangeMessage("org.demo.Sensors/sensor" + std::to_string(i % 40),
+                    { { "name", "temperature sensor" }, { "unit", "celsius" }, { "value", i * 0.25 }, { "valid", i % 3 != 0 } }));
+                samples.push_back(messages.back().dump());
+            }
+            const auto dictionary = CompressedCodec::trainDictionary(samples, 4096);
+            REQUIRE_FALSE(dictionary.empty());
+            REQUIRE(CompressedCodec::dictionaryId(dictionary) != 0);
+
+            CompressionOptions options;
+            options.algorithm = Compression::Zstd;
+            options.threshold = 0;
+            auto plain = CompressedCodec::create(json, options);
+            options.dictionary = dictionary;
+            auto trained = CompressedCodec::create(json, options);
+            REQUIRE(trained);
+            std::size_t plainBytes = 0;
+            std::size_t trainedBytes = 0;
+            std::string data;
+            for (const auto& message : messages) {
+                plain->encode(message, data);
+                plainBytes += data.size();
+                trained->encode(message, data);
+                trainedBytes += data.size();
+                nlohmann::json decoded;
+                trained->decode(data.data(), data.size(), decoded, false);
+                REQUIRE(decoded == message);
+            }
+            REQUIRE(trainedBytes * 2 < plainBytes);
+
+            // frames compressed with a dictionary can not be read without it
+            trained->encode(messages[0], data);
+            REQUIRE(data[0] == static_cast<char>(Compression::Zstd));
+            nlohmann::json decoded;
+            plain->decode(data.data(), data.size(), decoded, false);
+            REQUIRE(decoded.is_discarded());
+        }
+    }
+}
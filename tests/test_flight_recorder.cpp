@@ -0,0 +1,131 @@
+#include <catch2/catch.hpp>
+
+#include "olink/core/flightrecorder.h"
+#include "olink/core/types.h"
+#include "olink/clientnode.h"
+#include "olink/clientregistry.h"
+#include "olink/remotenode.h"
+#include "olink/remoteregistry.h"
+
+#include "sinkobject.hpp"
+#include "sourceobject.hpp"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ApiGear::ObjectLink;
+
+TEST_CASE("flight recorder")
+{
+    SECTION("keeps the most recent messages, oldest first") {
+        FlightRecorder recorder(4);
+        for (int i = 0; i < 6; ++i) {
+            const auto data = "[" + std::to_string(i) + "]";
+            recorder.record(CaptureDirection::Sent, MessageFormat::JSON, int(MsgType::Signal), "demo.Calc/hit", data.data(), data.size());
+        }
+        REQUIRE(recorder.recorded() == 6);
+        auto records = recorder.snapshot();
+        REQUIRE(records.size() == 4);
+        REQUIRE(records.front().sequence == 2);
+        REQUIRE(records.front().prefix == "[2]");
+        REQUIRE(records.back().sequence == 5);
+        REQUIRE(records.back().prefix == "[5]");
+        REQUIRE(records.back().memberId == "demo.Calc/hit");
+        REQUIRE(records.back().msgType == int(MsgType::Signal));
+        REQUIRE(records.back().direction == CaptureDirection::Sent);
+        REQUIRE(records.front().time <= records.back().time);
+
+        recorder.clear();
+        REQUIRE(recorder.snapshot().empty());
+    }
+    SECTION("cuts member ids and payloads") {
+        FlightRecorder recorder(2);
+        const std::string memberId(100, 'm');
+        const std::string data(1000, 'x');
+        recorder.record(CaptureDirection::Received, MessageFormat::JSON, -1, memberId.c_str(), data.data(), data.size());
+        recorder.record(CaptureDirection::Received, MessageFormat::CBOR, int(MsgType::Link), nullptr, "\x82\x0a", 2);
+        auto records = recorder.snapshot();
+        REQUIRE(records.size() == 2);
+        REQUIRE(records[0].memberId == memberId.substr(0, FlightRecorder::memberIdCapacity));
+        REQUIRE(records[0].prefix == data.substr(0, FlightRecorder::prefixCapacity));
+        REQUIRE(records[0].size == data.size());
+        REQUIRE(records[1].memberId.empty());
+
+        const auto dump = recorder.dump();
+        REQUIRE(dump.find("#0 ") == 0);
+        REQUIRE(dump.find(" in ? " + memberId.substr(0, FlightRecorder::memberIdCapacity) + " 1000B xxx") != std::string::npos);
+        REQUIRE(dump.find("...\n") != std::string::npos);
+        REQUIRE(dump.find(" in link - 2B 820a\n") != std::string::npos);
+    }
+    SECTION("can be read while messages are recorded") {
+        FlightRecorder recorder(8);
+        std::atomic<bool> done{ false };
+        std::vector<std::thread> writers;
+        for (int w = 0; w < 2; ++w) {
+            writers.emplace_back([&recorder, &done, w]() {
+                const std::string data = w == 0 ? "[aaaaaaaa]" : "[bbbbbbbb]";
+                while (!done) {
+                    recorder.record(CaptureDirection::Sent, MessageFormat::JSON, w, nullptr, data.data(), data.size());
+                }
+            });
+        }
+        for (int i = 0; i < 1000; ++i) {
+            for (const auto& record : recorder.snapshot()) {
+                // a record is never mixed from two messages
+                REQUIRE(record.prefix == (record.msgType == 0 ? "[aaaaaaaa]" : "[bbbbbbbb]"));
+            }
+        }
+        done = true;
+        for (auto& writer : writers) {
+            writer.join();
+        }
+    }
+    SECTION("nodes record messages and dump them on error") {
+        RemoteRegistry registry;
+        ClientRegistry clientRegistry;
+        auto remote = RemoteNode::createRemoteNode(registry);
+        auto source = std::make_shared<CalcSource>(registry);
+        registry.addSource(source);
+        auto client = ClientNode::create(clientRegistry);
+        auto sink = std::make_shared<CalcSink>(clientRegistry);
+        clientRegistry.addSink(sink);
+        client->onWrite([&remote](const std::string& msg) { remote->handleMessage(msg); });
+        remote->onWrite([&client](const std::string& msg) { client->handleMessage(msg); });
+
+        auto recorder = std::make_shared<FlightRecorder>(16);
+        client->setFlightRecorder(recorder);
+        REQUIRE(client->flightRecorder() == recorder);
+        std::vector<std::string> errors;
+        client->onLog([&errors](LogLevel level, const std::string& msg) {
+            if (level == LogLevel::Error) {
+                errors.push_back(msg);
+            }
+        });
+        client->linkRemote("demo.Calc");
+        sink->setTotal(5);
+
+        auto records = recorder->snapshot();
+        REQUIRE(records.size() == 4);
+        REQUIRE(records[0].direction == CaptureDirection::Sent);
+        REQUIRE(records[0].msgType == int(MsgType::Link));
+        REQUIRE(records[0].memberId == "demo.Calc");
+        REQUIRE(records[1].direction == CaptureDirection::Received);
+        REQUIRE(records[1].msgType == int(MsgType::Init));
+        REQUIRE(records[2].msgType == int(MsgType::SetProperty));
+        REQUIRE(records[2].memberId == "demo.Calc/total");
+        REQUIRE(records[3].msgType == int(MsgType::PropertyChange));
+        REQUIRE(errors.empty());
+
+        client->handleMessage("[4]");
+        REQUIRE(errors.size() == 1);
+        REQUIRE(errors[0].find("flight recorder") == 0);
+        REQUIRE(errors[0].find("[4]") != std::string::npos);
+
+        client->setFlightRecorder(recorder, false);
+        client->handleMessage("[4]");
+        REQUIRE(errors.size() == 1);
+    }
+}
@@ -0,0 +1,136 @@
+#include <catch2/catch.hpp>
+
+#include "olink/core/framedecoder.h"
+#include "olink/core/types.h"
+
+#include <string>
+#include <vector>
+
+using namespace ApiGear::ObjectLink;
+
+namespace {
+    // Message handler which collects received frames and remembers where their data was located.
+    class FrameCollector : public IMessageHandler
+    {
+    public:
+        void handleMessage(const std::string& message) override
+        {
+            frames.push_back(message);
+        }
+        void handleMessage(const char* data, std::size_t size) override
+        {
+            locations.push_back(data);
+            frames.push_back(std::string(data, size));
+        }
+        std::vector<std::string> frames;
+        std::vector<const char*> locations;
+    };
+
+    // Helper function, feeds the stream in chunks of given size.
+    bool feedInChunks(FrameDecoder& decoder, const std::string& stream, std::size_t chunkSize)
+    {
+        for (std::size_t position = 0; position < stream.size(); position += chunkSize) {
+            auto chunk = stream.substr(position, chunkSize);
+            if (!decoder.feed(chunk.data(), chunk.size())) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+TEST_CASE("Frame decoder")
+{
+    FrameCollector collector;
+    std::vector<std::string> messages = { "[10,\"demo.Calc\"]", std::string(300, 'x'), "a", std::string(70000, 'y') };
+    std::string lengthPrefixedStream;
+    std::string newlineStream;
+    for (const auto& message : messages) {
+        lengthPrefixedStream += FrameDecoder::encodeFrame(message, FramingMode::LengthPrefixed);
+        newlineStream += FrameDecoder::encodeFrame(message, FramingMode::NewlineDelimited);
+    }
+
+    SECTION("length prefix is a LEB128 varint")
+    {
+        REQUIRE(FrameDecoder::encodeFrame("a") == std::string("\x01" "a"));
+        auto frame = FrameDecoder::encodeFrame(std::string(300, 'x'));
+        REQUIRE(frame.size() == 302);
+        REQUIRE(static_cast<unsigned char>(frame[0]) == 0xac);
+        REQUIRE(static_cast<unsigned char>(frame[1]) == 0x02);
+    }
+
+    SECTION("frames inside one chunk are passed without copying")
+    {
+        FrameDecoder decoder(collector);
+        REQUIRE(decoder.feed(lengthPrefixedStream.data(), lengthPrefixedStream.size()));
+        REQUIRE(collector.frames == messages);
+        for (auto location : collector.locations) {
+            REQUIRE(location >= lengthPrefixedStream.data());
+            REQUIRE(location < lengthPrefixedStream.data() + lengthPrefixedStream.size());
+        }
+        REQUIRE(decoder.pendingSize() == 0);
+    }
+
+    SECTION("frames split between chunks of any size are assembled")
+    {
+        for (std::size_t chunkSize : { 1, 2, 3, 7, 64, 299, 4096 }) {
+            collector.frames.clear();
+            FrameDecoder lengthPrefixedDecoder(collector, FramingMode::LengthPrefixed);
+            REQUIRE(feedInChunks(lengthPrefixedDecoder, lengthPrefixedStream, chunkSize));
+            REQUIRE(collector.frames == messages);
+
+            collector.frames.clear();
+            FrameDecoder newlineDecoder(collector, FramingMode::NewlineDelimited);
+            REQUIRE(feedInChunks(newlineDecoder, newlineStream, chunkSize));
+            REQUIRE(collector.frames == messages);
+        }
+    }
+
+    SECTION("incomplete frame is kept until the rest arrives")
+    {
+        FrameDecoder decoder(collector);
+        auto frame = FrameDecoder::encodeFrame(messages[1]);
+        REQUIRE(decoder.feed(frame.data(), 100));
+        REQUIRE(collector.frames.empty());
+        REQUIRE(decoder.pendingSize() == 100);
+        REQUIRE(decoder.feed(frame.data() + 100, frame.size() - 100));
+        REQUIRE(collector.frames.size() == 1);
+        REQUIRE(collector.frames[0] == messages[1]);
+        REQUIRE(decoder.pendingSize() == 0);
+    }
+
+    SECTION("empty frames are skipped")
+    {
+        FrameDecoder lengthPrefixedDecoder(collector, FramingMode::LengthPrefixed);
+        std::string stream = FrameDecoder::encodeFrame("") + FrameDecoder::encodeFrame("a") + FrameDecoder::encodeFrame("");
+        REQUIRE(lengthPrefixedDecoder.feed(stream.data(), stream.size()));
+        FrameDecoder newlineDecoder(collector, FramingMode::NewlineDelimited);
+        stream = "\n\na\n";
+        REQUIRE(newlineDecoder.feed(stream.data(), stream.size()));
+        REQUIRE(collector.frames == std::vector<std::string>{ "a", "a" });
+    }
+
+    SECTION("frame bigger than max frame size corrupts the stream until reset")
+    {
+        FrameDecoder decoder(collector, FramingMode::LengthPrefixed, 100);
+        auto tooBig = FrameDecoder::encodeFrame(messages[1]);
+        REQUIRE(decoder.feed(tooBig.data(), 2) == false);
+        auto valid = FrameDecoder::encodeFrame("a");
+        REQUIRE(decoder.feed(valid.data(), valid.size()) == false);
+        REQUIRE(collector.frames.empty());
+
+        decoder.reset();
+        REQUIRE(decoder.feed(valid.data(), valid.size()));
+        REQUIRE(collector.frames.size() == 1);
+
+        FrameDecoder newlineDecoder(collector, FramingMode::NewlineDelimited, 100);
+        REQUIRE(feedInChunks(newlineDecoder, messages[1], 64) == false);
+    }
+
+    SECTION("size prefix longer than 64 bits is rejected")
+    {
+        FrameDecoder decoder(collector);
+        std::string invalidPrefix(10, '\xff');
+        REQUIRE(decoder.feed(invalidPrefix.data(), invalidPrefix.size()) == false);
+    }
+}
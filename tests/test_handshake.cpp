@@ -0,0 +1,419 @@
+#include <catch2/catch.hpp>
+
+#include "olink/core/compressedcodec.h"
+#include "olink/core/handshake.h"
+#include "olink/core/protocol.h"
+#include "olink/core/types.h"
+#include "olink/clientnode.h"
+#include "olink/clientregistry.h"
+#include "olink/iobjectsink.h"
+#include "olink/iobjectsource.h"
+#include "olink/remotenode.h"
+#include "olink/remoteregistry.h"
+
+#include "nlohmann/json.hpp"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ApiGear::ObjectLink;
+
+namespace {
+
+class StoreSource : public IObjectSource
+{
+public:
+    std::string olinkObjectName() override
+    {
+        return "demo.Store";
+    }
+    nlohmann::json olinkInvoke(const std::string&, const nlohmann::json& args) override
+    {
+        return args;
+    }
+    void olinkSetProperty(const std::string&, const nlohmann::json&) override {}
+    void olinkLinked(const std::string&, IRemoteNode*) override {}
+    void olinkUnlinked(const std::string&) override {}
+    nlohmann::json olinkCollectProperties() override
+    {
+        return { { "name", "store" }, { "count", 3 } };
+    }
+};
+
+class StoreSink : public IObjectSink
+{
+public:
+    std::string olinkObjectName() override
+    {
+        return "demo.Store";
+    }
+    void olinkOnSignal(const std::string&, const nlohmann::json&) override {}
+    void olinkOnPropertyChanged(const std::string& propertyId, const nlohmann::json& value) override
+    {
+        changes.push_back({ propertyId, value });
+    }
+    void olinkOnInit(const std::string&, const nlohmann::json& props, IClientNode*) override
+    {
+        initProps = props;
+    }
+    void olinkOnRelease() override {}
+
+    nlohmann::json initProps;
+    std::vector<std::pair<std::string, nlohmann::json>> changes;
+};
+
+bool isJsonFrame(const std::string& frame)
+{
+    return !frame.empty() && frame[0] == '[';
+}
+
+std::string trainStoreDictionary()
+{
+    std::vector<std::string> samples;
+    for (int i = 0; i < 500; ++i) {
+        samples.push_back(Protocol::propertyChangeMessage("demo.Store/item" + std::to_string(i % 40),
+            { { "name", "store item" }, { "unit", "pieces" }, { "count", i }, { "valid", i % 3 != 0 } }).dump());
+    }
+    return CompressedCodec::trainDictionary(samples, 4096);
+}
+
+} // namespace
+
+TEST_CASE("handshake choice")
+{
+    NodeCapabilities server;
+    server.formats = { MessageFormat::CBOR, MessageFormat::MSGPACK, MessageFormat::JSON };
+    server.features = { "chunks", "batching" };
+    NodeCapabilities client;
+    client.formats = { MessageFormat::JSON, MessageFormat::MSGPACK };
+    client.features = { "batching", "interning", "chunks" };
+
+    SECTION("the answering node picks its preferred format among the offered ones") {
+        const auto offer = Handshake::offer(client);
+        REQUIRE(offer["formats"] == nlohmann::json({ "json", "msgpack" }));
+        const auto choice = Handshake::choose(server, offer, MessageFormat::JSON);
+        REQUIRE(choice["format"] == "msgpack");
+        REQUIRE(choice["features"] == nlohmann::json({ "chunks", "batching" }));
+    }
+    SECTION("without a common format the current one is kept") {
+        client.formats = { MessageFormat::BSON };
+        const auto choice = Handshake::choose(server, Handshake::offer(client), MessageFormat::JSON);
+        REQUIRE(choice["format"] == "json");
+    }
+    SECTION("malformed offers choose nothing") {
+        const auto choice = Handshake::choose(server, { { "formats", "cbor" }, { "features", { 1, 2 } } }, MessageFormat::JSON);
+        REQUIRE(choice["format"] == "json");
+        REQUIRE(choice["features"].empty());
+    }
+    SECTION("at most one available compression is chosen") {
+        server.features = { "zstd", "lz4" };
+        client.features = { "lz4", "zstd" };
+        const auto choice = Handshake::choose(server, Handshake::offer(client), MessageFormat::JSON);
+        std::vector<std::string> expected;
+        if (CompressedCodec::isAvailable(Compression::Zstd)) {
+            expected.push_back("zstd");
+        } else if (CompressedCodec::isAvailable(Compression::LZ4)) {
+            expected.push_back("lz4");
+        }
+        REQUIRE(choice["features"] == nlohmann::json(expected));
+    }
+    SECTION("a shared dictionary is sent to peers which offer zstd without it") {
+        if (!CompressedCodec::isAvailable(Compression::Zstd)) {
+            return;
+        }
+        server.features = { "zstd" };
+        server.compression.dictionary = trainStoreDictionary();
+        const auto feature = "zstd:" + std::to_string(CompressedCodec::dictionaryId(server.compression.dictionary));
+        client.features = { "zstd" };
+        auto choice = Handshake::choose(server, Handshake::offer(client), MessageFormat::JSON);
+        REQUIRE(choice["features"].empty());
+        REQUIRE(Handshake::sharedDictionary(choice).empty());
+        server.shareDictionary = true;
+        for (auto format : { MessageFormat::JSON, MessageFormat::CBOR }) {
+            choice = Handshake::choose(server, Handshake::offer(client), format);
+            REQUIRE(choice["features"] == nlohmann::json({ feature }));
+            REQUIRE(choice["dictionary"].is_binary() == (format != MessageFormat::JSON));
+            REQUIRE(Handshake::sharedDictionary(choice) == server.compression.dictionary);
+        }
+        // peers with the same dictionary do not get it again
+        client.compression.dictionary = server.compression.dictionary;
+        choice = Handshake::choose(server, Handshake::offer(client), MessageFormat::JSON);
+        REQUIRE(choice["features"] == nlohmann::json({ feature }));
+        REQUIRE(choice.find("dictionary") == choice.end());
+        // a dictionary not matching the chosen feature is ignored
+        choice = { { "features", { feature } }, { "dictionary", { 1, 2, 3 } } };
+        REQUIRE(Handshake::sharedDictionary(choice).empty());
+    }
+    SECTION("format names") {
+        for (auto format : { MessageFormat::JSON, MessageFormat::BSON, MessageFormat::MSGPACK, MessageFormat::CBOR }) {
+            MessageFormat parsed = MessageFormat::JSON;
+            REQUIRE(parseMessageFormat(toString(format), parsed));
+            REQUIRE(parsed == format);
+        }
+        MessageFormat unchanged = MessageFormat::CBOR;
+        REQUIRE_FALSE(parseMessageFormat("xml", unchanged));
+        REQUIRE(unchanged == MessageFormat::CBOR);
+    }
+}
+
+TEST_CASE("handshake between nodes")
+{
+    RemoteRegistry remoteRegistry;
+    ClientRegistry clientRegistry;
+    auto source = std::make_shared<StoreSource>();
+    remoteRegistry.addSource(source);
+    auto sink = std::make_shared<StoreSink>();
+    clientRegistry.addSink(sink);
+    // declared before the nodes, the client node writes unlink messages when it is destroyed
+    std::vector<std::string> toRemote;
+    std::vector<std::string> toClient;
+    auto remote = RemoteNode::createRemoteNode(remoteRegistry);
+    auto client = ClientNode::create(clientRegistry);
+    client->onWrite([&toRemote](const std::string& msg) { toRemote.push_back(msg); });
+    remote->onWrite([&toClient](const std::string& msg) { toClient.push_back(msg); });
+    const auto deliver = [&]() {
+        while (!toRemote.empty() || !toClient.empty()) {
+            auto frames = std::move(toRemote);
+            toRemote.clear();
+            for (const auto& frame : frames) {
+                remote->handleMessage(frame);
+            }
+            frames = std::move(toClient);
+            toClient.clear();
+            for (const auto& frame : frames) {
+                client->handleMessage(frame);
+            }
+        }
+    };
+
+    NodeCapabilities server;
+    server.formats = { MessageFormat::CBOR, MessageFormat::MSGPACK, MessageFormat::JSON };
+    server.features = { "chunks", "batching" };
+    remote->setCapabilities(server);
+
+    SECTION("native clients move to a binary format") {
+        NodeCapabilities native;
+        native.formats = { MessageFormat::MSGPACK, MessageFormat::JSON };
+        native.features = { "chunks", "interning" };
+        client->setCapabilities(native);
+        client->startHandshake();
+        REQUIRE(client->isHandshakePending());
+        client->linkRemote("demo.Store");
+        // the link is held back until the reply arrives
+        REQUIRE(toRemote.size() == 1);
+        REQUIRE(isJsonFrame(toRemote[0]));
+        REQUIRE(nlohmann::json::parse(toRemote[0])[0] == int(MsgType::Handshake));
+        remote->handleMessage(toRemote[0]);
+        toRemote.clear();
+        REQUIRE(remote->codec()->format() == MessageFormat::MSGPACK);
+        REQUIRE(toClient.size() == 1);
+        REQUIRE(isJsonFrame(toClient[0]));
+        client->handleMessage(toClient[0]);
+        toClient.clear();
+        REQUIRE_FALSE(client->isHandshakePending());
+        REQUIRE(client->codec()->format() == MessageFormat::MSGPACK);
+        REQUIRE(client->negotiatedFeatures() == std::vector<std::string>{ "chunks" });
+        REQUIRE(remote->hasFeature("chunks"));
+        REQUIRE_FALSE(remote->hasFeature("batching"));
+        REQUIRE(toRemote.size() == 1);
+        REQUIRE(nlohmann::json::from_msgpack(toRemote[0]) == Protocol::linkMessage("demo.Store"));
+        deliver();
+        REQUIRE(sink->initProps["count"] == 3);
+        remote->notifyPropertyChange("demo.Store/count", 4);
+        REQUIRE(toClient.size() == 1);
+        REQUIRE_FALSE(isJsonFrame(toClient[0]));
+        deliver();
+        REQUIRE(sink->changes.size() == 1);
+        REQUIRE(sink->changes[0].second == 4);
+    }
+    SECTION("browser like clients keep JSON") {
+        NodeCapabilities browser;
+        browser.formats = { MessageFormat::JSON };
+        client->setCapabilities(browser);
+        client->startHandshake();
+        client->linkRemote("demo.Store");
+        deliver();
+        REQUIRE(client->codec()->format() == MessageFormat::JSON);
+        REQUIRE(remote->codec()->format() == MessageFormat::JSON);
+        REQUIRE(client->negotiatedFeatures().empty());
+        REQUIRE(sink->initProps["name"] == "store");
+    }
+    SECTION("negotiated compression wraps the codec") {
+        if (!CompressedCodec::isAvailable(Compression::LZ4)) {
+            return;
+        }
+        server.features = { "lz4" };
+        remote->setCapabilities(server);
+        NodeCapabilities native;
+        native.formats = { MessageFormat::CBOR };
+        native.features = { "lz4" };
+        client->setCapabilities(native);
+        client->startHandshake();
+        client->linkRemote("demo.Store");
+        deliver();
+        const auto codec = std::dynamic_pointer_cast<CompressedCodec>(client->codec());
+        REQUIRE(codec);
+        REQUIRE(codec->format() == MessageFormat::CBOR);
+        REQUIRE(std::dynamic_pointer_cast<CompressedCodec>(remote->codec()));
+        REQUIRE(sink->initProps["count"] == 3);
+        // fan-out buffers of the plain format and of the node's codec
+        const auto change = Protocol::propertyChangeMessage("demo.Store/count", 4);
+        remote->emitWriteBuffer(std::make_shared<const std::string>(MessageConverter(MessageFormat::CBOR).toString(change)));
+        remote->emitWriteBuffer(std::make_shared<const std::string>(MessageConverter(remote->codec()).toString(change)));
+        REQUIRE(toClient.size() == 2);
+        REQUIRE(toClient[0] == toClient[1]);
+        deliver();
+        REQUIRE(sink->changes.size() == 2);
+    }
+    SECTION("the answering node shares its dictionary") {
+        if (!CompressedCodec::isAvailable(Compression::Zstd)) {
+            return;
+        }
+        server.features = { "zstd" };
+        server.compression.dictionary = trainStoreDictionary();
+        server.shareDictionary = true;
+        remote->setCapabilities(server);
+        NodeCapabilities native;
+        native.formats = { MessageFormat::CBOR };
+        native.features = { "zstd" };
+        client->setCapabilities(native);
+        client->startHandshake();
+        client->linkRemote("demo.Store");
+        deliver();
+        const auto codec = std::dynamic_pointer_cast<CompressedCodec>(client->codec());
+        REQUIRE(codec);
+        REQUIRE(codec->options().dictionary == server.compression.dictionary);
+        REQUIRE(sink->initProps["count"] == 3);
+        remote->notifyPropertyChange("demo.Store/count", 4);
+        deliver();
+        REQUIRE(sink->changes.size() == 1);
+    }
+    SECTION("peers without chunk support get messages at once") {
+        NodeCapabilities native;
+        native.formats = { MessageFormat::MSGPACK };
+        client->setCapabilities(native);
+        client->startHandshake();
+        deliver();
+        remote->setChunkSize(BaseNode::minChunkSize);
+        remote->notifyPropertyChange("demo.Store/name", std::string(1000, 'x'));
+        REQUIRE(toClient.size() == 1);
+        REQUIRE(remote->pendingChunkedMessages() == 0);
+    }
+    SECTION("chunks in flight are sent before the handshake reply") {
+        client->linkRemote("demo.Store");
+        deliver();
+        remote->onChunksPending([]() {});
+        remote->setChunkSize(BaseNode::minChunkSize);
+        remote->notifyPropertyChange("demo.Store/name", std::string(1000, 'x'));
+        REQUIRE(remote->pendingChunkedMessages() == 1);
+        NodeCapabilities native;
+        native.formats = { MessageFormat::MSGPACK };
+        native.features = { "chunks" };
+        client->setCapabilities(native);
+        client->startHandshake();
+        remote->handleMessage(toRemote[0]);
+        toRemote.clear();
+        REQUIRE(remote->pendingChunkedMessages() == 0);
+        REQUIRE(toClient.size() > 2);
+        // the client switches to the chosen format with the reply, all chunks in the old format come before it
+        for (std::size_t i = 0; i + 1 < toClient.size(); ++i) {
+            REQUIRE(nlohmann::json::parse(toClient[i])[0] == int(MsgType::Chunk));
+        }
+        REQUIRE(nlohmann::json::parse(toClient.back())[0] == int(MsgType::HandshakeReply));
+        deliver();
+        REQUIRE(client->codec()->format() == MessageFormat::MSGPACK);
+        REQUIRE(sink->changes.size() == 1);
+        REQUIRE(sink->changes[0].second == std::string(1000, 'x'));
+    }
+    SECTION("compact messages of protocol v2") {
+        server.features = { "compact" };
+        remote->setCapabilities(server);
+        NodeCapabilities native;
+        native.formats = { MessageFormat::JSON };
+        native.features = { "compact" };
+        client->setCapabilities(native);
+        client->startHandshake();
+        client->linkRemote("demo.Store");
+        deliver();
+        REQUIRE(sink->initProps["count"] == 3);
+        std::vector<InvokeReplyArg> replies;
+        client->invokeRemote("demo.Store/echo", { 42 }, [&replies](InvokeReplyArg arg) { replies.push_back(std::move(arg)); });
+        REQUIRE(nlohmann::json::parse(toRemote[0])[0] == int(MsgType::CompactInvoke));
+        remote->handleMessage(toRemote[0]);
+        toRemote.clear();
+        const auto reply = nlohmann::json::parse(toClient[0]);
+        REQUIRE(reply.size() == 3);
+        REQUIRE(reply[0] == int(MsgType::CompactInvokeReply));
+        REQUIRE(reply[2] == nlohmann::json({ 42 }));
+        deliver();
+        REQUIRE(replies.size() == 1);
+        REQUIRE(replies[0].methodId == "demo.Store/echo");
+        REQUIRE(replies[0].value == nlohmann::json({ 42 }));
+        REQUIRE(client->metrics()->snapshot().perType[NodeMetrics::slotOf(int(MsgType::InvokeReply))].messagesIn == 1);
+    }
+    SECTION("replies choosing what was not offered are restricted to the offer") {
+        // unsolicited
+        remote->handleMessage(R"([2,{"format":"cbor","features":["zstd:1234","compact"]}])");
+        REQUIRE(remote->codec()->format() == MessageFormat::JSON);
+        REQUIRE_FALSE(std::dynamic_pointer_cast<CompressedCodec>(remote->codec()));
+        REQUIRE(remote->negotiatedFeatures().empty());
+        NodeCapabilities native;
+        native.formats = { MessageFormat::MSGPACK, MessageFormat::JSON };
+        native.features = { "chunks" };
+        client->setCapabilities(native);
+        client->startHandshake();
+        toRemote.clear();
+        client->handleMessage(R"([2,{"format":"cbor","features":["compact","chunks","zstd:1234"]}])");
+        REQUIRE_FALSE(client->isHandshakePending());
+        REQUIRE(client->codec()->format() == MessageFormat::JSON);
+        REQUIRE_FALSE(std::dynamic_pointer_cast<CompressedCodec>(client->codec()));
+        REQUIRE(client->negotiatedFeatures() == std::vector<std::string>{ "chunks" });
+        client->linkRemote("demo.Store");
+        deliver();
+        REQUIRE(sink->initProps["count"] == 3);
+    }
+    SECTION("messages written from other threads during the handshake use the chosen format") {
+        std::mutex toRemoteMutex;
+        client->onWrite([&toRemote, &toRemoteMutex](const std::string& msg) {
+            std::lock_guard<std::mutex> lock(toRemoteMutex);
+            toRemote.push_back(msg);
+        });
+        NodeCapabilities native;
+        native.formats = { MessageFormat::MSGPACK };
+        client->setCapabilities(native);
+        client->startHandshake();
+        remote->handleMessage(toRemote[0]);
+        toRemote.clear();
+        std::vector<std::thread> writers;
+        for (int i = 0; i < 4; ++i) {
+            writers.emplace_back([&client]() {
+                for (int j = 0; j < 50; ++j) {
+                    client->emitWrite(Protocol::setPropertyMessage("demo.Store/count", j));
+                }
+            });
+        }
+        client->handleMessage(toClient[0]);
+        toClient.clear();
+        for (auto& writer : writers) {
+            writer.join();
+        }
+        REQUIRE(toRemote.size() == 200);
+        for (const auto& frame : toRemote) {
+            REQUIRE(nlohmann::json::from_msgpack(frame, true, false)[0] == int(MsgType::SetProperty));
+        }
+    }
+    SECTION("a cancelled handshake sends the held messages in the current format") {
+        client->startHandshake();
+        client->linkRemote("demo.Store");
+        REQUIRE(toRemote.size() == 1);
+        toRemote.clear();
+        client->cancelHandshake();
+        REQUIRE_FALSE(client->isHandshakePending());
+        REQUIRE(toRemote.size() == 1);
+        REQUIRE(nlohmann::json::parse(toRemote[0]) == Protocol::linkMessage("demo.Store"));
+        deliver();
+        REQUIRE(sink->initProps["name"] == "store");
+    }
+}
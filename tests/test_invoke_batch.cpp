@@ -0,0 +1,217 @@
+#include <catch2/catch.hpp>
+
+#include "olink/core/handshake.h"
+#include "olink/core/protocol.h"
+#include "olink/core/types.h"
+#include "olink/clientnode.h"
+#include "olink/clientregistry.h"
+#include "olink/iobjectsource.h"
+#include "olink/remotenode.h"
+#include "olink/remoteregistry.h"
+
+#include "nlohmann/json.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace ApiGear::ObjectLink;
+
+namespace {
+
+/** Returns the method name and the arguments of each call. */
+class EchoSource : public IObjectSource
+{
+public:
+    explicit EchoSource(std::string name)
+        : m_name(std::move(name))
+    {
+    }
+    std::string olinkObjectName() override
+    {
+        return m_name;
+    }
+    nlohmann::json olinkInvoke(const std::string& methodId, const nlohmann::json& args) override
+    {
+        return { Name::getMemberName(methodId), args };
+    }
+    void olinkSetProperty(const std::string&, const nlohmann::json&) override {}
+    void olinkLinked(const std::string&, IRemoteNode*) override {}
+    void olinkUnlinked(const std::string&) override {}
+    nlohmann::json olinkCollectProperties() override
+    {
+        return nlohmann::json::object();
+    }
+private:
+    std::string m_name;
+};
+
+/** Counts the invoke messages passed to the handlers. */
+class InvokeListener : public IProtocolListener
+{
+public:
+    void handleLink(const std::string&) override {}
+    void handleUnlink(const std::string&) override {}
+    void handleInit(const std::string&, const nlohmann::json&) override {}
+    void handleSetProperty(const std::string&, const nlohmann::json&) override {}
+    void handlePropertyChange(const std::string&, const nlohmann::json&) override {}
+    void handleInvoke(int requestId, const std::string& methodId, const nlohmann::json& args) override
+    {
+        invokes.push_back(Protocol::invokeMessage(requestId, methodId, args));
+    }
+    void handleInvokeReply(int requestId, const std::string& methodId, const nlohmann::json& value) override
+    {
+        replies.push_back(Protocol::invokeReplyMessage(requestId, methodId, value));
+    }
+    void handleSignal(const std::string&, const nlohmann::json&) override {}
+    void handleError(int, int, const std::string&) override {}
+
+    std::vector<nlohmann::json> invokes;
+    std::vector<nlohmann::json> replies;
+};
+
+std::vector<InvokeRequest> makeCalls(std::vector<nlohmann::json>& results)
+{
+    std::vector<InvokeRequest> calls;
+    for (int i = 0; i < 20; ++i) {
+        InvokeRequest call;
+        call.methodId = i % 2 ? "demo.Lamp/dim" : "demo.Fan/speed";
+        call.args = { i };
+        call.func = [&results](InvokeReplyArg arg) { results.push_back({ arg.methodId, arg.value }); };
+        calls.push_back(std::move(call));
+    }
+    return calls;
+}
+
+} // namespace
+
+TEST_CASE("invoke batch")
+{
+    RemoteRegistry remoteRegistry;
+    ClientRegistry clientRegistry;
+    auto lamp = std::make_shared<EchoSource>("demo.Lamp");
+    auto fan = std::make_shared<EchoSource>("demo.Fan");
+    remoteRegistry.addSource(lamp);
+    remoteRegistry.addSource(fan);
+    std::vector<std::string> toRemote;
+    std::vector<std::string> toClient;
+    auto remote = RemoteNode::createRemoteNode(remoteRegistry);
+    auto client = ClientNode::create(clientRegistry);
+    client->onWrite([&toRemote](const std::string& msg) { toRemote.push_back(msg); });
+    remote->onWrite([&toClient](const std::string& msg) { toClient.push_back(msg); });
+    const auto deliver = [&]() {
+        while (!toRemote.empty() || !toClient.empty()) {
+            auto frames = std::move(toRemote);
+            toRemote.clear();
+            for (const auto& frame : frames) {
+                remote->handleMessage(frame);
+            }
+            frames = std::move(toClient);
+            toClient.clear();
+            for (const auto& frame : frames) {
+                client->handleMessage(frame);
+            }
+        }
+    };
+    const auto negotiate = [&](std::vector<std::string> features) {
+        NodeCapabilities capabilities;
+        capabilities.features = std::move(features);
+        remote->setCapabilities(capabilities);
+        client->setCapabilities(capabilities);
+        client->startHandshake();
+        deliver();
+    };
+    std::vector<nlohmann::json> results;
+    const auto requireResults = [&results]() {
+        REQUIRE(results.size() == 20);
+        for (int i = 0; i < 20; ++i) {
+            REQUIRE(results[i][0] == (i % 2 ? "demo.Lamp/dim" : "demo.Fan/speed"));
+            REQUIRE(results[i][1] == nlohmann::json({ i % 2 ? "dim" : "speed", { i } }));
+        }
+    };
+
+    SECTION("calls are sent in one frame and answered in one frame") {
+        negotiate({ "batching" });
+        client->invokeRemoteBatch(makeCalls(results));
+        REQUIRE(toRemote.size() == 1);
+        REQUIRE(client->metrics()->snapshot().pendingInvokes == 20);
+        const auto msg = nlohmann::json::parse(toRemote[0]);
+        REQUIRE(msg[0] == int(MsgType::InvokeBatch));
+        REQUIRE(msg[1].size() == 20);
+        remote->handleMessage(toRemote[0]);
+        toRemote.clear();
+        REQUIRE(toClient.size() == 1);
+        REQUIRE(nlohmann::json::parse(toClient[0])[0] == int(MsgType::InvokeBatchReply));
+        deliver();
+        requireResults();
+        REQUIRE(client->metrics()->snapshot().pendingInvokes == 0);
+        REQUIRE(client->metrics()->snapshot().invokeRoundTrip.count == 20);
+        REQUIRE(remote->metrics()->snapshot().forType(int(MsgType::InvokeBatch)).messagesIn == 1);
+    }
+    SECTION("compact batches omit the method ids of the replies") {
+        negotiate({ "batching", "compact" });
+        client->invokeRemoteBatch(makeCalls(results));
+        REQUIRE(nlohmann::json::parse(toRemote[0])[0] == int(MsgType::CompactInvokeBatch));
+        remote->handleMessage(toRemote[0]);
+        toRemote.clear();
+        const auto reply = nlohmann::json::parse(toClient[0]);
+        REQUIRE(reply[0] == int(MsgType::CompactInvokeBatchReply));
+        REQUIRE(reply[1][0].size() == 2);
+        deliver();
+        requireResults();
+    }
+    SECTION("without the batching feature the calls are sent one by one") {
+        client->invokeRemoteBatch(makeCalls(results));
+        REQUIRE(toRemote.size() == 20);
+        REQUIRE(nlohmann::json::parse(toRemote[0])[0] == int(MsgType::Invoke));
+        deliver();
+        requireResults();
+    }
+    SECTION("calls of unknown objects and one-way calls get no reply") {
+        negotiate({ "batching" });
+        std::vector<InvokeRequest> calls(2);
+        calls[0].methodId = "demo.Door/open";
+        calls[1].methodId = "demo.Lamp/off";
+        client->invokeRemoteBatch(std::move(calls));
+        remote->handleMessage(toRemote[0]);
+        REQUIRE(toClient.size() == 1);
+        const auto reply = nlohmann::json::parse(toClient[0]);
+        REQUIRE(reply[1].size() == 1);
+        REQUIRE(reply[1][0][1] == "demo.Lamp/off");
+        toClient.clear();
+        remote->handleMessage(Protocol::invokeBatchMessage({ { Protocol::oneWayRequestId, "demo.Lamp/off", nlohmann::json::array() } }).dump());
+        REQUIRE(toClient.empty());
+    }
+}
+
+TEST_CASE("invoke batch protocol")
+{
+    Protocol protocol;
+    InvokeListener listener;
+
+    SECTION("listeners without batch handler get the calls one by one") {
+        REQUIRE(protocol.handleMessage(Protocol::invokeBatchMessage({ { 1, "demo.Lamp/dim", { 5 } }, { 2, "demo.Fan/stop", nlohmann::json::array() } }), listener));
+        REQUIRE(listener.invokes.size() == 2);
+        REQUIRE(listener.invokes[1] == Protocol::invokeMessage(2, "demo.Fan/stop", nlohmann::json::array()));
+        auto compact = Protocol::compactMessage(Protocol::invokeBatchMessage({ { 3, "demo.Fan/stop", nlohmann::json::array() } }));
+        REQUIRE(compact[1][0].size() == 2);
+        REQUIRE(protocol.handleMessage(std::move(compact), listener));
+        REQUIRE(listener.invokes[2] == Protocol::invokeMessage(3, "demo.Fan/stop", nlohmann::json::array()));
+    }
+    SECTION("batch replies are passed one by one") {
+        REQUIRE(protocol.handleMessage(Protocol::invokeBatchReplyMessage({ { 1, "demo.Lamp/dim", 5 }, { 2, "demo.Fan/stop", nullptr } }), listener));
+        REQUIRE(listener.replies.size() == 2);
+        REQUIRE(listener.replies[0] == Protocol::invokeReplyMessage(1, "demo.Lamp/dim", 5));
+        auto compact = Protocol::compactMessage(Protocol::invokeBatchReplyMessage({ { 3, "demo.Fan/stop", nullptr } }));
+        REQUIRE(compact == nlohmann::json::array({ MsgType::CompactInvokeBatchReply, { { 3 } } }));
+        REQUIRE(protocol.handleMessage(std::move(compact), listener));
+        REQUIRE(listener.replies[2] == Protocol::invokeReplyMessage(3, "", nullptr));
+    }
+    SECTION("malformed batches are rejected") {
+        REQUIRE_FALSE(protocol.handleMessage(nlohmann::json::array({ MsgType::InvokeBatch, { { 1, "demo.Lamp/dim" } } }), listener));
+        REQUIRE_FALSE(protocol.handleMessage(nlohmann::json::array({ MsgType::InvokeBatch, { { "1", "demo.Lamp/dim", 1 } } }), listener));
+        REQUIRE_FALSE(protocol.handleMessage(nlohmann::json::array({ MsgType::CompactInvokeBatchReply, { 1 } }), listener));
+        REQUIRE_FALSE(protocol.handleMessage(nlohmann::json::array({ MsgType::InvokeBatchReply, "replies" }), listener));
+        REQUIRE(listener.invokes.empty());
+        REQUIRE(listener.replies.empty());
+    }
+}
@@ -0,0 +1,106 @@
+#include <catch2/catch.hpp>
+
+#include "olink/core/membertraffic.h"
+#include "olink/clientnode.h"
+#include "olink/clientregistry.h"
+#include "olink/remotenode.h"
+#include "olink/remoteregistry.h"
+
+#include "sinkobject.hpp"
+#include "sourceobject.hpp"
+
+#include <memory>
+#include <string>
+
+using namespace ApiGear::ObjectLink;
+
+TEST_CASE("member traffic accounting")
+{
+    SECTION("counts exactly while members fit") {
+        MemberTraffic traffic(4);
+        traffic.record("demo.Calc/total", 10);
+        traffic.record("demo.Calc/total", 10);
+        traffic.record("demo.Calc/add", 100);
+        auto byMessages = traffic.topByMessages(10);
+        REQUIRE(byMessages.size() == 2);
+        REQUIRE(byMessages[0].memberId == "demo.Calc/total");
+        REQUIRE(byMessages[0].count == 2);
+        REQUIRE(byMessages[0].error == 0);
+        auto byBytes = traffic.topByBytes(1);
+        REQUIRE(byBytes.size() == 1);
+        REQUIRE(byBytes[0].memberId == "demo.Calc/add");
+        REQUIRE(byBytes[0].count == 100);
+    }
+    SECTION("keeps heavy hitters in bounded memory") {
+        MemberTraffic traffic(8);
+        // the hot member has more than 1/8 of messages and of bytes
+        for (int round = 0; round < 100; ++round) {
+            traffic.record("demo.Hot/value", 1000);
+            traffic.record("demo.Hot/value", 1000);
+            traffic.record("demo.Hot/value", 1000);
+            for (int cold = 0; cold < 10; ++cold) {
+                traffic.record("demo.Cold/value" + std::to_string(round * 10 + cold), 10);
+            }
+        }
+        REQUIRE(traffic.topByMessages(100).size() == 8);
+        auto byBytes = traffic.topByBytes(1);
+        REQUIRE(byBytes[0].memberId == "demo.Hot/value");
+        REQUIRE(byBytes[0].count - byBytes[0].error <= 300000);
+        REQUIRE(byBytes[0].count >= 300000);
+        auto byMessages = traffic.topByMessages(1);
+        REQUIRE(byMessages[0].memberId == "demo.Hot/value");
+        REQUIRE(byMessages[0].count >= 300);
+        traffic.reset();
+        REQUIRE(traffic.topByBytes(10).empty());
+    }
+}
+
+TEST_CASE("member traffic of nodes")
+{
+    RemoteRegistry registry;
+    ClientRegistry clientRegistry;
+    auto remote = RemoteNode::createRemoteNode(registry);
+    auto source = std::make_shared<CalcSource>(registry);
+    registry.addSource(source);
+    auto client = ClientNode::create(clientRegistry);
+    auto sink = std::make_shared<CalcSink>(clientRegistry);
+    clientRegistry.addSink(sink);
+    std::size_t remoteBytesOut = 0;
+    client->onWrite([&remote](const std::string& msg) { remote->handleMessage(msg); });
+    remote->onWrite([&client, &remoteBytesOut](const std::string& msg) {
+        remoteBytesOut += msg.size();
+        client->handleMessage(msg);
+    });
+
+    auto serverTraffic = std::make_shared<MemberTraffic>();
+    auto clientTraffic = std::make_shared<MemberTraffic>();
+    remote->setMemberTraffic(serverTraffic);
+    client->setMemberTraffic(clientTraffic);
+    client->linkRemote("demo.Calc");
+    REQUIRE(serverTraffic->topByMessages(10).empty());
+    const auto initBytes = remoteBytesOut;
+
+    sink->setTotal(2);
+    remote->notifySignal("demo.Calc/shutdown", { 1 });
+    client->invokeRemote("demo.Calc/add", { 1 });
+
+    auto serverMembers = serverTraffic->topByMessages(10);
+    REQUIRE(serverMembers.size() == 2);
+    REQUIRE(serverMembers[0].memberId == "demo.Calc/total");
+    REQUIRE(serverMembers[0].count == 2);
+    REQUIRE(serverMembers[1].memberId == "demo.Calc/shutdown");
+    std::uint64_t serverBytes = 0;
+    for (const auto& member : serverTraffic->topByBytes(10)) {
+        serverBytes += member.count;
+    }
+    // the invoke reply is not accounted
+    REQUIRE(serverBytes < remoteBytesOut - initBytes);
+
+    auto clientMembers = clientTraffic->topByMessages(10);
+    REQUIRE(clientMembers.size() == 2);
+    REQUIRE(clientTraffic->topByMessages(1)[0].count == 1);
+
+    client->unlinkRemote("demo.Calc");
+    registry.removeSource(source->olinkObjectName());
+    clientRegistry.removeSink(sink->olinkObjectName());
+}
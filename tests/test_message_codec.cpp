@@ -0,0 +1,120 @@
+#include <catch2/catch.hpp>
+
+#include "olink/core/messagecodec.h"
+#include "olink/core/protocol.h"
+#include "olink/core/types.h"
+#include "olink/clientnode.h"
+#include "olink/clientregistry.h"
+#include "olink/remotenode.h"
+#include "olink/remoteregistry.h"
+
+#include "sinkobject.hpp"
+#include "sourceobject.hpp"
+
+#include "nlohmann/json.hpp"
+#include <memory>
+#include <string>
+
+using namespace ApiGear::ObjectLink;
+
+namespace {
+
+/** A codec of its own: JSON text behind a marker byte, counting its calls. */
+class MarkedJsonCodec : public IMessageCodec
+{
+public:
+    MessageFormat format() const override
+    {
+        return MessageFormat::JSON;
+    }
+    void decode(const char* data, std::size_t size, nlohmann::json& msg, bool allowExceptions) override
+    {
+        ++decoded;
+        if (size == 0 || data[0] != '#') {
+            msg = nlohmann::json(nlohmann::json::value_t::discarded);
+            return;
+        }
+        msg = nlohmann::json::parse(data + 1, data + size, nullptr, allowExceptions);
+    }
+    void encode(const nlohmann::json& msg, std::string& data) override
+    {
+        ++encoded;
+        data = "#" + msg.dump();
+    }
+    int decoded = 0;
+    int encoded = 0;
+};
+
+} // namespace
+
+TEST_CASE("message codecs")
+{
+    const auto message = Protocol::invokeMessage(7, "demo.Calc/add", nlohmann::json::array({ 1, "two", 3.5, nullptr }));
+
+    SECTION("built in codecs translate messages both ways") {
+        for (auto format : { MessageFormat::JSON, MessageFormat::MSGPACK, MessageFormat::CBOR }) {
+            auto codec = IMessageCodec::create(format);
+            REQUIRE(codec);
+            REQUIRE(codec->format() == format);
+            REQUIRE(IMessageCodec::create(format) == codec);
+            std::string data = "previous content";
+            codec->encode(message, data);
+            nlohmann::json decoded;
+            codec->decode(data.data(), data.size(), decoded, false);
+            REQUIRE(decoded == message);
+            // the same as the converter
+            MessageConverter converter(format);
+            REQUIRE(converter.toString(message) == data);
+            REQUIRE(converter.fromString(data) == message);
+        }
+        REQUIRE_FALSE(IMessageCodec::create(static_cast<MessageFormat>(42)));
+    }
+    SECTION("malformed data is reported by a discarded message or by an exception") {
+        for (auto format : { MessageFormat::JSON, MessageFormat::MSGPACK, MessageFormat::CBOR }) {
+            auto codec = IMessageCodec::create(format);
+            const std::string data = "\xff\xff[";
+            nlohmann::json decoded;
+            codec->decode(data.data(), data.size(), decoded, false);
+            REQUIRE(decoded.is_discarded());
+            REQUIRE_THROWS_AS(codec->decode(data.data(), data.size(), decoded, true), nlohmann::json::exception);
+        }
+    }
+    SECTION("converter can use a codec of its own") {
+        auto codec = std::make_shared<MarkedJsonCodec>();
+        MessageConverter converter(codec);
+        REQUIRE(converter.codec() == codec);
+        REQUIRE(converter.toString(message)[0] == '#');
+        REQUIRE(converter.fromString(converter.toString(message)) == message);
+        converter.setMessageFormat(MessageFormat::CBOR);
+        REQUIRE(converter.codec() == IMessageCodec::create(MessageFormat::CBOR));
+        REQUIRE(converter.messageFormat() == MessageFormat::CBOR);
+    }
+    SECTION("nodes translate messages with the codec they are given") {
+        RemoteRegistry registry;
+        ClientRegistry clientRegistry;
+        auto remote = RemoteNode::createRemoteNode(registry);
+        auto source = std::make_shared<CalcSource>(registry);
+        registry.addSource(source);
+        auto client = ClientNode::create(clientRegistry);
+        auto sink = std::make_shared<CalcSink>(clientRegistry);
+        clientRegistry.addSink(sink);
+        std::string lastWritten;
+        client->onWrite([&remote, &lastWritten](const std::string& msg) { lastWritten = msg; remote->handleMessage(msg); });
+        remote->onWrite([&client](const std::string& msg) { client->handleMessage(msg); });
+
+        auto codec = std::make_shared<MarkedJsonCodec>();
+        client->setCodec(codec);
+        remote->setCodec(codec);
+        REQUIRE(client->codec() == codec);
+        client->linkRemote("demo.Calc");
+        sink->setTotal(5);
+        REQUIRE(lastWritten == "#[20,\"demo.Calc/total\",5]");
+        REQUIRE(sink->total() == 5);
+        // link, init, set property, property change
+        REQUIRE(codec->encoded == 4);
+        REQUIRE(codec->decoded == 4);
+
+        client->setMessageFormat(MessageFormat::JSON);
+        REQUIRE(client->codec() == IMessageCodec::create(MessageFormat::JSON));
+    }
+}
@@ -0,0 +1,115 @@
+#include <catch2/catch.hpp>
+
+#include "olink/metricshttp/metricscollection.h"
+#include "olink/metricshttp/metricshttpserver.h"
+#include "olink/core/nodemetrics.h"
+#include "olink/core/objectmetrics.h"
+#include "olink/clientnode.h"
+#include "olink/clientregistry.h"
+#include "olink/remotenode.h"
+#include "olink/remoteregistry.h"
+
+#include "sinkobject.hpp"
+#include "sourceobject.hpp"
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace ApiGear::ObjectLink;
+
+namespace {
+
+std::string httpGet(std::uint16_t port, const std::string& path)
+{
+    const int connection = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(connection, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        ::close(connection);
+        return std::string();
+    }
+    const std::string request = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    ::send(connection, request.data(), request.size(), 0);
+    std::string response;
+    char buffer[4096];
+    ssize_t received = 0;
+    while ((received = ::recv(connection, buffer, sizeof(buffer), 0)) > 0) {
+        response.append(buffer, static_cast<std::size_t>(received));
+    }
+    ::close(connection);
+    return response;
+}
+
+} // namespace
+
+TEST_CASE("prometheus metrics")
+{
+    RemoteRegistry registry;
+    ClientRegistry clientRegistry;
+    auto remote = RemoteNode::createRemoteNode(registry);
+    auto source = std::make_shared<CalcSource>(registry);
+    registry.addSource(source);
+    auto client = ClientNode::create(clientRegistry);
+    auto sink = std::make_shared<CalcSink>(clientRegistry);
+    clientRegistry.addSink(sink);
+    client->onWrite([&remote](const std::string& msg) { remote->handleMessage(msg); });
+    remote->onWrite([&client](const std::string& msg) { client->handleMessage(msg); });
+
+    auto objectMetrics = std::make_shared<ObjectMetrics>();
+    client->setObjectMetrics(objectMetrics);
+
+    MetricsCollection metrics;
+    metrics.addRegistry("server", registry);
+    metrics.addRegistry("client", clientRegistry);
+    metrics.addNodeMetrics("client \"1\"", client->metrics());
+    metrics.addObjectMetrics("client", objectMetrics);
+    auto memberTraffic = std::make_shared<MemberTraffic>();
+    client->setMemberTraffic(memberTraffic);
+    metrics.addMemberTraffic("client", memberTraffic);
+
+    client->linkRemote("demo.Calc");
+    client->invokeRemote("demo.Calc/add", { 1 }, [](InvokeReplyArg) {});
+
+    SECTION("renders registries, nodes and objects") {
+        const auto text = metrics.renderPrometheus();
+        REQUIRE(text.find("# TYPE olink_registry_objects gauge\n") != std::string::npos);
+        REQUIRE(text.find("olink_registry_objects{registry=\"server\"} 1\n") != std::string::npos);
+        REQUIRE(text.find("olink_registry_links{registry=\"server\"} 1\n") != std::string::npos);
+        REQUIRE(text.find("olink_registry_nodes{registry=\"client\"} 1\n") != std::string::npos);
+        REQUIRE(text.find("olink_node_messages_total{node=\"client \\\"1\\\"\",direction=\"out\",type=\"invoke\"} 1\n") != std::string::npos);
+        REQUIRE(text.find("olink_node_invoke_seconds_count{node=\"client \\\"1\\\"\"} 1\n") != std::string::npos);
+        REQUIRE(text.find("olink_node_invoke_seconds_bucket{node=\"client \\\"1\\\"\",le=\"+Inf\"} 1\n") != std::string::npos);
+        REQUIRE(text.find("olink_object_messages_total{registry=\"client\",object=\"demo.Calc\",direction=\"in\"} 3\n") != std::string::npos);
+        REQUIRE(text.find("olink_object_invoke_seconds_count{registry=\"client\",object=\"demo.Calc\"} 1\n") != std::string::npos);
+        REQUIRE(text.find("olink_member_messages{registry=\"client\",member=\"demo.Calc/add\"} 1\n") != std::string::npos);
+        REQUIRE(text.find("# TYPE olink_member_bytes gauge\n") != std::string::npos);
+    }
+    SECTION("skips metrics of destroyed nodes") {
+        metrics.addNodeMetrics("gone", std::make_shared<NodeMetrics>());
+        REQUIRE(metrics.renderPrometheus().find("node=\"gone\"") == std::string::npos);
+    }
+    SECTION("serves metrics over http") {
+        MetricsHttpServer server(metrics);
+        REQUIRE(server.start(0));
+        REQUIRE(server.port() != 0);
+        const auto response = httpGet(server.port(), "/metrics");
+        REQUIRE(response.compare(0, 15, "HTTP/1.1 200 OK") == 0);
+        REQUIRE(response.find("olink_registry_objects{registry=\"server\"} 1\n") != std::string::npos);
+        REQUIRE(httpGet(server.port(), "/other").compare(0, 22, "HTTP/1.1 404 Not Found") == 0);
+        server.stop();
+        REQUIRE(server.port() == 0);
+    }
+
+    metrics.removeRegistry("server");
+    metrics.removeRegistry("client");
+    client->unlinkRemote("demo.Calc");
+    registry.removeSource(source->olinkObjectName());
+    clientRegistry.removeSink(sink->olinkObjectName());
+}
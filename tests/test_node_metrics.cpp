@@ -0,0 +1,201 @@
+#include <catch2/catch.hpp>
+
+#include "olink/core/nodemetrics.h"
+#include "olink/core/protocol.h"
+#include "olink/core/types.h"
+#include "olink/clientnode.h"
+#include "olink/clientregistry.h"
+#include "olink/remotenode.h"
+#include "olink/remoteregistry.h"
+
+#include "sinkobject.hpp"
+#include "sourceobject.hpp"
+
+#include "nlohmann/json.hpp"
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace ApiGear::ObjectLink;
+
+TEST_CASE("latency histogram")
+{
+    LatencyHistogram histogram;
+
+    SECTION("buckets double their upper bound") {
+        REQUIRE(LatencyHistogram::bucketIndex(0) == 0);
+        REQUIRE(LatencyHistogram::bucketIndex(1023) == 0);
+        REQUIRE(LatencyHistogram::bucketIndex(1024) == 1);
+        REQUIRE(LatencyHistogram::bucketIndex(2047) == 1);
+        REQUIRE(LatencyHistogram::bucketIndex(2048) == 2);
+        REQUIRE(LatencyHistogram::bucketIndex(UINT64_MAX) == LatencyHistogram::bucketCount - 1);
+        REQUIRE(LatencyHistogram::bucketUpperBound(0) == 1024);
+        REQUIRE(LatencyHistogram::bucketUpperBound(1) == 2048);
+        REQUIRE(LatencyHistogram::bucketUpperBound(LatencyHistogram::bucketCount - 1) == 0);
+    }
+    SECTION("records count, sum and buckets") {
+        histogram.record(std::chrono::nanoseconds(100));
+        histogram.record(std::chrono::microseconds(3));
+        histogram.record(std::chrono::nanoseconds(-5));
+        auto snapshot = histogram.snapshot();
+        REQUIRE(snapshot.count == 3);
+        REQUIRE(snapshot.sum == 3100);
+        REQUIRE(snapshot.buckets[0] == 2);
+        REQUIRE(snapshot.buckets[2] == 1);
+        histogram.reset();
+        REQUIRE(histogram.snapshot().count == 0);
+    }
+}
+
+TEST_CASE("node metrics")
+{
+    RemoteRegistry registry;
+    ClientRegistry clientRegistry;
+    auto remote = RemoteNode::createRemoteNode(registry);
+    auto source = std::make_shared<CalcSource>(registry);
+    registry.addSource(source);
+    auto client = ClientNode::create(clientRegistry);
+    auto sink = std::make_shared<CalcSink>(clientRegistry);
+    clientRegistry.addSink(sink);
+
+    std::size_t clientBytesOut = 0;
+    std::size_t remoteBytesOut = 0;
+    client->onWrite([&remote, &clientBytesOut](const std::string& msg) {
+        clientBytesOut += msg.size();
+        remote->handleMessage(msg);
+    });
+    remote->onWrite([&client, &remoteBytesOut](const std::string& msg) {
+        remoteBytesOut += msg.size();
+        client->handleMessage(msg);
+    });
+
+    REQUIRE(client->metrics());
+    REQUIRE(remote->metrics());
+    client->linkRemote("demo.Calc");
+
+    SECTION("counts messages and bytes per type and direction") {
+        sink->setTotal(5);
+        auto clientMetrics = client->metrics()->snapshot();
+        auto remoteMetrics = remote->metrics()->snapshot();
+
+        REQUIRE(clientMetrics.forType(int(MsgType::Link)).messagesOut == 1);
+        REQUIRE(clientMetrics.forType(int(MsgType::Init)).messagesIn == 1);
+        REQUIRE(clientMetrics.forType(int(MsgType::SetProperty)).messagesOut == 1);
+        REQUIRE(clientMetrics.forType(int(MsgType::PropertyChange)).messagesIn == 1);
+        REQUIRE(remoteMetrics.forType(int(MsgType::Link)).messagesIn == 1);
+        REQUIRE(remoteMetrics.forType(int(MsgType::Init)).messagesOut == 1);
+        REQUIRE(remoteMetrics.forType(int(MsgType::SetProperty)).messagesIn == 1);
+        REQUIRE(remoteMetrics.forType(int(MsgType::PropertyChange)).messagesOut == 1);
+
+        REQUIRE(clientMetrics.total().messagesOut == 2);
+        REQUIRE(clientMetrics.total().bytesOut == clientBytesOut);
+        REQUIRE(clientMetrics.total().bytesIn == remoteBytesOut);
+        REQUIRE(remoteMetrics.total().bytesIn == clientBytesOut);
+        REQUIRE(remoteMetrics.total().bytesOut == remoteBytesOut);
+        REQUIRE(clientMetrics.encodeTime.count == 2);
+        REQUIRE(clientMetrics.decodeTime.count == 2);
+    }
+    SECTION("measures invoke round trip") {
+        bool replied = false;
+        client->invokeRemote("demo.Calc/add", { 1 }, [&replied](InvokeReplyArg) { replied = true; });
+        REQUIRE(replied);
+        auto clientMetrics = client->metrics()->snapshot();
+        REQUIRE(clientMetrics.invokeRoundTrip.count == 1);
+        REQUIRE(clientMetrics.pendingInvokes == 0);
+        REQUIRE(remote->metrics()->snapshot().forType(int(MsgType::InvokeReply)).messagesOut == 1);
+    }
+    SECTION("counts pending invokes") {
+        remote->onWrite(nullptr);
+        client->invokeRemote("demo.Calc/add", { 1 });
+        client->invokeRemote("demo.Calc/add", { 2 });
+        REQUIRE(client->metrics()->snapshot().pendingInvokes == 2);
+        REQUIRE(client->metrics()->snapshot().invokeRoundTrip.count == 0);
+    }
+    SECTION("counts messages which can not be decoded") {
+        client->handleMessage(std::string("[21,"));
+        auto clientMetrics = client->metrics()->snapshot();
+        REQUIRE(clientMetrics.decodeErrors == 1);
+        REQUIRE(clientMetrics.forType(-1).messagesIn == 1);
+    }
+    SECTION("can be shared and disabled") {
+        auto shared = std::make_shared<NodeMetrics>();
+        client->setMetrics(shared);
+        remote->setMetrics(shared);
+        sink->setTotal(7);
+        REQUIRE(shared->snapshot().total().messagesOut == 2);
+        REQUIRE(shared->snapshot().total().messagesIn == 2);
+
+        client->setMetrics(nullptr);
+        remote->setMetrics(nullptr);
+        sink->setTotal(8);
+        REQUIRE(sink->total() == 8);
+        REQUIRE(shared->snapshot().total().messagesOut == 2);
+    }
+    SECTION("registry sizes") {
+        REQUIRE(registry.objectCount() == 1);
+        REQUIRE(registry.nodeCount() == 1);
+        REQUIRE(registry.linkCount() == 1);
+        REQUIRE(clientRegistry.objectCount() == 1);
+        REQUIRE(clientRegistry.nodeCount() == 1);
+    }
+
+    client->unlinkRemote("demo.Calc");
+    REQUIRE(registry.linkCount() == 0);
+    registry.removeSource(source->olinkObjectName());
+    clientRegistry.removeSink(sink->olinkObjectName());
+    REQUIRE(registry.objectCount() == 0);
+    REQUIRE(clientRegistry.objectCount() == 0);
+}
+
+TEST_CASE("slow handlers")
+{
+    RemoteRegistry registry;
+    ClientRegistry clientRegistry;
+    auto remote = RemoteNode::createRemoteNode(registry);
+    auto source = std::make_shared<CalcSource>(registry);
+    registry.addSource(source);
+    auto client = ClientNode::create(clientRegistry);
+    auto sink = std::make_shared<CalcSink>(clientRegistry);
+    clientRegistry.addSink(sink);
+    client->onWrite([&remote](const std::string& msg) { remote->handleMessage(msg); });
+    remote->onWrite([&client](const std::string& msg) { client->handleMessage(msg); });
+
+    std::vector<std::string> warnings;
+    auto logFunc = [&warnings](LogLevel level, const std::string& msg) {
+        if (level == LogLevel::Warning) {
+            warnings.push_back(msg);
+        }
+    };
+    client->onLog(logFunc);
+    remote->onLog(logFunc);
+    REQUIRE(client->slowHandlerThreshold() == std::chrono::milliseconds(50));
+    client->linkRemote("demo.Calc");
+
+    SECTION("handlers are timed") {
+        sink->setTotal(3);
+        REQUIRE(client->metrics()->snapshot().handlerTime.count == 2);
+        REQUIRE(remote->metrics()->snapshot().handlerTime.count == 3);
+    }
+    SECTION("handlers over the threshold are reported with the member id") {
+        client->setSlowHandlerThreshold(std::chrono::nanoseconds(1));
+        remote->setSlowHandlerThreshold(std::chrono::nanoseconds(1));
+        sink->setTotal(3);
+        REQUIRE(client->metrics()->snapshot().slowHandlers == 1);
+        REQUIRE(remote->metrics()->snapshot().slowHandlers == 1);
+        REQUIRE(warnings.size() == 2);
+        // the property change is delivered while the source handler is running, so it is finished first
+        REQUIRE(warnings[0].find("slow handler: handler=olinkOnPropertyChanged member=demo.Calc/total duration_us=") == 0);
+        REQUIRE(warnings[1].find("slow handler: handler=olinkSetProperty member=demo.Calc/total duration_us=") == 0);
+    }
+    SECTION("zero threshold disables reporting") {
+        client->setSlowHandlerThreshold(std::chrono::nanoseconds(0));
+        client->setMetrics(nullptr);
+        sink->setTotal(3);
+        REQUIRE(warnings.empty());
+    }
+
+    client->unlinkRemote("demo.Calc");
+    registry.removeSource(source->olinkObjectName());
+    clientRegistry.removeSink(sink->olinkObjectName());
+}
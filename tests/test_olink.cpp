@@ -192,3 +192,93 @@ TEST_CASE("invoke")
     registry.removeSource(source->olinkObjectName());
     clientRegistry.removeSink(sink->olinkObjectName());
 }
+
+TEST_CASE("malformed messages")
+{
+    ConsoleLogger log;
+    // setup service
+    RemoteRegistry registry;
+    auto remote = RemoteNode::createRemoteNode(registry);
+    remote->onLog(log.logFunc());
+    auto source = std::make_shared<CalcSource>(registry);
+    registry.addSource(source);
+
+    // setup client
+    ClientRegistry clientRegistry;
+    auto client = ClientNode::create(clientRegistry);
+    client->onLog(log.logFunc());
+    auto sink = std::make_shared<CalcSink>(clientRegistry);
+    clientRegistry.addSink(sink);
+
+    WriteMessageFunc clientWriteFunc = [&remote](std::string msg) {
+        remote->handleMessage(msg);
+    };
+    client->onWrite(clientWriteFunc);
+
+    WriteMessageFunc serviceWriteFunc = [&client](std::string msg) {
+        client->handleMessage(msg);
+    };
+    remote->onWrite(serviceWriteFunc);
+
+    client->linkRemote("demo.Calc");
+    REQUIRE( sink->isReady() == true );
+
+    SECTION("are dropped without exceptions and connection keeps working") {
+        REQUIRE_NOTHROW(remote->handleMessage("[10, \"demo.Calc\""));
+        REQUIRE_NOTHROW(remote->handleMessage("[30, \"1\", \"demo.Calc/add\", [1]]"));
+        REQUIRE_NOTHROW(client->handleMessage("{\"init\": 11}"));
+        REQUIRE_NOTHROW(client->handleMessage("[21, \"demo.Calc/total\"]"));
+        REQUIRE( sink->total() == 1);
+        sink->add(5);
+        REQUIRE( sink->total() == 6);
+    }
+    SECTION("with invalid UTF-8 strings are handled without exceptions") {
+        client->setMessageFormat(MessageFormat::MSGPACK);
+        MessageConverter converter(MessageFormat::MSGPACK);
+        auto message = converter.toString(Protocol::propertyChangeMessage("demo.Other/text", "valid"));
+        auto position = message.find("valid");
+        REQUIRE(position != std::string::npos);
+        message[position] = '\xff';
+        REQUIRE_NOTHROW(client->handleMessage(message));
+    }
+    registry.removeSource(source->olinkObjectName());
+    clientRegistry.removeSink(sink->olinkObjectName());
+}
+
+TEST_CASE("write buffers")
+{
+    RemoteRegistry registry;
+    auto remote1 = RemoteNode::createRemoteNode(registry);
+    auto remote2 = RemoteNode::createRemoteNode(registry);
+    std::vector<MessageBuffer> written1;
+    std::vector<MessageBuffer> written2;
+    remote1->onWriteBuffer([&written1](MessageBuffer msg) { written1.push_back(msg); });
+    remote2->onWriteBuffer([&written2](MessageBuffer msg) { written2.push_back(msg); });
+    MessageConverter converter(MessageFormat::JSON);
+
+    SECTION("buffer writer takes over translated messages") {
+        std::vector<std::string> writtenAsString;
+        remote1->onWrite([&writtenAsString](const std::string& msg) { writtenAsString.push_back(msg); });
+        remote1->notifyPropertyChange("demo.Calc/total", 5);
+        REQUIRE(writtenAsString.empty());
+        REQUIRE(written1.size() == 1);
+        REQUIRE(*written1[0] == converter.toString(Protocol::propertyChangeMessage("demo.Calc/total", 5)));
+    }
+    SECTION("one buffer is shared by many nodes") {
+        auto msg = std::make_shared<const std::string>(converter.toString(Protocol::signalMessage("demo.Calc/hit", { 1 })));
+        remote1->emitWriteBuffer(msg);
+        remote2->emitWriteBuffer(msg);
+        REQUIRE(written1.size() == 1);
+        REQUIRE(written2.size() == 1);
+        REQUIRE(written1[0].get() == msg.get());
+        REQUIRE(written2[0].get() == msg.get());
+    }
+    SECTION("buffer is given to string writer if no buffer writer is set") {
+        auto remote3 = RemoteNode::createRemoteNode(registry);
+        std::vector<std::string> writtenAsString;
+        remote3->onWrite([&writtenAsString](const std::string& msg) { writtenAsString.push_back(msg); });
+        auto msg = std::make_shared<const std::string>("[40,\"demo.Calc/hit\",[1]]");
+        remote3->emitWriteBuffer(msg);
+        REQUIRE(writtenAsString == std::vector<std::string>{ *msg });
+    }
+}
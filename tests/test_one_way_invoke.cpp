@@ -0,0 +1,90 @@
+#include <catch2/catch.hpp>
+
+#include "olink/core/protocol.h"
+#include "olink/core/types.h"
+#include "olink/clientnode.h"
+#include "olink/clientregistry.h"
+#include "olink/iobjectsource.h"
+#include "olink/remotenode.h"
+#include "olink/remoteregistry.h"
+
+#include "nlohmann/json.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace ApiGear::ObjectLink;
+
+namespace {
+
+/** Records the invoked methods. */
+class CommandSource : public IObjectSource
+{
+public:
+    std::string olinkObjectName() override
+    {
+        return "demo.Lamp";
+    }
+    nlohmann::json olinkInvoke(const std::string& methodId, const nlohmann::json& args) override
+    {
+        calls.push_back({ methodId, args });
+        return true;
+    }
+    void olinkSetProperty(const std::string&, const nlohmann::json&) override {}
+    void olinkLinked(const std::string&, IRemoteNode*) override {}
+    void olinkUnlinked(const std::string&) override {}
+    nlohmann::json olinkCollectProperties() override
+    {
+        return nlohmann::json::object();
+    }
+
+    std::vector<std::pair<std::string, nlohmann::json>> calls;
+};
+
+} // namespace
+
+TEST_CASE("one-way invoke")
+{
+    RemoteRegistry remoteRegistry;
+    ClientRegistry clientRegistry;
+    auto source = std::make_shared<CommandSource>();
+    remoteRegistry.addSource(source);
+    std::vector<std::string> toRemote;
+    std::vector<std::string> toClient;
+    std::vector<std::string> warnings;
+    auto remote = RemoteNode::createRemoteNode(remoteRegistry);
+    auto client = ClientNode::create(clientRegistry);
+    client->onWrite([&toRemote](const std::string& msg) { toRemote.push_back(msg); });
+    remote->onWrite([&toClient](const std::string& msg) { toClient.push_back(msg); });
+    client->onLog([&warnings](LogLevel level, const std::string& msg) {
+        if (level == LogLevel::Warning) {
+            warnings.push_back(msg);
+        }
+    });
+
+    SECTION("the service invokes the method without reply") {
+        client->invokeRemoteOneWay("demo.Lamp/switchOn", { 1 });
+        REQUIRE(client->metrics()->snapshot().pendingInvokes == 0);
+        REQUIRE(toRemote.size() == 1);
+        REQUIRE(nlohmann::json::parse(toRemote[0]) == Protocol::invokeMessage(Protocol::oneWayRequestId, "demo.Lamp/switchOn", { 1 }));
+        remote->handleMessage(toRemote[0]);
+        REQUIRE(source->calls.size() == 1);
+        REQUIRE(source->calls[0].first == "demo.Lamp/switchOn");
+        REQUIRE(source->calls[0].second == nlohmann::json({ 1 }));
+        REQUIRE(toClient.empty());
+    }
+    SECTION("replies of services of older versions are ignored") {
+        client->invokeRemoteOneWay("demo.Lamp/switchOn");
+        client->handleMessage(Protocol::invokeReplyMessage(Protocol::oneWayRequestId, "demo.Lamp/switchOn", true).dump());
+        REQUIRE(warnings.empty());
+        REQUIRE(client->metrics()->snapshot().invokeRoundTrip.count == 0);
+    }
+    SECTION("invokes with reply are not affected") {
+        bool replied = false;
+        client->invokeRemote("demo.Lamp/switchOn", { 1 }, [&replied](InvokeReplyArg arg) { replied = arg.value == true; });
+        remote->handleMessage(toRemote[0]);
+        REQUIRE(toClient.size() == 1);
+        client->handleMessage(toClient[0]);
+        REQUIRE(replied);
+    }
+}
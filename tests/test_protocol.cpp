@@ -76,3 +76,225 @@ TEST_CASE("protocol")
         REQUIRE(msg[3] == error);
     }
 }
+
+namespace {
+    // Listener which remembers the payload it received and whether it was handed over.
+    class PayloadListener : public IProtocolListener
+    {
+    public:
+        void handleLink(const std::string&) override {}
+        void handleUnlink(const std::string&) override {}
+        void handleInit(const std::string&, const nlohmann::json& props) override { store(props, false); }
+        void handleInit(const std::string&, nlohmann::json&& props) override { store(std::move(props), true); }
+        void handleSetProperty(const std::string&, const nlohmann::json& value) override { store(value, false); }
+        void handlePropertyChange(const std::string&, const nlohmann::json& value) override { store(value, false); }
+        void handlePropertyChange(const std::string&, nlohmann::json&& value) override { store(std::move(value), true); }
+        void handleInvoke(int, const std::string&, const nlohmann::json& args) override { store(args, false); }
+        void handleInvokeReply(int, const std::string&, const nlohmann::json& value) override { store(value, false); }
+        void handleSignal(const std::string&, const nlohmann::json& args) override { store(args, false); }
+        void handleError(int msgType, int requestId, const std::string& error) override
+        {
+            errors.push_back(json::array({ msgType, requestId, error }));
+        }
+
+        void store(json payload, bool handedOver)
+        {
+            received = std::move(payload);
+            wasHandedOver = handedOver;
+        }
+        json received;
+        bool wasHandedOver = false;
+        std::vector<json> errors;
+    };
+}
+
+TEST_CASE("protocol payload ownership")
+{
+    std::string name = "demo.Calc/total";
+    json value = { {"tiles", std::vector<int>(100, 7)} };
+    Protocol protocol;
+    PayloadListener listener;
+
+    SECTION("rvalue builders produce same message as copying ones") {
+        json copy = value;
+        REQUIRE(Protocol::propertyChangeMessage(name, std::move(copy)) == Protocol::propertyChangeMessage(name, value));
+        copy = value;
+        REQUIRE(Protocol::invokeMessage(1, name, std::move(copy)) == Protocol::invokeMessage(1, name, value));
+        copy = value;
+        REQUIRE(Protocol::initMessage(name, std::move(copy)) == Protocol::initMessage(name, value));
+    }
+    SECTION("const message keeps its payload") {
+        const json msg = Protocol::propertyChangeMessage(name, value);
+        REQUIRE(protocol.handleMessage(msg, listener));
+        REQUIRE(listener.received == value);
+        REQUIRE(listener.wasHandedOver == false);
+        REQUIRE(msg[2] == value);
+    }
+    SECTION("handed over message moves its payload to the listener") {
+        json msg = Protocol::propertyChangeMessage(name, value);
+        REQUIRE(protocol.handleMessage(std::move(msg), listener));
+        REQUIRE(listener.received == value);
+        REQUIRE(listener.wasHandedOver == true);
+    }
+    SECTION("handlers without rvalue overload get the payload by const reference") {
+        json msg = Protocol::signalMessage(name, value);
+        REQUIRE(protocol.handleMessage(std::move(msg), listener));
+        REQUIRE(listener.received == value);
+        REQUIRE(listener.wasHandedOver == false);
+    }
+}
+
+TEST_CASE("protocol malformed messages")
+{
+    Protocol protocol;
+    PayloadListener listener;
+
+    auto requireRejected = [&protocol, &listener](json msg, int expectedMsgType, int expectedRequestId) {
+        listener.errors.clear();
+        bool handled = true;
+        REQUIRE_NOTHROW(handled = protocol.handleMessage(std::move(msg), listener));
+        REQUIRE(handled == false);
+        REQUIRE(protocol.lastError().empty() == false);
+        REQUIRE(listener.errors.size() == 1);
+        REQUIRE(listener.errors[0][0] == expectedMsgType);
+        REQUIRE(listener.errors[0][1] == expectedRequestId);
+        REQUIRE(listener.errors[0][2] == protocol.lastError());
+    };
+
+    SECTION("message which is not an array starting with a type") {
+        requireRejected(json::object(), 0, 0);
+        requireRejected(json::array(), 0, 0);
+        requireRejected(json::array({ "link", "demo.Calc" }), 0, 0);
+        requireRejected(json(json::value_t::discarded), 0, 0);
+    }
+    SECTION("unsupported message type") {
+        requireRejected(json::array({ 1234, "demo.Calc" }), 1234, 0);
+    }
+    SECTION("missing fields") {
+        requireRejected(json::array({ MsgType::Link }), int(MsgType::Link), 0);
+        requireRejected(json::array({ MsgType::PropertyChange, "demo.Calc/total" }), int(MsgType::PropertyChange), 0);
+        requireRejected(json::array({ MsgType::Invoke, 12, "demo.Calc/add" }), int(MsgType::Invoke), 12);
+        requireRejected(json::array({ MsgType::Error, int(MsgType::Invoke), 12 }), int(MsgType::Error), 0);
+    }
+    SECTION("fields of wrong type") {
+        requireRejected(json::array({ MsgType::Link, 5 }), int(MsgType::Link), 0);
+        requireRejected(json::array({ MsgType::Signal, json::array(), 1 }), int(MsgType::Signal), 0);
+        requireRejected(json::array({ MsgType::InvokeReply, "12", "demo.Calc/add", 1 }), int(MsgType::InvokeReply), 0);
+        requireRejected(json::array({ MsgType::Invoke, 12, 13, 1 }), int(MsgType::Invoke), 12);
+        requireRejected(json::array({ MsgType::Error, int(MsgType::Invoke), 12, 1 }), int(MsgType::Error), 0);
+    }
+    SECTION("the error report does not grow with the size of the message") {
+        requireRejected(json::array({ MsgType::Invoke, 12, 13, std::string(100000, 'x'), 5, 6, 7, 8, 9 }), int(MsgType::Invoke), 12);
+        REQUIRE(protocol.lastError().size() < 200);
+        requireRejected(json::array({ MsgType::Link, std::vector<int>(100000, 1) }), int(MsgType::Link), 0);
+        REQUIRE(protocol.lastError().size() < 200);
+    }
+    SECTION("well formed message after rejected one clears the error") {
+        requireRejected(json::array({ MsgType::Link }), int(MsgType::Link), 0);
+        REQUIRE(protocol.handleMessage(Protocol::signalMessage("demo.Calc/hit", { 1 }), listener));
+        REQUIRE(protocol.lastError().empty());
+    }
+}
+
+TEST_CASE("converter without exceptions")
+{
+    std::string garbage = "\xff\x01[not a message";
+    for (auto format : { MessageFormat::JSON, MessageFormat::BSON, MessageFormat::MSGPACK, MessageFormat::CBOR }) {
+        MessageConverter converter(format);
+        REQUIRE_THROWS(converter.fromString(garbage));
+        json result;
+        REQUIRE_NOTHROW(result = converter.fromString(garbage, false));
+        REQUIRE(result.is_discarded());
+    }
+    // BSON is left out, it cannot hold an array as top level element.
+    for (auto format : { MessageFormat::JSON, MessageFormat::MSGPACK, MessageFormat::CBOR }) {
+        MessageConverter converter(format);
+        auto message = Protocol::signalMessage("demo.Calc/hit", { 1 });
+        REQUIRE(converter.fromString(converter.toString(message), false) == message);
+    }
+}
+
+TEST_CASE("converter parses messages in place")
+{
+    auto message = Protocol::invokeMessage(3, "demo.Calc/add", { 1, 2 });
+    for (auto format : { MessageFormat::JSON, MessageFormat::MSGPACK, MessageFormat::CBOR }) {
+        MessageConverter converter(format);
+        // message embedded in a bigger receive buffer
+        std::string buffer = "head" + converter.toString(message) + "tail";
+        REQUIRE(converter.fromString(buffer.data() + 4, buffer.size() - 8) == message);
+        REQUIRE(converter.fromString(buffer.data() + 4, buffer.size() - 8, false) == message);
+        REQUIRE(converter.fromString(buffer.data() + 4, buffer.size() - 9, false).is_discarded());
+    }
+}
+
+namespace {
+    // Listener which rebuilds the v1 message from the handler arguments.
+    class RebuildingListener : public IProtocolListener
+    {
+    public:
+        void handleLink(const std::string& objectId) override { received = Protocol::linkMessage(objectId); }
+        void handleUnlink(const std::string& objectId) override { received = Protocol::unlinkMessage(objectId); }
+        void handleInit(const std::string& objectId, const nlohmann::json& props) override { received = Protocol::initMessage(objectId, props); }
+        void handleSetProperty(const std::string& propertyId, const nlohmann::json& value) override { received = Protocol::setPropertyMessage(propertyId, value); }
+        void handlePropertyChange(const std::string& propertyId, const nlohmann::json& value) override { received = Protocol::propertyChangeMessage(propertyId, value); }
+        void handleInvoke(int requestId, const std::string& methodId, const nlohmann::json& args) override { received = Protocol::invokeMessage(requestId, methodId, args); }
+        void handleInvokeReply(int requestId, const std::string& methodId, const nlohmann::json& value) override { received = Protocol::invokeReplyMessage(requestId, methodId, value); }
+        void handleSignal(const std::string& signalId, const nlohmann::json& args) override { received = Protocol::signalMessage(signalId, args); }
+        void handleError(int msgType, int requestId, const std::string& error) override { received = Protocol::errorMessage(MsgType(msgType), requestId, error); }
+
+        json received;
+    };
+}
+
+TEST_CASE("compact protocol v2 messages")
+{
+    Protocol protocol;
+    RebuildingListener listener;
+    const json props = {{ "count", 0 }};
+
+    SECTION("compact messages are handled like the v1 messages") {
+        const std::vector<json> messages = {
+            Protocol::linkMessage("demo.Calc"),
+            Protocol::unlinkMessage("demo.Calc"),
+            Protocol::initMessage("demo.Calc", props),
+            Protocol::initMessage("demo.Calc", json::object()),
+            Protocol::setPropertyMessage("demo.Calc/count", 1),
+            Protocol::propertyChangeMessage("demo.Calc/count", nullptr),
+            Protocol::invokeMessage(3, "demo.Calc/add", { 1, 2 }),
+            Protocol::invokeMessage(4, "demo.Calc/clear", json::array()),
+            Protocol::invokeMessage(5, "demo.Calc/reset", json::object()),
+            Protocol::signalMessage("demo.Calc/hit", json::array()),
+            Protocol::signalMessage("demo.Calc/hit", { 5 }),
+            Protocol::errorMessage(MsgType::Invoke, 7, "failed"),
+            Protocol::errorMessage(MsgType::Link, 0, "no source"),
+        };
+        for (const auto& msg : messages) {
+            auto compact = Protocol::compactMessage(json(msg));
+            REQUIRE(compact[0].get<int>() < 24);
+            REQUIRE(fullMsgType(compact[0].get<int>()) == msg[0].get<int>());
+            REQUIRE(compact.size() <= msg.size());
+            REQUIRE(protocol.handleMessage(std::move(compact), listener));
+            REQUIRE(listener.received == msg);
+        }
+    }
+    SECTION("invoke reply is identified by the request id only") {
+        const auto compact = Protocol::compactMessage(Protocol::invokeReplyMessage(9, "demo.Calc/add", 3));
+        REQUIRE(compact == json::array({ MsgType::CompactInvokeReply, 9, 3 }));
+        REQUIRE(protocol.handleMessage(compact, listener));
+        REQUIRE(listener.received == Protocol::invokeReplyMessage(9, "", 3));
+        REQUIRE(Protocol::compactMessage(Protocol::invokeReplyMessage(9, "demo.Calc/clear", nullptr)) == json::array({ MsgType::CompactInvokeReply, 9 }));
+    }
+    SECTION("empty payloads and the msgType of invoke errors are omitted") {
+        REQUIRE(Protocol::compactMessage(Protocol::invokeMessage(4, "demo.Calc/clear", json::array())).size() == 3);
+        REQUIRE(Protocol::compactMessage(Protocol::invokeMessage(5, "demo.Calc/reset", json::object())).size() == 4);
+        REQUIRE(Protocol::compactMessage(Protocol::errorMessage(MsgType::Invoke, 7, "failed")) == json::array({ MsgType::CompactError, 7, "failed" }));
+        REQUIRE(Protocol::compactMessage(Protocol::errorMessage(MsgType::Link, 0, "no source")).size() == 4);
+    }
+    SECTION("malformed compact messages are rejected") {
+        REQUIRE_FALSE(protocol.handleMessage(json::array({ MsgType::CompactInvoke, 12 }), listener));
+        REQUIRE(listener.received == Protocol::errorMessage(MsgType::CompactInvoke, 12, protocol.lastError()));
+        REQUIRE_FALSE(protocol.handleMessage(json::array({ MsgType::CompactInvokeReply, "12" }), listener));
+        REQUIRE_FALSE(protocol.handleMessage(json::array({ MsgType::CompactError, 12, "failed", "link" }), listener));
+        REQUIRE_FALSE(protocol.handleMessage(json::array({ MsgType::CompactPropertyChange, "demo.Calc/count" }), listener));
+    }
+}
@@ -0,0 +1,84 @@
+#include <catch2/catch.hpp>
+
+#include "olink/core/messagecodec.h"
+#include "olink/core/protocol.h"
+#include "olink/core/simdjsoncodec.h"
+#include "olink/core/types.h"
+#include "olink/remotenode.h"
+#include "olink/remoteregistry.h"
+
+#include "sourceobject.hpp"
+
+#include "nlohmann/json.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace ApiGear::ObjectLink;
+
+TEST_CASE("simdjson codec")
+{
+    SimdJsonCodec codec;
+    auto jsonCodec = IMessageCodec::create(MessageFormat::JSON);
+    REQUIRE(codec.format() == MessageFormat::JSON);
+    REQUIRE_FALSE(SimdJsonCodec::implementation().empty());
+
+    SECTION("decodes the same messages as the json codec") {
+        const nlohmann::json record = {
+            { "id", 1234 }, { "name", "temperature \"sensor\" \xc3\xa4\\n" }, { "value", 21.5 }, { "valid", true },
+            { "tags", { "kitchen", "ground floor" } }, { "none", nullptr }, { "empty", nlohmann::json::object() }
+        };
+        const std::vector<nlohmann::json> messages = {
+            Protocol::linkMessage("demo.Calc"),
+            Protocol::propertyChangeMessage("demo.Calc/total", -42),
+            Protocol::propertyChangeMessage("demo.Calc/total", 18446744073709551615u),
+            Protocol::propertyChangeMessage("demo.Calc/total", -1.5e300),
+            Protocol::initMessage("demo.Calc", { { "total", 1 }, { "record", record } }),
+            Protocol::invokeMessage(17, "demo.Calc/add", nlohmann::json::array({ 1, 2.5, "three", record })),
+            Protocol::signalMessage("demo.Calc/emptied", nlohmann::json::array()),
+            Protocol::errorMessage(MsgType::Invoke, 17, "failed"),
+        };
+        for (const auto& message : messages) {
+            std::string data;
+            codec.encode(message, data);
+            REQUIRE(data == message.dump());
+            nlohmann::json decoded;
+            codec.decode(data.data(), data.size(), decoded, false);
+            nlohmann::json expected;
+            jsonCodec->decode(data.data(), data.size(), expected, false);
+            REQUIRE(decoded == expected);
+            REQUIRE(decoded.dump() == data);
+        }
+    }
+    SECTION("number types follow nlohmann json") {
+        const std::string data = R"([1, -1, 1.0, 18446744073709551615, 36893488147419103232, {"a": 1, "a": 2}])";
+        nlohmann::json decoded;
+        codec.decode(data.data(), data.size(), decoded, false);
+        nlohmann::json expected;
+        jsonCodec->decode(data.data(), data.size(), expected, false);
+        REQUIRE(decoded == expected);
+        REQUIRE(decoded[0].is_number_unsigned());
+        REQUIRE(decoded[1].is_number_integer());
+        REQUIRE(decoded[2].is_number_float());
+        REQUIRE(decoded[3].is_number_unsigned());
+        REQUIRE(decoded[4].is_number_float());
+        REQUIRE(decoded[5]["a"] == 2);
+    }
+    SECTION("malformed data is reported like by the json codec") {
+        for (const std::string data : { std::string("[1, 2"), std::string("\xff\xff["), std::string("") }) {
+            nlohmann::json decoded;
+            codec.decode(data.data(), data.size(), decoded, false);
+            REQUIRE(decoded.is_discarded());
+            REQUIRE_THROWS_AS(codec.decode(data.data(), data.size(), decoded, true), nlohmann::json::parse_error);
+        }
+    }
+    SECTION("a node decodes messages with simdjson") {
+        RemoteRegistry registry;
+        auto source = std::make_shared<CalcSource>(registry);
+        registry.addSource(source);
+        auto node = RemoteNode::createRemoteNode(registry);
+        node->setCodec(std::make_shared<SimdJsonCodec>());
+        node->handleMessage(Protocol::linkMessage(source->olinkObjectName()).dump());
+        REQUIRE(registry.getNodes(source->olinkObjectName()).size() == 1);
+    }
+}
@@ -0,0 +1,165 @@
+#include <catch2/catch.hpp>
+
+#include "olink/core/messagecodec.h"
+#include "olink/core/protocol.h"
+#include "olink/core/typedarray.h"
+#include "olink/core/types.h"
+#include "olink/clientnode.h"
+#include "olink/clientregistry.h"
+#include "olink/iobjectsink.h"
+
+#include "nlohmann/json.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace ApiGear::ObjectLink;
+
+namespace {
+
+/** Keeps the samples property as floats and whether they were viewed in place. */
+class ScopeSink : public IObjectSink
+{
+public:
+    std::string olinkObjectName() override
+    {
+        return "demo.Scope";
+    }
+    void olinkOnSignal(const std::string&, const nlohmann::json&) override {}
+    void olinkOnPropertyChanged(const std::string&, const nlohmann::json& value) override
+    {
+        TypedArrayView<float> view(value);
+        valid = view.valid();
+        inPlace = !view.converted();
+        samples = view.toVector();
+    }
+    void olinkOnInit(const std::string&, const nlohmann::json&, IClientNode*) override {}
+    void olinkOnRelease() override {}
+
+    bool valid = false;
+    bool inPlace = false;
+    std::vector<float> samples;
+};
+
+/** @return the typed array with the bytes of each element reversed and the tag for the other byte order. */
+template<typename T>
+nlohmann::json otherByteOrder(const std::vector<T>& values)
+{
+    auto array = makeTypedArray(values);
+    auto& binary = array.get_binary();
+    swapByteOrder(binary.data(), binary.data(), values.size(), sizeof(T));
+    binary.set_subtype(binary.subtype() ^ 0x04);
+    return array;
+}
+
+} // namespace
+
+TEST_CASE("typed arrays")
+{
+    const std::vector<float> floats = { 0.5f, -1.25f, 3e38f, 0.0f, 7.0f };
+
+    SECTION("tags follow RFC 8746") {
+        REQUIRE(typedArrayTag<std::uint8_t>() == 64);
+        REQUIRE(typedArrayTag<std::int8_t>() == 72);
+        if (nativeLittleEndian) {
+            REQUIRE(typedArrayTag<std::uint16_t>() == 69);
+            REQUIRE(typedArrayTag<std::int32_t>() == 78);
+            REQUIRE(typedArrayTag<std::uint64_t>() == 71);
+            REQUIRE(typedArrayTag<float>() == 85);
+            REQUIRE(typedArrayTag<double>() == 86);
+        }
+        TypedArrayElement element;
+        REQUIRE(typedArrayElement(82, element));
+        REQUIRE(element.isFloat);
+        REQUIRE_FALSE(element.littleEndian);
+        REQUIRE(element.size == 8);
+        REQUIRE(typedArrayElement(75, element));
+        REQUIRE(element.isSigned);
+        REQUIRE(element.size == 8);
+        REQUIRE(typedArrayElement(68, element));
+        REQUIRE(element.size == 1);
+        // float16, float128, reserved and other tags
+        REQUIRE_FALSE(typedArrayElement(80, element));
+        REQUIRE_FALSE(typedArrayElement(83, element));
+        REQUIRE_FALSE(typedArrayElement(76, element));
+        REQUIRE_FALSE(typedArrayElement(1, element));
+        REQUIRE_FALSE(typedArrayElement(88, element));
+    }
+    SECTION("typed arrays are raw bytes in binary formats and viewed in place") {
+        const auto message = Protocol::propertyChangeMessage("demo.Scope/samples", makeTypedArray(floats));
+        for (auto format : { MessageFormat::MSGPACK, MessageFormat::CBOR }) {
+            auto codec = IMessageCodec::create(format);
+            std::string data;
+            codec->encode(message, data);
+            REQUIRE(data.size() < 32 + floats.size() * sizeof(float));
+            nlohmann::json decoded;
+            codec->decode(data.data(), data.size(), decoded, false);
+            REQUIRE(decoded == message);
+            TypedArrayView<float> view(decoded[2]);
+            REQUIRE(view.valid());
+            REQUIRE_FALSE(view.converted());
+            REQUIRE(view.data() == reinterpret_cast<const float*>(decoded[2].get_binary().data()));
+            REQUIRE(view.toVector() == floats);
+        }
+    }
+    SECTION("the json form of typed arrays is read as well") {
+        const auto message = Protocol::propertyChangeMessage("demo.Scope/samples", makeTypedArray(floats));
+        auto codec = IMessageCodec::create(MessageFormat::JSON);
+        std::string data;
+        codec->encode(message, data);
+        nlohmann::json decoded;
+        codec->decode(data.data(), data.size(), decoded, false);
+        REQUIRE(decoded[2].is_object());
+        TypedArrayView<float> view(decoded[2]);
+        REQUIRE(view.valid());
+        REQUIRE(view.converted());
+        REQUIRE(view.toVector() == floats);
+    }
+    SECTION("other byte order and element types are converted") {
+        const std::vector<std::int32_t> ints = { 1, -2, 0x12345678, -0x7fffffff };
+        TypedArrayView<std::int32_t> swapped(otherByteOrder(ints));
+        REQUIRE(swapped.valid());
+        REQUIRE(swapped.converted());
+        REQUIRE(swapped.toVector() == ints);
+
+        const std::vector<std::uint16_t> shorts = { 1, 0xff00, 0x1234 };
+        REQUIRE(TypedArrayView<std::uint16_t>(otherByteOrder(shorts)).toVector() == shorts);
+        const std::vector<double> doubles = { 0.1, -2.5e300 };
+        REQUIRE(TypedArrayView<double>(otherByteOrder(doubles)).toVector() == doubles);
+
+        TypedArrayView<double> widened(makeTypedArray(ints));
+        REQUIRE(widened.valid());
+        REQUIRE(widened.toVector() == std::vector<double>({ 1.0, -2.0, 305419896.0, -2147483647.0 }));
+        TypedArrayView<double> fromSwappedFloats(otherByteOrder(floats));
+        REQUIRE(fromSwappedFloats.size() == floats.size());
+        REQUIRE(fromSwappedFloats[1] == -1.25);
+    }
+    SECTION("arrays of numbers are converted, other values are not valid") {
+        TypedArrayView<float> numbers(nlohmann::json::array({ 1, 2.5, -3 }));
+        REQUIRE(numbers.valid());
+        REQUIRE(numbers.toVector() == std::vector<float>({ 1.0f, 2.5f, -3.0f }));
+        REQUIRE(TypedArrayView<float>(nlohmann::json::array()).valid());
+        REQUIRE(TypedArrayView<float>(nlohmann::json::array()).empty());
+
+        REQUIRE_FALSE(TypedArrayView<float>(nlohmann::json::array({ 1, "two" })).valid());
+        REQUIRE_FALSE(TypedArrayView<float>(nlohmann::json("text")).valid());
+        REQUIRE_FALSE(TypedArrayView<float>(nlohmann::json::binary({ 1, 2, 3, 4 })).valid());
+        REQUIRE_FALSE(TypedArrayView<float>(nlohmann::json::binary({ 1, 2, 3 }, typedArrayTag<float>())).valid());
+        REQUIRE_FALSE(TypedArrayView<float>(nlohmann::json::binary({ 1, 2 }, 80)).valid());
+        REQUIRE_FALSE(TypedArrayView<float>(nlohmann::json({ { "bytes", { 1, 300, 3, 4 } }, { "subtype", 85 } })).valid());
+    }
+    SECTION("sinks receive typed arrays sent in binary formats") {
+        ClientRegistry registry;
+        auto sink = std::make_shared<ScopeSink>();
+        registry.addSink(sink);
+        auto client = ClientNode::create(registry);
+        client->setMessageFormat(MessageFormat::CBOR);
+        MessageConverter converter(MessageFormat::CBOR);
+        client->handleMessage(converter.toString(Protocol::propertyChangeMessage("demo.Scope/samples", makeTypedArray(floats))));
+        REQUIRE(sink->valid);
+        REQUIRE(sink->inPlace);
+        REQUIRE(sink->samples == floats);
+        registry.removeSink("demo.Scope");
+    }
+}
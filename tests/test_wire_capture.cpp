@@ -0,0 +1,184 @@
+#include <catch2/catch.hpp>
+
+#include "olink/core/protocol.h"
+#include "olink/core/types.h"
+#include "olink/core/wirecapture.h"
+#include "olink/clientnode.h"
+#include "olink/clientregistry.h"
+#include "olink/remotenode.h"
+#include "olink/remoteregistry.h"
+
+#include "sinkobject.hpp"
+#include "sourceobject.hpp"
+
+#include "nlohmann/json.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace ApiGear::ObjectLink;
+
+namespace {
+
+const std::string capturePath = "test_wire_capture.olcap";
+
+std::vector<CapturedFrame> readAll(WireCaptureReader& reader)
+{
+    std::vector<CapturedFrame> frames;
+    CapturedFrame frame;
+    while (reader.next(frame)) {
+        frames.push_back(frame);
+    }
+    return frames;
+}
+
+} // namespace
+
+TEST_CASE("wire capture")
+{
+    std::remove(capturePath.c_str());
+
+    SECTION("records and reads frames") {
+        WireCapture capture;
+        REQUIRE(capture.open(capturePath));
+        REQUIRE(capture.isOpen());
+        const auto first = capture.addStream();
+        const auto second = capture.addStream();
+        REQUIRE(first != second);
+        capture.record(first, CaptureDirection::Sent, MessageFormat::JSON, "[10,\"demo.Calc\"]", 16);
+        capture.record(second, CaptureDirection::Received, MessageFormat::CBOR, "\x82\x0a", 2);
+        REQUIRE(capture.size() == WireCapture::headerSize + 2 * WireCapture::frameHeaderSize + 18);
+        capture.close();
+        REQUIRE_FALSE(capture.isOpen());
+        // frames recorded after close are ignored
+        capture.record(first, CaptureDirection::Sent, MessageFormat::JSON, "[]", 2);
+
+        WireCaptureReader reader;
+        REQUIRE(reader.open(capturePath));
+        auto frames = readAll(reader);
+        REQUIRE(frames.size() == 2);
+        REQUIRE(frames[0].stream == first);
+        REQUIRE(frames[0].direction == CaptureDirection::Sent);
+        REQUIRE(frames[0].format == MessageFormat::JSON);
+        REQUIRE(std::string(frames[0].data, frames[0].size) == "[10,\"demo.Calc\"]");
+        REQUIRE(frames[1].stream == second);
+        REQUIRE(frames[1].direction == CaptureDirection::Received);
+        REQUIRE(frames[1].format == MessageFormat::CBOR);
+        REQUIRE(std::string(frames[1].data, frames[1].size) == std::string("\x82\x0a", 2));
+        REQUIRE(frames[0].time <= frames[1].time);
+
+        reader.rewind();
+        REQUIRE(readAll(reader).size() == 2);
+    }
+    SECTION("reads a capture cut off in the middle of a frame") {
+        {
+            WireCapture capture;
+            REQUIRE(capture.open(capturePath));
+            capture.record(0, CaptureDirection::Sent, MessageFormat::JSON, "[1]", 3);
+            capture.record(0, CaptureDirection::Sent, MessageFormat::JSON, "[2]", 3);
+        }
+        std::ifstream in(capturePath, std::ios::binary);
+        std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        in.close();
+        REQUIRE(content.size() == WireCapture::headerSize + 2 * WireCapture::frameHeaderSize + 6);
+        std::ofstream out(capturePath, std::ios::binary | std::ios::trunc);
+        out.write(content.data(), static_cast<std::streamsize>(content.size() - 1));
+        out.close();
+
+        WireCaptureReader reader;
+        REQUIRE(reader.open(capturePath));
+        auto frames = readAll(reader);
+        REQUIRE(frames.size() == 1);
+        REQUIRE(std::string(frames[0].data, frames[0].size) == "[1]");
+    }
+    SECTION("rewinds to the first frame after a larger file header") {
+        {
+            WireCapture capture;
+            REQUIRE(capture.open(capturePath));
+            capture.record(0, CaptureDirection::Sent, MessageFormat::JSON, "[1]", 3);
+            capture.record(0, CaptureDirection::Sent, MessageFormat::JSON, "[2]", 3);
+        }
+        std::ifstream in(capturePath, std::ios::binary);
+        std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        in.close();
+        // a newer writer may append fields to the header, readers skip them
+        const std::size_t extraHeader = WireCapture::frameHeaderSize + 3;
+        const auto largerHeaderSize = static_cast<std::uint32_t>(WireCapture::headerSize + extraHeader);
+        std::memcpy(&content[8 + sizeof(std::uint32_t)], &largerHeaderSize, sizeof(largerHeaderSize));
+        content.insert(WireCapture::headerSize, content.substr(WireCapture::headerSize, extraHeader));
+        std::ofstream out(capturePath, std::ios::binary | std::ios::trunc);
+        out.write(content.data(), static_cast<std::streamsize>(content.size()));
+        out.close();
+
+        WireCaptureReader reader;
+        REQUIRE(reader.open(capturePath));
+        auto frames = readAll(reader);
+        REQUIRE(frames.size() == 2);
+        REQUIRE(std::string(frames[0].data, frames[0].size) == "[1]");
+        reader.rewind();
+        frames = readAll(reader);
+        REQUIRE(frames.size() == 2);
+        REQUIRE(std::string(frames[0].data, frames[0].size) == "[1]");
+        REQUIRE(std::string(frames[1].data, frames[1].size) == "[2]");
+    }
+    SECTION("rejects files which are not captures") {
+        std::ofstream out(capturePath, std::ios::binary | std::ios::trunc);
+        out << std::string(64, 'x');
+        out.close();
+        WireCaptureReader reader;
+        REQUIRE_FALSE(reader.open(capturePath));
+        REQUIRE_FALSE(reader.open("does_not_exist.olcap"));
+    }
+    SECTION("records frames sent and received by nodes") {
+        RemoteRegistry registry;
+        ClientRegistry clientRegistry;
+        auto remote = RemoteNode::createRemoteNode(registry);
+        auto source = std::make_shared<CalcSource>(registry);
+        registry.addSource(source);
+        auto client = ClientNode::create(clientRegistry);
+        auto sink = std::make_shared<CalcSink>(clientRegistry);
+        clientRegistry.addSink(sink);
+        client->setMessageFormat(MessageFormat::MSGPACK);
+        remote->setMessageFormat(MessageFormat::MSGPACK);
+        client->onWrite([&remote](const std::string& msg) { remote->handleMessage(msg); });
+        remote->onWrite([&client](const std::string& msg) { client->handleMessage(msg); });
+
+        auto capture = std::make_shared<WireCapture>();
+        REQUIRE(capture->open(capturePath));
+        client->setWireCapture(capture);
+        remote->setWireCapture(capture);
+        REQUIRE(client->wireCapture() == capture);
+        client->linkRemote("demo.Calc");
+        client->setWireCapture(nullptr);
+        remote->setWireCapture(nullptr);
+        sink->setTotal(5);
+        capture->close();
+
+        WireCaptureReader reader;
+        REQUIRE(reader.open(capturePath));
+        auto frames = readAll(reader);
+        // link sent by the client and received by the remote, then init sent by the remote and received by the client
+        REQUIRE(frames.size() == 4);
+        MessageConverter converter(MessageFormat::MSGPACK);
+        const auto clientStream = frames[0].stream;
+        const auto remoteStream = frames[1].stream;
+        REQUIRE(clientStream != remoteStream);
+        REQUIRE(frames[0].direction == CaptureDirection::Sent);
+        REQUIRE(frames[1].direction == CaptureDirection::Received);
+        REQUIRE(frames[2].stream == remoteStream);
+        REQUIRE(frames[2].direction == CaptureDirection::Sent);
+        REQUIRE(frames[3].stream == clientStream);
+        REQUIRE(frames[3].direction == CaptureDirection::Received);
+        for (const auto& frame : frames) {
+            REQUIRE(frame.format == MessageFormat::MSGPACK);
+        }
+        REQUIRE(converter.fromString(frames[1].data, frames[1].size) == Protocol::linkMessage("demo.Calc"));
+        REQUIRE(converter.fromString(frames[3].data, frames[3].size)[0] == int(MsgType::Init));
+    }
+
+    std::remove(capturePath.c_str());
+}
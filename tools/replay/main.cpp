@@ -0,0 +1,385 @@
+/*
+* MIT License
+*
+* Copyright (c) 2021 ApiGear
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#include "olink/clientnode.h"
+#include "olink/clientregistry.h"
+#include "olink/core/wirecapture.h"
+#include "olink/iobjectsink.h"
+#include "olink/iobjectsource.h"
+#include "olink/remotenode.h"
+#include "olink/remoteregistry.h"
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+* olink_replay feeds the frames received by nodes, as recorded with BaseNode::setWireCapture,
+* into new nodes of this process. Remote node streams are replayed into a RemoteRegistry with sources
+* for all the objects, client node streams into a ClientRegistry per stream with sinks for all the objects.
+* Sinks and sources do nothing, so the replay measures the cost of the protocol handling only.
+*/
+
+using namespace ApiGear::ObjectLink;
+
+namespace {
+
+const std::string remoteSide = "remote";
+const std::string clientSide = "client";
+const std::string bothSides = "both";
+
+struct Options
+{
+    std::string path;
+    /** Replay speed relative to the recording, 0 replays as fast as possible. */
+    double speed = 1.0;
+    std::string side = bothSides;
+    int repeat = 1;
+};
+
+class ReplaySink : public IObjectSink
+{
+public:
+    explicit ReplaySink(const std::string& objectId)
+        : m_objectId(objectId)
+    {}
+    std::string olinkObjectName() override
+    {
+        return m_objectId;
+    }
+    void olinkOnSignal(const std::string&, const nlohmann::json&) override
+    {
+    }
+    void olinkOnPropertyChanged(const std::string&, const nlohmann::json&) override
+    {
+    }
+    void olinkOnInit(const std::string&, const nlohmann::json&, IClientNode*) override
+    {
+    }
+    void olinkOnRelease() override
+    {
+    }
+private:
+    std::string m_objectId;
+};
+
+class ReplaySource : public IObjectSource
+{
+public:
+    explicit ReplaySource(const std::string& objectId)
+        : m_objectId(objectId)
+    {}
+    std::string olinkObjectName() override
+    {
+        return m_objectId;
+    }
+    nlohmann::json olinkInvoke(const std::string&, const nlohmann::json&) override
+    {
+        return nlohmann::json();
+    }
+    void olinkSetProperty(const std::string&, const nlohmann::json&) override
+    {
+    }
+    void olinkLinked(const std::string&, IRemoteNode*) override
+    {
+    }
+    void olinkUnlinked(const std::string&) override
+    {
+    }
+    nlohmann::json olinkCollectProperties() override
+    {
+        return nlohmann::json::object();
+    }
+private:
+    std::string m_objectId;
+};
+
+/** What is known about a recorded stream after the first pass over the capture. */
+struct StreamInfo
+{
+    /** true for streams recorded by a remote node, false for client nodes. */
+    bool remote = false;
+    bool classified = false;
+    MessageFormat format = MessageFormat::JSON;
+    std::set<std::string> objectIds;
+};
+
+/** A node replaying one stream. */
+struct ReplayStream
+{
+    std::unique_ptr<ClientRegistry> clientRegistry;
+    std::vector<std::shared_ptr<ReplaySink>> sinks;
+    std::shared_ptr<BaseNode> node;
+};
+
+void printUsage()
+{
+    std::cout << "usage: olink_replay [options] CAPTURE\n"
+        << "  --speed S      replay speed: 1 for the recorded timing, N for N times faster, max for no delays (default 1)\n"
+        << "  --side SIDE    streams to replay: remote, client or both (default both)\n"
+        << "  --repeat N     replay the capture N times (default 1)\n";
+}
+
+bool parseOptions(int argc, char* argv[], Options& options)
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage();
+            return false;
+        }
+        if (arg.compare(0, 2, "--") != 0) {
+            options.path = arg;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "missing value for " << arg << "\n";
+            return false;
+        }
+        const std::string value = argv[++i];
+        if (arg == "--speed") {
+            options.speed = value == "max" ? 0.0 : std::atof(value.c_str());
+            if (value != "max" && options.speed <= 0.0) {
+                std::cerr << "invalid speed " << value << "\n";
+                return false;
+            }
+        } else if (arg == "--side") {
+            if (value != remoteSide && value != clientSide && value != bothSides) {
+                std::cerr << "invalid side " << value << "\n";
+                return false;
+            }
+            options.side = value;
+        } else if (arg == "--repeat") {
+            options.repeat = std::max(1, std::atoi(value.c_str()));
+        } else {
+            std::cerr << "unknown option " << arg << "\n";
+            printUsage();
+            return false;
+        }
+    }
+    if (options.path.empty()) {
+        printUsage();
+        return false;
+    }
+    return true;
+}
+
+/** @return id of the object a received message is about, or empty string. */
+std::string objectIdOf(const nlohmann::json& msg, int msgType)
+{
+    switch(msgType) {
+    case int(MsgType::Link):
+    case int(MsgType::Unlink):
+    case int(MsgType::Init):
+        return msg[1].is_string() ? msg[1].get<std::string>() : std::string();
+    case int(MsgType::SetProperty):
+    case int(MsgType::PropertyChange):
+    case int(MsgType::Signal):
+        return msg[1].is_string() ? Name::getObjectId(msg[1].get<std::string>()) : std::string();
+    case int(MsgType::Invoke):
+    case int(MsgType::InvokeReply):
+        // compact invoke replies carry no method id
+        return msg.size() > 2 && msg[2].is_string() && msg[0] != int(MsgType::CompactInvokeReply)
+            ? Name::getObjectId(msg[2].get<std::string>()) : std::string();
+    default:
+        return std::string();
+    }
+}
+
+/**
+* Finds out which node recorded each stream, from the types of received messages, and the objects used by the streams.
+* Only the received frames are replayed, sent frames are produced again by the replaying nodes.
+*/
+std::map<std::uint32_t, StreamInfo> classifyStreams(WireCaptureReader& reader)
+{
+    std::map<std::uint32_t, StreamInfo> streams;
+    CapturedFrame frame;
+    while (reader.next(frame)) {
+        if (frame.direction != CaptureDirection::Received) {
+            continue;
+        }
+        MessageConverter converter(frame.format);
+        const auto msg = converter.fromString(frame.data, frame.size, false);
+        if (!msg.is_array() || msg.size() < 2 || !msg[0].is_number_integer()) {
+            continue;
+        }
+        const int msgType = fullMsgType(msg[0].get<int>());
+        auto& info = streams[frame.stream];
+        info.format = frame.format;
+        if (!info.classified) {
+            switch(msgType) {
+            case int(MsgType::Link):
+            case int(MsgType::Unlink):
+            case int(MsgType::SetProperty):
+            case int(MsgType::Invoke):
+            case int(MsgType::InvokeBatch):
+                info.remote = true;
+                info.classified = true;
+                break;
+            case int(MsgType::Init):
+            case int(MsgType::PropertyChange):
+            case int(MsgType::Signal):
+            case int(MsgType::InvokeReply):
+            case int(MsgType::InvokeBatchReply):
+                info.remote = false;
+                info.classified = true;
+                break;
+            }
+        }
+        const auto objectId = objectIdOf(msg, msgType);
+        if (!objectId.empty()) {
+            info.objectIds.insert(objectId);
+        }
+    }
+    reader.rewind();
+    return streams;
+}
+
+bool replaySide(const Options& options, bool remote)
+{
+    return options.side == bothSides || options.side == (remote ? remoteSide : clientSide);
+}
+
+/** Sums the metrics of all replaying nodes. */
+void printMetrics(const std::map<std::uint32_t, ReplayStream>& replays)
+{
+    std::uint64_t decodeErrors = 0;
+    std::uint64_t decodeNs = 0;
+    std::uint64_t encodeNs = 0;
+    std::uint64_t handlerNs = 0;
+    std::uint64_t sent = 0;
+    for (const auto& replay : replays) {
+        const auto snapshot = replay.second.node->metrics()->snapshot();
+        decodeErrors += snapshot.decodeErrors;
+        decodeNs += snapshot.decodeTime.sum;
+        encodeNs += snapshot.encodeTime.sum;
+        handlerNs += snapshot.handlerTime.sum;
+        sent += snapshot.total().messagesOut;
+    }
+    std::cout << "replies sent: " << sent << ", decode errors: " << decodeErrors << "\n"
+        << std::fixed << std::setprecision(3)
+        << "decode: " << static_cast<double>(decodeNs) / 1e6 << " ms, encode: " << static_cast<double>(encodeNs) / 1e6
+        << " ms, handlers: " << static_cast<double>(handlerNs) / 1e6 << " ms\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        return 1;
+    }
+    WireCaptureReader reader;
+    if (!reader.open(options.path)) {
+        std::cerr << "can not read capture " << options.path << "\n";
+        return 1;
+    }
+    const auto streams = classifyStreams(reader);
+
+    RemoteRegistry remoteRegistry;
+    std::vector<std::shared_ptr<ReplaySource>> sources;
+    std::map<std::uint32_t, ReplayStream> replays;
+    for (const auto& stream : streams) {
+        const auto& info = stream.second;
+        if (!info.classified || !replaySide(options, info.remote)) {
+            continue;
+        }
+        auto& replay = replays[stream.first];
+        if (info.remote) {
+            for (const auto& objectId : info.objectIds) {
+                if (remoteRegistry.getSource(objectId).expired()) {
+                    sources.push_back(std::make_shared<ReplaySource>(objectId));
+                    remoteRegistry.addSource(sources.back());
+                }
+            }
+            replay.node = RemoteNode::createRemoteNode(remoteRegistry);
+        } else {
+            replay.clientRegistry.reset(new ClientRegistry());
+            for (const auto& objectId : info.objectIds) {
+                replay.sinks.push_back(std::make_shared<ReplaySink>(objectId));
+                replay.clientRegistry->addSink(replay.sinks.back());
+            }
+            replay.node = ClientNode::create(*replay.clientRegistry);
+        }
+        replay.node->setMessageFormat(info.format);
+        replay.node->onWrite([](const std::string&) {});
+    }
+    if (replays.empty()) {
+        std::cerr << "no streams to replay in " << options.path << "\n";
+        return 1;
+    }
+
+    std::uint64_t frames = 0;
+    std::uint64_t bytes = 0;
+    std::chrono::nanoseconds recorded{ 0 };
+    const auto start = std::chrono::steady_clock::now();
+    for (int run = 0; run < options.repeat; ++run) {
+        const auto runStart = std::chrono::steady_clock::now();
+        CapturedFrame frame;
+        while (reader.next(frame)) {
+            if (frame.direction != CaptureDirection::Received) {
+                continue;
+            }
+            auto replay = replays.find(frame.stream);
+            if (replay == replays.end()) {
+                continue;
+            }
+            if (options.speed > 0.0) {
+                const auto due = std::chrono::duration_cast<std::chrono::nanoseconds>(frame.time / options.speed);
+                std::this_thread::sleep_until(runStart + due);
+            }
+            replay->second.node->handleMessage(frame.data, frame.size);
+            recorded = std::max(recorded, frame.time);
+            ++frames;
+            bytes += frame.size;
+        }
+        reader.rewind();
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::size_t remoteStreams = 0;
+    for (const auto& replay : replays) {
+        remoteStreams += streams.at(replay.first).remote ? 1 : 0;
+    }
+    std::cout << "streams: " << replays.size() << " (" << remoteStreams << " remote, " << replays.size() - remoteStreams << " client)"
+        << ", objects: " << remoteRegistry.objectCount() << " sources\n"
+        << std::fixed << std::setprecision(3)
+        << "frames: " << frames << ", bytes: " << bytes << ", recorded: " << std::chrono::duration<double>(recorded).count()
+        << " s, replayed: " << seconds << " s\n"
+        << std::setprecision(0)
+        << "frames/s: " << (seconds > 0.0 ? static_cast<double>(frames) / seconds : 0.0)
+        << ", MB/s: " << std::setprecision(1) << (seconds > 0.0 ? static_cast<double>(bytes) / seconds / 1e6 : 0.0) << "\n";
+    printMetrics(replays);
+    return 0;
+}
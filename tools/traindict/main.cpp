@@ -0,0 +1,125 @@
+/*
+* MIT License
+*
+* Copyright (c) 2021 ApiGear
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#include "olink/core/compressedcodec.h"
+#include "olink/core/messagecodec.h"
+#include "olink/core/wirecapture.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+* olink_train_dict trains a zstd dictionary for CompressedCodec on the frames of captures written by WireCapture.
+* Record the captures without compression, the dictionary learns the keys, ids and values repeated in the messages.
+* Prints the dictionary id and the compressed size of the sample frames with and without the dictionary.
+*/
+
+using namespace ApiGear::ObjectLink;
+
+namespace {
+
+void printUsage()
+{
+    std::cerr << "usage: olink_train_dict [--size bytes] dictionary-file capture-file...\n"
+        << "  --size bytes  maximal dictionary size, default 16384\n";
+}
+
+/** @return summed size of the frames encoded with given codec. */
+std::size_t compressedSize(const std::vector<std::string>& frames, const std::shared_ptr<IMessageCodec>& codec, MessageFormat format)
+{
+    auto plain = IMessageCodec::create(format);
+    std::size_t total = 0;
+    std::string data;
+    for (const auto& frame : frames) {
+        nlohmann::json msg;
+        plain->decode(frame.data(), frame.size(), msg, false);
+        if (msg.is_discarded()) {
+            continue;
+        }
+        codec->encode(msg, data);
+        total += data.size();
+    }
+    return total;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    std::size_t capacity = 16 * 1024;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--size" && i + 1 < argc) {
+            capacity = static_cast<std::size_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    if (paths.size() < 2 || capacity == 0) {
+        printUsage();
+        return 2;
+    }
+    std::vector<std::string> frames;
+    std::size_t bytes = 0;
+    MessageFormat format = MessageFormat::JSON;
+    for (std::size_t i = 1; i < paths.size(); ++i) {
+        WireCaptureReader reader;
+        if (!reader.open(paths[i])) {
+            std::cerr << "can not read capture file " << paths[i] << "\n";
+            return 1;
+        }
+        CapturedFrame frame;
+        while (reader.next(frame)) {
+            frames.emplace_back(frame.data, frame.size);
+            bytes += frame.size;
+            format = frame.format;
+        }
+    }
+    const auto dictionary = CompressedCodec::trainDictionary(frames, capacity);
+    if (dictionary.empty()) {
+        std::cerr << "training failed, " << frames.size() << " frames may be too few\n";
+        return 1;
+    }
+    std::ofstream out(paths[0], std::ios::binary);
+    out.write(dictionary.data(), static_cast<std::streamsize>(dictionary.size()));
+    if (!out) {
+        std::cerr << "can not write dictionary file " << paths[0] << "\n";
+        return 1;
+    }
+    std::cout << "frames: " << frames.size() << ", " << bytes << " bytes\n";
+    std::cout << "dictionary: " << paths[0] << ", " << dictionary.size() << " bytes, id " << CompressedCodec::dictionaryId(dictionary) << "\n";
+    CompressionOptions options;
+    options.algorithm = Compression::Zstd;
+    options.threshold = 0;
+    const auto withoutDictionary = CompressedCodec::create(IMessageCodec::create(format), options);
+    options.dictionary = dictionary;
+    const auto withDictionary = CompressedCodec::create(IMessageCodec::create(format), options);
+    std::cout << "zstd without dictionary: " << compressedSize(frames, withoutDictionary, format) << " bytes\n";
+    std::cout << "zstd with dictionary: " << compressedSize(frames, withDictionary, format) << " bytes\n";
+    return 0;
+}